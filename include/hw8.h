@@ -1,10 +1,112 @@
 #pragma once
 
+#include "./hw8/WorkloadProfile.h"
+
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 struct HW8TransactionRecord {
     char const *name;
     char const *filePath;
 };
 
+// The options of hw8WithOptions. Each mode's incompatibilities with the others are checked by hw8WithOptions.
+struct HW8Options {
+    // Process each transaction record in a separate child process instead of a thread; see runTransactionProcesses
+    bool multiProcess;
+
+    // The page pool is resized while the threads run if a page fault rate watermark or a page control FIFO is given
+    size_t minPageCount;
+    size_t maxPageCount;
+    unsigned int pagePressureIntervalMs;
+    size_t pageFaultsPerIntervalHigh;
+    size_t pageFaultsPerIntervalLow;
+    size_t pageResizeStep;
+    char const *pageControlFifoPath;
+
+    // Spread the transaction records across this many simulated memory nodes (none if 0), each with its own page pool,
+    // which borrow frames from each other over Unix domain sockets instead of being resized
+    size_t nodeCount;
+    char const *nodeSocketDirectoryPath;
+    size_t nodeBorrowBatchSize;
+
+    // Draw from random streams derived from the seed and run the transaction sections one at a time in virtual time, so
+    // that two runs with the same seed print the same output
+    bool deterministic;
+    uint64_t seed;
+
+    // Record histograms of page fault service time, lock wait and hold times and victim scan length in each thread,
+    // then merge and print them at exit, and write them as JSON to statsJsonPath if it is not null
+    bool collectStats;
+    char const *statsJsonPath;
+
+    // Validate and index every transaction record file up front on prevalidateThreadCount threads (one per online
+    // processor if 0), so a malformed file is reported before any balance is printed
+    bool prevalidate;
+    size_t prevalidateThreadCount;
+
+    // Process the transaction records with runSplitTransactionRecords on splitThreadCount threads (one per online
+    // processor if 0)
+    bool splitRecords;
+    size_t splitThreadCount;
+
+    // Follow the transaction record files as they are appended to, applying sections as soon as they arrive, until none
+    // has for followIdleTimeoutMs (forever if 0)
+    bool follow;
+    unsigned int followIdleTimeoutMs;
+
+    // Give each thread or process a helper thread which reads and sums its next section while the current one waits
+    bool prefetchSections;
+
+    // Read every regular transaction record file into memory up front in one batch through io_uring (or pread where
+    // io_uring is not available) instead of mapping it
+    bool batchReadFiles;
+
+    // Read and validate every transaction record once up front, on prevalidateThreadCount threads, into a store holding
+    // each record's amounts in one contiguous array, which each of the runCount runs sums its sections from
+    bool columnarStore;
+    size_t runCount;
+
+    // Hold only each section's delta in the store, cached next to each transaction record file at its path plus
+    // .hw8cache, so that a later run reads only the appended part of a file; this implies columnarStore
+    bool sectionCache;
+
+    // Scale the chance of a section needing an additional page by the thread's weight in this profile (see
+    // nextWorkloadProfileWeight), where a profile period is pageAccessProfilePeriodLength sections
+    enum WorkloadProfile pageAccessProfile;
+    size_t pageAccessProfilePeriodLength;
+
+    // Append every applied section to a write-ahead journal at journalPath if it is not null (see Journal), committing
+    // batches of up to journalMaxBatchSize entries (no limit if 0) within journalGroupCommitWindowUs
+    char const *journalPath;
+    unsigned int journalGroupCommitWindowUs;
+    size_t journalMaxBatchSize;
+
+    // Write a checkpoint to checkpointPath, if it is not null, every checkpointIntervalSectionCount applied sections
+    // (never if 0) and at the end (see writeCheckpoint); if resume is set, start from it and the journal entries after
+    // it
+    char const *checkpointPath;
+    size_t checkpointIntervalSectionCount;
+    bool resume;
+
+    // Process the transaction records with runLedgerTransactionRecords, keeping up to ledgerAccountCapacity account
+    // balances with ledgerStripeCount lock stripes, on ledgerThreadCount threads (one per online processor if 0)
+    bool ledger;
+    size_t ledgerAccountCapacity;
+    size_t ledgerStripeCount;
+    size_t ledgerThreadCount;
+
+    // The transaction records are binary transaction files (see convertTransactionFileToBinary), which a ledger cannot
+    // read since they hold no account IDs
+    bool binaryRecords;
+};
+
+struct HW8Options hw8DefaultOptions(void);
+
 void hw8(struct HW8TransactionRecord const *transactionRecords, size_t transactionRecordCount);
+void hw8WithOptions(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr
+);
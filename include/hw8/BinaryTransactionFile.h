@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../util/lists.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BINARY_TRANSACTION_FILE_MAGIC "HW8TXN\r\n"
+#define BINARY_TRANSACTION_FILE_MAGIC_LENGTH 8
+#define BINARY_TRANSACTION_FILE_VERSION 1
+
+enum BinaryTransactionEncoding {
+    BinaryTransactionEncoding_int64 = 1,
+    BinaryTransactionEncoding_varint = 2
+};
+
+/**
+ * How the amounts of a section of a varint binary transaction file are packed. See encodeVarintSection.
+ */
+enum VarintSectionPacking {
+    VarintSectionPacking_zigZag = 0,
+    VarintSectionPacking_delta = 1,
+    VarintSectionPacking_frameOfReference = 2
+};
+
+/**
+ * The header at the start of a binary transaction file. It is followed by sectionCount sections, encoded as given by
+ * the header. With the int64 encoding, each section is a uint64_t amount count followed by that many int64_t amounts
+ * in cents; every field is 8 bytes, so every field of a mapped file is 8-byte aligned. With the varint encoding, each
+ * section is a block written by encodeVarintSection. All integers are in host byte order.
+ */
+struct BinaryTransactionFileHeader {
+    char magic[BINARY_TRANSACTION_FILE_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t encoding;
+    uint64_t sectionCount;
+};
+
+/**
+ * A section block of a varint binary transaction file, as located by readVarintSectionHeader: its amount count and
+ * packing, and the offsets of its payload and of its end.
+ */
+struct VarintSection {
+    uint64_t amountCount;
+    enum VarintSectionPacking packing;
+    size_t payloadBegin;
+    size_t end;
+};
+
+void convertTransactionFileToBinary(
+    char const *textFilePath,
+    char const *binaryFilePath,
+    enum BinaryTransactionEncoding encoding
+);
+
+size_t varintSectionMaxLength(size_t amountCount);
+size_t encodeVarintSection(int64_t const *amountsCents, size_t amountCount, unsigned char *out);
+bool readVarintSectionHeader(char const *chars, size_t length, size_t position, struct VarintSection *sectionOutPtr);
+bool decodeVarintSection(
+    char const *chars,
+    struct VarintSection const *sectionPtr,
+    Int64List amountsCents,
+    int64_t *sectionDeltaCentsOutPtr
+);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "./PagePool.h"
+#include "../util/file.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHECKPOINT_MAGIC "HW8CHKPT"
+#define CHECKPOINT_MAGIC_LENGTH 8
+#define CHECKPOINT_VERSION 2
+
+/**
+ * The header at the start of a checkpoint file. It is followed by recordCount CheckpointRecordStates and pageCount
+ * CheckpointPageStates, so a mapped checkpoint can be used in place. The checksum is the hashBytes of everything after
+ * it. The run ID is shared with the run's journal (see JournalFileHeader). All integers are in host byte order.
+ */
+struct CheckpointHeader {
+    char magic[CHECKPOINT_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t checksum;
+    uint64_t runId;
+    uint64_t appliedSectionCount;
+    int64_t balanceCents;
+    uint64_t recordCount;
+    uint64_t pageCount;
+};
+
+/**
+ * How far a transaction record had been applied: the offset of its next section in the file, and that section's index.
+ */
+struct CheckpointRecordState {
+    uint64_t offset;
+    uint64_t sectionIndex;
+};
+
+/**
+ * A page frame: its owner's index (UINT64_MAX if it has none) and its R and M bits.
+ */
+struct CheckpointPageState {
+    uint64_t ownerIndex;
+    uint8_t referenced;
+    uint8_t modified;
+    uint8_t reserved[6];
+};
+
+/**
+ * A checkpoint file mapped into memory. See mapCheckpoint.
+ */
+struct MappedCheckpoint {
+    struct MappedFile file;
+    struct CheckpointHeader const *headerPtr;
+    struct CheckpointRecordState const *records;
+    struct CheckpointPageState const *pages;
+};
+
+void writeCheckpoint(
+    char const *filePath,
+    uint64_t runId,
+    uint64_t appliedSectionCount,
+    int64_t balanceCents,
+    struct CheckpointRecordState const *records,
+    size_t recordCount,
+    PagePool pagePool
+);
+
+bool mapCheckpoint(struct MappedCheckpoint *checkpointOutPtr, char const *filePath, size_t recordCount);
+void unmapCheckpoint(struct MappedCheckpoint *checkpointPtr);
+void restoreCheckpointPages(struct MappedCheckpoint const *checkpointPtr, PagePool pagePool);
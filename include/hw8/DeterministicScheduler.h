@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../util/callback.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+DECLARE_ACTION(DeterministicSchedulerTickAction, void *)
+
+struct DeterministicScheduler;
+typedef struct DeterministicScheduler * DeterministicScheduler;
+
+DeterministicScheduler DeterministicScheduler_create(
+    size_t threadCount,
+    uint64_t seed,
+    uint64_t tickNs,
+    DeterministicSchedulerTickAction tickAction,
+    void *tickActionArg
+);
+void DeterministicScheduler_destroy(DeterministicScheduler scheduler);
+
+void DeterministicScheduler_beginTurn(DeterministicScheduler scheduler, size_t threadIndex, uint64_t delayNs);
+void DeterministicScheduler_endTurn(DeterministicScheduler scheduler, size_t threadIndex);
+void DeterministicScheduler_finish(DeterministicScheduler scheduler, size_t threadIndex);
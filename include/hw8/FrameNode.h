@@ -0,0 +1,19 @@
+#pragma once
+
+#include "./PagePool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct FrameNode;
+typedef struct FrameNode * FrameNode;
+
+FrameNode FrameNode_start(size_t nodeIndex, PagePool pool, char const *socketDirectoryPath, size_t borrowBatchSize);
+void FrameNode_connectPeers(FrameNode const *nodes, size_t nodeCount);
+void FrameNode_stop(FrameNode node);
+
+PagePool FrameNode_pool(FrameNode node);
+
+bool FrameNode_access(FrameNode node, size_t ownerIndex, bool requireAdditionalPage, enum PageAccess access);
+
+void FrameNode_printStats(FrameNode node);
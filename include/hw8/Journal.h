@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JOURNAL_MAGIC "HW8JRNL\n"
+#define JOURNAL_MAGIC_LENGTH 8
+#define JOURNAL_VERSION 2
+
+/**
+ * The header at the start of a journal file. It is followed by one JournalEntry per applied section, in the order the
+ * sections were applied to the balance. The run ID is shared with the run's checkpoints, so a journal is never replayed
+ * on top of another run's checkpoint. All integers are in host byte order.
+ */
+struct JournalFileHeader {
+    char magic[JOURNAL_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t runId;
+};
+
+/**
+ * A section applied to the balance: which transaction record and section it was, the change it made and the balance
+ * after it.
+ */
+struct JournalEntry {
+    uint64_t transactionRecordIndex;
+    uint64_t sectionIndex;
+    int64_t deltaCents;
+    int64_t balanceCents;
+};
+
+struct JournalOptions {
+    unsigned int groupCommitWindowUs;
+    size_t maxBatchSize;
+    bool append;
+    uint64_t runId;
+};
+
+struct Journal;
+typedef struct Journal * Journal;
+
+Journal Journal_start(char const *filePath, struct JournalOptions const *optionsPtr);
+void Journal_stop(Journal journal);
+
+uint64_t Journal_append(Journal journal, struct JournalEntry const *entryPtr);
+void Journal_waitDurable(Journal journal, uint64_t sequenceNumber);
+
+void Journal_printStats(Journal journal, FILE *file);
+
+struct JournalEntry *readJournalEntries(
+    char const *filePath,
+    uint64_t runId,
+    uint64_t firstEntryIndex,
+    uint64_t *runIdOutPtr,
+    size_t *entryCountOutPtr
+);
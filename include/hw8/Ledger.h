@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../util/lists.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The stripes a section locks are gathered into one 64-bit mask
+#define LEDGER_MAX_STRIPE_COUNT 64
+
+struct Ledger;
+typedef struct Ledger * Ledger;
+
+Ledger Ledger_create(size_t accountCapacity, size_t stripeCount);
+void Ledger_destroy(Ledger ledger);
+
+void Ledger_apply(Ledger ledger, ConstUint64List accountIds, ConstInt64List deltasCents, Int64List balancesCents);
+int64_t Ledger_balance(Ledger ledger, uint64_t accountId);
+
+size_t Ledger_accountCount(Ledger ledger);
+void Ledger_balances(Ledger ledger, Uint64List accountIds, Int64List balancesCents);
+
+void Ledger_printStats(Ledger ledger, FILE *file);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "./PageStats.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PAGE_UNOWNED SIZE_MAX
+
+enum PageAccess {
+    PageAccess_none,
+    PageAccess_read,
+    PageAccess_write
+};
+
+/**
+ * The state of a page frame: its owner's index (PAGE_UNOWNED if it has none) and its R and M bits.
+ */
+struct PageState {
+    size_t ownerIndex;
+    bool referenced;
+    bool modified;
+};
+
+struct PagePool;
+typedef struct PagePool * PagePool;
+typedef struct PagePool const * ConstPagePool;
+
+PagePool PagePool_create(size_t unownedPageCount, size_t minPageCount, size_t maxPageCount);
+void PagePool_destroy(PagePool pool);
+
+size_t PagePool_addOwner(PagePool pool, char const *ownerName);
+void PagePool_setOwnerStats(PagePool pool, size_t ownerIndex, PageStats stats);
+
+bool PagePool_access(PagePool pool, size_t ownerIndex, bool requireAdditionalPage, enum PageAccess access);
+void PagePool_resetReferenced(PagePool pool);
+
+size_t PagePool_pageCount(PagePool pool);
+size_t PagePool_faultCount(PagePool pool);
+size_t PagePool_unownedPageCount(PagePool pool);
+size_t PagePool_ownedPageCount(PagePool pool, size_t ownerIndex);
+
+size_t PagePool_grow(PagePool pool, size_t count);
+size_t PagePool_shrink(PagePool pool, size_t count);
+size_t PagePool_shrinkUnowned(PagePool pool, size_t count);
+size_t PagePool_resize(PagePool pool, size_t targetPageCount);
+
+size_t PagePool_pageStates(PagePool pool, struct PageState *pageStatesOut, size_t capacity);
+void PagePool_restorePageStates(PagePool pool, struct PageState const *pageStates, size_t pageCount);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "./PagePool.h"
+
+#include <stdlib.h>
+
+struct PagePressureControllerOptions {
+    unsigned int intervalMs;
+    size_t faultsPerIntervalHigh;
+    size_t faultsPerIntervalLow;
+    size_t step;
+    char const *controlFifoPath;
+};
+
+struct PagePressureController;
+typedef struct PagePressureController * PagePressureController;
+
+PagePressureController PagePressureController_start(
+    PagePool pool,
+    struct PagePressureControllerOptions const *optionsPtr
+);
+void PagePressureController_stop(PagePressureController controller);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+enum PageStat {
+    PageStat_faultServiceNs,
+    PageStat_pagesMutexWaitNs,
+    PageStat_balanceMutexWaitNs,
+    PageStat_balanceMutexHoldNs,
+    PageStat_victimScanLength
+};
+
+struct PageStats;
+typedef struct PageStats * PageStats;
+typedef struct PageStats const * ConstPageStats;
+
+PageStats PageStats_create(void);
+void PageStats_destroy(PageStats stats);
+
+void PageStats_record(PageStats stats, enum PageStat stat, uint64_t value);
+void PageStats_merge(PageStats stats, ConstPageStats otherStats);
+
+void PageStats_print(ConstPageStats stats, FILE *file);
+void PageStats_writeJson(ConstPageStats stats, FILE *file);
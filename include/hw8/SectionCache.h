@@ -0,0 +1,22 @@
+#pragma once
+
+#include "./TransactionReader.h"
+#include "../util/lists.h"
+
+#define SECTION_CACHE_MAGIC "HW8SCACH"
+#define SECTION_CACHE_MAGIC_LENGTH 8
+#define SECTION_CACHE_VERSION 1
+#define SECTION_CACHE_FILE_SUFFIX ".hw8cache"
+
+enum SectionCacheResult {
+    SectionCacheResult_hit,
+    SectionCacheResult_appended,
+    SectionCacheResult_miss,
+    SectionCacheResult_uncached
+};
+
+enum SectionCacheResult readSectionDeltasCached(
+    TransactionReader reader,
+    char const *filePath,
+    Int64List sectionDeltasCents
+);
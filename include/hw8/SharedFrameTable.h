@@ -0,0 +1,24 @@
+#pragma once
+
+#include "./PagePool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct SharedFrameTable;
+typedef struct SharedFrameTable * SharedFrameTable;
+
+SharedFrameTable SharedFrameTable_create(size_t unownedFrameCount, size_t ownerCapacity);
+void SharedFrameTable_destroy(SharedFrameTable table);
+
+size_t SharedFrameTable_addOwner(SharedFrameTable table, char const *ownerName);
+
+bool SharedFrameTable_access(
+    SharedFrameTable table,
+    size_t ownerIndex,
+    bool requireAdditionalPage,
+    enum PageAccess access
+);
+void SharedFrameTable_resetReferenced(SharedFrameTable table);
+
+size_t SharedFrameTable_faultCount(SharedFrameTable table);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+enum TransactionToken {
+    TransactionToken_invalid,
+    TransactionToken_beginSection,
+    TransactionToken_endSection,
+    TransactionToken_transaction
+};
+
+enum TransactionToken lexTransactionLine(char const *chars, size_t length, int64_t *amountCentsOutPtr);
+
+// The account of a transaction line without an account ID
+#define DEFAULT_ACCOUNT_ID UINT64_C(0)
+#define MAX_ACCOUNT_ID (UINT64_MAX - 1)
+
+enum TransactionToken lexAccountTransactionLine(
+    char const *chars,
+    size_t length,
+    uint64_t *accountIdOutPtr,
+    int64_t *amountCentsOutPtr
+);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../util/lists.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct TransactionReader;
+typedef struct TransactionReader * TransactionReader;
+
+TransactionReader TransactionReader_open(char const *name, char const *filePath);
+TransactionReader TransactionReader_openContents(char const *name, char const *filePath, char *chars, size_t length);
+TransactionReader TransactionReader_openColumns(
+    char const *name,
+    char const *filePath,
+    int64_t const *amountsCents,
+    size_t const *sectionOffsets,
+    size_t sectionCount
+);
+TransactionReader TransactionReader_openFollowing(char const *name, char const *filePath, unsigned int idleTimeoutMs);
+void TransactionReader_close(TransactionReader reader);
+
+bool TransactionReader_isStreamPath(char const *filePath);
+
+char const *TransactionReader_contents(TransactionReader reader, size_t *lengthOutPtr);
+size_t TransactionReader_offset(TransactionReader reader);
+void TransactionReader_skipTo(TransactionReader reader, size_t offset, size_t sectionCount);
+
+void TransactionReader_index(TransactionReader reader);
+size_t TransactionReader_split(TransactionReader reader, size_t maxChunkCount, TransactionReader *chunksOut);
+void TransactionReader_startPrefetch(TransactionReader reader);
+bool TransactionReader_readSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+bool TransactionReader_readSectionAmounts(TransactionReader reader, Int64List amountsCents, int64_t *sectionDeltaCentsOutPtr);
+bool TransactionReader_readAccountSection(
+    TransactionReader reader,
+    Uint64List accountIds,
+    Int64List accountDeltasCents
+);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "./TransactionReader.h"
+#include "./SectionCache.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+struct TransactionStore;
+typedef struct TransactionStore * TransactionStore;
+
+TransactionStore TransactionStore_build(TransactionReader const *readers, size_t recordCount, size_t threadCount);
+TransactionStore TransactionStore_buildCached(
+    TransactionReader const *readers,
+    char const * const *filePaths,
+    size_t recordCount,
+    size_t threadCount,
+    enum SectionCacheResult *cacheResultsOutPtr
+);
+void TransactionStore_destroy(TransactionStore store);
+
+size_t TransactionStore_recordCount(TransactionStore store);
+size_t TransactionStore_sectionCount(TransactionStore store, size_t recordIndex);
+int64_t const *TransactionStore_amountsCents(TransactionStore store, size_t recordIndex);
+size_t const *TransactionStore_sectionOffsets(TransactionStore store, size_t recordIndex);
+
+TransactionReader TransactionStore_openReader(
+    TransactionStore store,
+    size_t recordIndex,
+    char const *name,
+    char const *filePath
+);
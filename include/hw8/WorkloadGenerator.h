@@ -0,0 +1,35 @@
+#pragma once
+
+#include "./WorkloadProfile.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+enum AmountDistribution {
+    AmountDistribution_uniform,
+    AmountDistribution_normal,
+    AmountDistribution_exponential
+};
+
+struct WorkloadOptions {
+    uint64_t seed;
+    size_t recordCount;
+    size_t sectionsPerRecord;
+    size_t transactionsPerSection;
+    enum AmountDistribution amountDistribution;
+    int64_t maxAmountCents;
+    enum WorkloadProfile volumeProfile;
+    size_t profilePeriodLength;
+    size_t accountCount;
+
+    char const *directoryPath;
+    bool writeText;
+    bool writeBinary;
+    size_t threadCount;
+};
+
+struct WorkloadOptions defaultWorkloadOptions(void);
+bool parseAmountDistribution(char const *name, enum AmountDistribution *distributionOutPtr);
+
+void generateWorkload(struct WorkloadOptions const *optionsPtr);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../util/random.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+enum WorkloadProfile {
+    WorkloadProfile_uniform,
+    WorkloadProfile_zipfian,
+    WorkloadProfile_bursty,
+    WorkloadProfile_diurnal,
+    WorkloadProfile_phaseChange
+};
+
+/**
+ * The position of one entity, such as a transaction record or a thread, in a workload profile. See
+ * nextWorkloadProfileWeight.
+ */
+struct WorkloadProfileCursor {
+    enum WorkloadProfile profile;
+    size_t entityIndex;
+    size_t entityCount;
+    size_t periodLength;
+    double harmonicNumber;
+    size_t step;
+    bool bursting;
+    struct RandomStream randomStream;
+};
+
+bool parseWorkloadProfile(char const *name, enum WorkloadProfile *profileOutPtr);
+char const *workloadProfileName(enum WorkloadProfile profile);
+
+void initializeWorkloadProfileCursor(
+    struct WorkloadProfileCursor *cursorPtr,
+    enum WorkloadProfile profile,
+    size_t entityIndex,
+    size_t entityCount,
+    size_t periodLength,
+    uint64_t seed
+);
+double nextWorkloadProfileWeight(struct WorkloadProfileCursor *cursorPtr);
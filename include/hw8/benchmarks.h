@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdlib.h>
+
+void benchmarkTransactionLexer(size_t lineCount);
+void benchmarkCentsParser(size_t amountCount);
+void benchmarkSectionSum(size_t amountCount);
+void benchmarkVarintDecode(size_t lineCount);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct Histogram;
+typedef struct Histogram * Histogram;
+typedef struct Histogram const * ConstHistogram;
+
+Histogram Histogram_create(void);
+void Histogram_destroy(Histogram histogram);
+
+void Histogram_record(Histogram histogram, uint64_t value);
+void Histogram_merge(Histogram histogram, ConstHistogram otherHistogram);
+
+uint64_t Histogram_count(ConstHistogram histogram);
+uint64_t Histogram_min(ConstHistogram histogram);
+uint64_t Histogram_max(ConstHistogram histogram);
+double Histogram_mean(ConstHistogram histogram);
+uint64_t Histogram_valueAtPermille(ConstHistogram histogram, unsigned int permille);
+
+void Histogram_writeJson(ConstHistogram histogram, FILE *file);
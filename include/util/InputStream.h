@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct InputStream;
+typedef struct InputStream * InputStream;
+
+InputStream InputStream_openFile(char const *filePath, bool follow, unsigned int followIdleTimeoutMs);
+InputStream InputStream_openFd(int fd, char const *description);
+void InputStream_close(InputStream stream);
+
+char const *InputStream_chars(InputStream stream);
+size_t InputStream_length(InputStream stream);
+
+bool InputStream_fill(InputStream stream);
+void InputStream_consume(InputStream stream, size_t count);
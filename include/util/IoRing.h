@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+/**
+ * A completed IoRing request.
+ */
+struct IoRingCompletion {
+    uint64_t userData;
+    int32_t result;
+};
+
+struct IoRing;
+typedef struct IoRing * IoRing;
+
+IoRing IoRing_create(unsigned int entryCount);
+void IoRing_destroy(IoRing ring);
+
+bool IoRing_registerFiles(IoRing ring, int const *fds, unsigned int fdCount);
+void IoRing_unregisterFiles(IoRing ring);
+bool IoRing_registerBuffers(IoRing ring, struct iovec const *buffers, unsigned int bufferCount);
+
+bool IoRing_prepareReadFixed(
+    IoRing ring,
+    unsigned int fileIndex,
+    unsigned int bufferIndex,
+    void *buffer,
+    unsigned int length,
+    uint64_t offset,
+    uint64_t userData
+);
+unsigned int IoRing_submitAndWait(IoRing ring, unsigned int waitCount);
+bool IoRing_popCompletion(IoRing ring, struct IoRingCompletion *completionOutPtr);
+
+uint64_t IoRing_enterCount(IoRing ring);
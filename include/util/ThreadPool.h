@@ -0,0 +1,17 @@
+#pragma once
+
+#include "./callback.h"
+
+#include <stdlib.h>
+
+DECLARE_ACTION(ThreadPoolTask, void *, size_t)
+
+struct ThreadPool;
+typedef struct ThreadPool * ThreadPool;
+
+ThreadPool ThreadPool_create(size_t threadCount);
+void ThreadPool_destroy(ThreadPool pool);
+
+size_t ThreadPool_threadCount(ThreadPool pool);
+
+void ThreadPool_run(ThreadPool pool, size_t taskCount, ThreadPoolTask task, void *taskArg);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Enough for "-92233720368547758.08" and a terminating character
+#define CENTS_STRING_CAPACITY 22
+
+/**
+ * Add two amounts of cents with wrapping two's complement arithmetic, the same as sumValidCentsLines and sumInt64s, so
+ * that a sum too large for 64 bits is defined and agrees between the serial, indexed and vectorized paths.
+ *
+ * @param augendCents The first amount.
+ * @param addendCents The amount to add to it.
+ *
+ * @returns The wrapped sum.
+ */
+#define ADD_CENTS(augendCents, addendCents) ((int64_t)((uint64_t)(augendCents) + (uint64_t)(addendCents)))
+
+bool parseCents(char const *chars, size_t length, int64_t *centsOutPtr);
+int64_t sumValidCentsLines(char const *chars, size_t length);
+size_t formatCents(int64_t cents, char *buffer);
@@ -1,9 +1,29 @@
 #pragma once
 
+#include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <stdio.h>
 
+/**
+ * A file mapped into memory for sequential reading. See safeMapFile.
+ */
+struct MappedFile {
+    void *mapping;
+    char const *chars;
+    size_t length;
+    size_t position;
+};
+
+/**
+ * A line within a MappedFile: a pointer into the mapping and the line's length, excluding the newline. The characters
+ * are not null-terminated.
+ */
+struct FileLine {
+    char const *chars;
+    size_t length;
+};
+
 FILE *safeFopen(char const *filePath, char const *modes, char const *callerDescription);
 
 unsigned int safeFprintf(
@@ -26,6 +46,10 @@ char *readFileLine(FILE *file);
 
 char *readAllFileText(char const *filePath);
 
+void safeMapFile(struct MappedFile *mappedFileOutPtr, char const *filePath, char const *callerDescription);
+void safeUnmapFile(struct MappedFile *mappedFilePtr, char const *callerDescription);
+bool readMappedFileLine(struct MappedFile *mappedFilePtr, struct FileLine *lineOutPtr);
+
 int safeFscanf(
     FILE *file,
     char const *callerDescription,
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The whole contents of a file read by readFilesBatched. The characters are not null-terminated.
+ */
+struct FileContents {
+    char *chars;
+    size_t length;
+};
+
+/**
+ * How readFilesBatched read the files.
+ */
+struct FileBatchStats {
+    bool usedIoRing;
+    uint64_t byteCount;
+    uint64_t systemCallCount;
+};
+
+void readFilesBatched(
+    char const * const *filePaths,
+    size_t fileCount,
+    struct FileContents *contentsOut,
+    struct FileBatchStats *statsOutPtr
+);
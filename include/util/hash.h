@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+uint64_t hashBytes(void const *bytes, size_t length);
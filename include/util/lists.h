@@ -2,5 +2,10 @@
 
 #include "./list.h"
 
+#include <stdint.h>
+
 DECLARE_LIST(CharList, char)
 DECLARE_LIST(StringList, char *)
+DECLARE_LIST(Int64List, int64_t)
+DECLARE_LIST(Uint64List, uint64_t)
+DECLARE_LIST(SizeList, size_t)
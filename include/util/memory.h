@@ -4,3 +4,6 @@
 
 void *safeMalloc(size_t size, char const *callerDescription);
 void *safeRealloc(void *memory, size_t newSize, char const *callerDescription);
+
+void *safeSharedMalloc(size_t size, char const *callerDescription);
+void safeSharedFree(void *memory, size_t size, char const *callerDescription);
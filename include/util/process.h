@@ -0,0 +1,6 @@
+#pragma once
+
+#include <sys/types.h>
+
+pid_t safeFork(char const *callerDescription);
+int safeWaitpid(pid_t processId, char const *callerDescription);
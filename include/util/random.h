@@ -1,5 +1,21 @@
 #pragma once
 
+#include <stdint.h>
+
 void initializeRandom(unsigned int seed);
 
 int randomInt(int minInclusive, int maxExclusive);
+
+/**
+ * An independent pseudo-random number sequence. Unlike randomInt, a stream's sequence depends only on its seed and
+ * stream index, so separate threads can each own a stream and draw from it in a reproducible order.
+ */
+struct RandomStream {
+    uint64_t state;
+};
+
+void initializeRandomStream(struct RandomStream *streamPtr, uint64_t seed, uint64_t streamIndex);
+
+uint64_t randomStreamNext(struct RandomStream *streamPtr);
+int randomStreamInt(struct RandomStream *streamPtr, int minInclusive, int maxExclusive);
+double randomStreamDouble(struct RandomStream *streamPtr);
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <stdlib.h>
+
+char const *findNewline(char const *chars, size_t length);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+int64_t sumInt64s(int64_t const *values, size_t count);
+int64_t sumInt64sScalar(int64_t const *values, size_t count);
+char const *sumInt64sKernelName(void);
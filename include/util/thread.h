@@ -2,6 +2,8 @@
 
 #include "./callback.h"
 
+#include <stdbool.h>
+#include <time.h>
 #include <pthread.h>
 
 DECLARE_FUNC(PthreadCreateStartRoutine, void *, void *)
@@ -19,7 +21,10 @@ void safeMutexInit(
     pthread_mutexattr_t const *attributes,
     char const *callerDescription
 );
+void safeProcessSharedMutexInit(pthread_mutex_t *mutexOutPtr, char const *callerDescription);
 void safeMutexLock(pthread_mutex_t *mutexPtr, char const *callerDescription);
+bool safeMutexTryLock(pthread_mutex_t *mutexPtr, char const *callerDescription);
+bool safeRobustMutexLock(pthread_mutex_t *mutexPtr, char const *callerDescription);
 void safeMutexUnlock(pthread_mutex_t *mutexPtr, char const *callerDescription);
 void safeMutexDestroy(pthread_mutex_t *mutexPtr, char const *callerDescription);
 
@@ -29,9 +34,16 @@ void safeConditionInit(
     char const *callerDescription
 );
 void safeConditionSignal(pthread_cond_t *conditionPtr, char const *callerDescription);
+void safeConditionBroadcast(pthread_cond_t *conditionPtr, char const *callerDescription);
 void safeConditionWait(
     pthread_cond_t *conditionPtr,
     pthread_mutex_t *mutexPtr,
     char const *callerDescription
 );
+bool safeConditionTimedWait(
+    pthread_cond_t *conditionPtr,
+    pthread_mutex_t *mutexPtr,
+    struct timespec const *absoluteTimeoutPtr,
+    char const *callerDescription
+);
 void safeConditionDestroy(pthread_cond_t *conditionPtr, char const *callerDescription);
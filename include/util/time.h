@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
 #include <time.h>
 
 time_t safeTime(char const *callerDescription);
+uint64_t safeMonotonicTimeNs(char const *callerDescription);
@@ -6,10 +6,33 @@
  */
 
 #include "../include/hw8.h"
+#include "../include/hw8/benchmarks.h"
+#include "../include/hw8/BinaryTransactionFile.h"
+#include "../include/hw8/WorkloadGenerator.h"
 
+#include "../include/util/memory.h"
+#include "../include/util/cents.h"
+#include "../include/util/error.h"
 #include "../include/util/macro.h"
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+
+// Options past the last free option character, which have no character of their own
+enum LongOnlyOption {
+    LongOnlyOption_ledgerCapacity = UCHAR_MAX + 1,
+    LongOnlyOption_ledgerThreads,
+    LongOnlyOption_generateAccounts
+};
+
+static size_t parseSizeArg(char const *arg, char const *optionName);
+static char **binaryFilePaths(struct HW8TransactionRecord const *transactionRecords, size_t transactionRecordCount);
+static void printUsage(char const *programName);
 
 int main(int const argc, char ** const argv) {
     static struct HW8TransactionRecord const transactionRecords[] = {
@@ -19,6 +42,422 @@ int main(int const argc, char ** const argv) {
         {.name = "Casper", .filePath = "Casper.in"},
         {.name = "Gomez", .filePath = "Gomez.in"}
     };
-    hw8(transactionRecords, ARRAY_LENGTH(transactionRecords));
+
+    static struct option const longOptions[] = {
+        {"processes", no_argument, NULL, 'p'},
+        {"min-pages", required_argument, NULL, 'm'},
+        {"max-pages", required_argument, NULL, 'M'},
+        {"page-pressure-interval-ms", required_argument, NULL, 'i'},
+        {"page-faults-high", required_argument, NULL, 'H'},
+        {"page-faults-low", required_argument, NULL, 'L'},
+        {"page-resize-step", required_argument, NULL, 's'},
+        {"page-control-fifo", required_argument, NULL, 'f'},
+        {"nodes", required_argument, NULL, 'n'},
+        {"node-socket-dir", required_argument, NULL, 'd'},
+        {"node-borrow-batch", required_argument, NULL, 'b'},
+        {"seed", required_argument, NULL, 'S'},
+        {"stats", no_argument, NULL, 't'},
+        {"stats-json", required_argument, NULL, 'j'},
+        {"benchmark-lexer", required_argument, NULL, 'B'},
+        {"benchmark-cents", required_argument, NULL, 'C'},
+        {"benchmark-sum", required_argument, NULL, 'A'},
+        {"benchmark-decode", required_argument, NULL, 'Y'},
+        {"prevalidate", no_argument, NULL, 'v'},
+        {"prevalidate-threads", required_argument, NULL, 'V'},
+        {"split", no_argument, NULL, 'x'},
+        {"split-threads", required_argument, NULL, 'X'},
+        {"follow", no_argument, NULL, 'F'},
+        {"follow-idle-timeout-ms", required_argument, NULL, 'I'},
+        {"prefetch", no_argument, NULL, 'P'},
+        {"io-uring", no_argument, NULL, 'u'},
+        {"columnar", no_argument, NULL, 'k'},
+        {"runs", required_argument, NULL, 'r'},
+        {"section-cache", no_argument, NULL, 'K'},
+        {"convert", no_argument, NULL, 'c'},
+        {"convert-compressed", no_argument, NULL, 'U'},
+        {"binary", no_argument, NULL, 'y'},
+        {"page-access-profile", required_argument, NULL, 'l'},
+        {"profile-period", required_argument, NULL, 'e'},
+        {"journal", required_argument, NULL, 'J'},
+        {"journal-window-us", required_argument, NULL, 'W'},
+        {"journal-batch", required_argument, NULL, 'G'},
+        {"checkpoint", required_argument, NULL, 'O'},
+        {"checkpoint-interval", required_argument, NULL, 'Q'},
+        {"resume", no_argument, NULL, 'R'},
+        {"ledger", no_argument, NULL, 'q'},
+        {"ledger-stripes", required_argument, NULL, 'Z'},
+        {"ledger-capacity", required_argument, NULL, LongOnlyOption_ledgerCapacity},
+        {"ledger-threads", required_argument, NULL, LongOnlyOption_ledgerThreads},
+        {"generate", required_argument, NULL, 'g'},
+        {"generate-records", required_argument, NULL, 'N'},
+        {"generate-sections", required_argument, NULL, 'E'},
+        {"generate-transactions", required_argument, NULL, 'T'},
+        {"generate-distribution", required_argument, NULL, 'D'},
+        {"generate-max-amount", required_argument, NULL, 'a'},
+        {"generate-format", required_argument, NULL, 'o'},
+        {"generate-threads", required_argument, NULL, 'w'},
+        {"generate-volume-profile", required_argument, NULL, 'z'},
+        {"generate-accounts", required_argument, NULL, LongOnlyOption_generateAccounts},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    struct HW8Options options = hw8DefaultOptions();
+    struct WorkloadOptions workloadOptions = defaultWorkloadOptions();
+    bool generate = false;
+    bool convert = false;
+    enum BinaryTransactionEncoding convertEncoding = BinaryTransactionEncoding_int64;
+    struct HW8TransactionRecord const *records = transactionRecords;
+    while (true) {
+        int const option = getopt_long(argc, argv, "h", longOptions, NULL);
+        if (option == -1) {
+            break;
+        }
+
+        switch (option) {
+            case 'p': options.multiProcess = true; break;
+            case 'm': options.minPageCount = parseSizeArg(optarg, "--min-pages"); break;
+            case 'M': options.maxPageCount = parseSizeArg(optarg, "--max-pages"); break;
+            case 'i': options.pagePressureIntervalMs = (unsigned int)parseSizeArg(optarg, "--page-pressure-interval-ms"); break;
+            case 'H': options.pageFaultsPerIntervalHigh = parseSizeArg(optarg, "--page-faults-high"); break;
+            case 'L': options.pageFaultsPerIntervalLow = parseSizeArg(optarg, "--page-faults-low"); break;
+            case 's': options.pageResizeStep = parseSizeArg(optarg, "--page-resize-step"); break;
+            case 'f': options.pageControlFifoPath = optarg; break;
+            case 'n': options.nodeCount = parseSizeArg(optarg, "--nodes"); break;
+            case 'd': options.nodeSocketDirectoryPath = optarg; break;
+            case 'b': options.nodeBorrowBatchSize = parseSizeArg(optarg, "--node-borrow-batch"); break;
+            case 'S': {
+                options.deterministic = true;
+                options.seed = parseSizeArg(optarg, "--seed");
+                break;
+            }
+            case 't': options.collectStats = true; break;
+            case 'j': {
+                options.collectStats = true;
+                options.statsJsonPath = optarg;
+                break;
+            }
+            case 'v': options.prevalidate = true; break;
+            case 'V': {
+                options.prevalidate = true;
+                options.prevalidateThreadCount = parseSizeArg(optarg, "--prevalidate-threads");
+                break;
+            }
+            case 'x': options.splitRecords = true; break;
+            case 'X': {
+                options.splitRecords = true;
+                options.splitThreadCount = parseSizeArg(optarg, "--split-threads");
+                break;
+            }
+            case 'F': options.follow = true; break;
+            case 'I': {
+                options.follow = true;
+                options.followIdleTimeoutMs = (unsigned int)parseSizeArg(optarg, "--follow-idle-timeout-ms");
+                break;
+            }
+            case 'P': options.prefetchSections = true; break;
+            case 'u': options.batchReadFiles = true; break;
+            case 'k': options.columnarStore = true; break;
+            case 'r': options.runCount = parseSizeArg(optarg, "--runs"); break;
+            case 'K': options.sectionCache = true; break;
+            case 'B': {
+                benchmarkTransactionLexer(parseSizeArg(optarg, "--benchmark-lexer"));
+                return EXIT_SUCCESS;
+            }
+            case 'C': {
+                benchmarkCentsParser(parseSizeArg(optarg, "--benchmark-cents"));
+                return EXIT_SUCCESS;
+            }
+            case 'A': {
+                benchmarkSectionSum(parseSizeArg(optarg, "--benchmark-sum"));
+                return EXIT_SUCCESS;
+            }
+            case 'Y': {
+                benchmarkVarintDecode(parseSizeArg(optarg, "--benchmark-decode"));
+                return EXIT_SUCCESS;
+            }
+            case 'c':
+            case 'U': {
+                convert = true;
+                convertEncoding = option == 'U' ? BinaryTransactionEncoding_varint : BinaryTransactionEncoding_int64;
+                break;
+            }
+            case 'y': options.binaryRecords = true; break;
+            case 'l': {
+                if (!parseWorkloadProfile(optarg, &options.pageAccessProfile)) {
+                    abortWithErrorFmt(
+                        "--page-access-profile: Expected uniform, zipfian, bursty, diurnal or phase-change (actual: \"%s\")",
+                        optarg
+                    );
+                }
+                break;
+            }
+            case 'e': {
+                size_t const profilePeriodLength = parseSizeArg(optarg, "--profile-period");
+                options.pageAccessProfilePeriodLength = profilePeriodLength;
+                workloadOptions.profilePeriodLength = profilePeriodLength;
+                break;
+            }
+            case 'J': options.journalPath = optarg; break;
+            case 'W': {
+                options.journalGroupCommitWindowUs = (unsigned int)parseSizeArg(optarg, "--journal-window-us");
+                break;
+            }
+            case 'G': options.journalMaxBatchSize = parseSizeArg(optarg, "--journal-batch"); break;
+            case 'O': options.checkpointPath = optarg; break;
+            case 'Q': options.checkpointIntervalSectionCount = parseSizeArg(optarg, "--checkpoint-interval"); break;
+            case 'R': options.resume = true; break;
+            case 'q': options.ledger = true; break;
+            case 'Z': {
+                options.ledger = true;
+                options.ledgerStripeCount = parseSizeArg(optarg, "--ledger-stripes");
+                break;
+            }
+            case LongOnlyOption_ledgerCapacity: {
+                options.ledger = true;
+                options.ledgerAccountCapacity = parseSizeArg(optarg, "--ledger-capacity");
+                break;
+            }
+            case LongOnlyOption_ledgerThreads: {
+                options.ledger = true;
+                options.ledgerThreadCount = parseSizeArg(optarg, "--ledger-threads");
+                break;
+            }
+            case 'g': {
+                generate = true;
+                workloadOptions.directoryPath = optarg;
+                break;
+            }
+            case 'N': workloadOptions.recordCount = parseSizeArg(optarg, "--generate-records"); break;
+            case 'E': workloadOptions.sectionsPerRecord = parseSizeArg(optarg, "--generate-sections"); break;
+            case 'T': workloadOptions.transactionsPerSection = parseSizeArg(optarg, "--generate-transactions"); break;
+            case 'D': {
+                if (!parseAmountDistribution(optarg, &workloadOptions.amountDistribution)) {
+                    abortWithErrorFmt(
+                        "--generate-distribution: Expected uniform, normal or exponential (actual: \"%s\")",
+                        optarg
+                    );
+                }
+                break;
+            }
+            case 'a': {
+                int64_t maxAmountCents;
+                if (!parseCents(optarg, strlen(optarg), &maxAmountCents) || maxAmountCents <= 0) {
+                    abortWithErrorFmt("--generate-max-amount: Expected a positive amount (actual: \"%s\")", optarg);
+                }
+                workloadOptions.maxAmountCents = maxAmountCents;
+                break;
+            }
+            case 'o': {
+                workloadOptions.writeText = strcmp(optarg, "text") == 0 || strcmp(optarg, "both") == 0;
+                workloadOptions.writeBinary = strcmp(optarg, "binary") == 0 || strcmp(optarg, "both") == 0;
+                if (!workloadOptions.writeText && !workloadOptions.writeBinary) {
+                    abortWithErrorFmt("--generate-format: Expected text, binary or both (actual: \"%s\")", optarg);
+                }
+                break;
+            }
+            case 'w': workloadOptions.threadCount = parseSizeArg(optarg, "--generate-threads"); break;
+            case LongOnlyOption_generateAccounts: {
+                workloadOptions.accountCount = parseSizeArg(optarg, "--generate-accounts");
+                break;
+            }
+            case 'z': {
+                if (!parseWorkloadProfile(optarg, &workloadOptions.volumeProfile)) {
+                    abortWithErrorFmt(
+                        "--generate-volume-profile: Expected uniform, zipfian, bursty, diurnal or phase-change (actual: \"%s\")",
+                        optarg
+                    );
+                }
+                break;
+            }
+            case 'h': {
+                printUsage(argv[0]);
+                return EXIT_SUCCESS;
+            }
+            default: {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (generate) {
+        workloadOptions.seed = options.seed;
+        generateWorkload(&workloadOptions);
+        return EXIT_SUCCESS;
+    }
+
+    // Records given as NAME=PATH arguments replace the default ones
+    size_t recordCount = ARRAY_LENGTH(transactionRecords);
+    struct HW8TransactionRecord *argRecords = NULL;
+    if (optind < argc) {
+        recordCount = (size_t)(argc - optind);
+        argRecords = safeMalloc(sizeof *argRecords * recordCount, "main");
+        for (size_t i = 0; i < recordCount; i += 1) {
+            char * const arg = argv[optind + (int)i];
+            char * const separator = strchr(arg, '=');
+            if (separator == NULL || separator == arg || separator[1] == '\0') {
+                abortWithErrorFmt("Expected a transaction record as NAME=PATH (actual: \"%s\")", arg);
+            }
+            *separator = '\0';
+            argRecords[i] = (struct HW8TransactionRecord){.name = arg, .filePath = separator + 1};
+        }
+        records = argRecords;
+    }
+
+    // Converting and reading binary records both use each record's path with a .bin extension
+    char ** const binaryPaths = convert || options.binaryRecords ? binaryFilePaths(records, recordCount) : NULL;
+    if (convert) {
+        for (size_t i = 0; i < recordCount; i += 1) {
+            convertTransactionFileToBinary(records[i].filePath, binaryPaths[i], convertEncoding);
+        }
+    } else if (binaryPaths != NULL) {
+        struct HW8TransactionRecord * const binaryRecords = safeMalloc(sizeof *binaryRecords * recordCount, "main");
+        for (size_t i = 0; i < recordCount; i += 1) {
+            binaryRecords[i] = (struct HW8TransactionRecord){.name = records[i].name, .filePath = binaryPaths[i]};
+        }
+        hw8WithOptions(binaryRecords, recordCount, &options);
+        free(binaryRecords);
+    } else {
+        hw8WithOptions(records, recordCount, &options);
+    }
+
+    if (binaryPaths != NULL) {
+        for (size_t i = 0; i < recordCount; i += 1) {
+            free(binaryPaths[i]);
+        }
+        free(binaryPaths);
+    }
+    free(argRecords);
     return EXIT_SUCCESS;
 }
+
+static size_t parseSizeArg(char const * const arg, char const * const optionName) {
+    char *argEnd;
+    errno = 0;
+    unsigned long long const value = strtoull(arg, &argEnd, 10);
+    if (errno != 0 || argEnd == arg || *argEnd != '\0' || arg[0] == '-') {
+        abortWithErrorFmt("%s: Expected a non-negative integer (actual: \"%s\")", optionName, arg);
+    }
+    return (size_t)value;
+}
+
+/**
+ * Get the path of the binary transaction file for each of the given text transaction records: its path with the
+ * extension replaced by .bin, or with .bin appended if it has none.
+ *
+ * @param transactionRecords The text transaction records. Their paths must be files, not streams.
+ * @param transactionRecordCount The number of transaction records.
+ *
+ * @returns The newly allocated paths. The caller is responsible for freeing each path and the array.
+ */
+static char **binaryFilePaths(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount
+) {
+    char ** const binaryPaths = safeMalloc(sizeof *binaryPaths * transactionRecordCount, "binaryFilePaths");
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        char const * const filePath = transactionRecords[i].filePath;
+        if (strcmp(filePath, "-") == 0 || strncmp(filePath, "fd:", 3) == 0) {
+            abortWithErrorFmt(
+                "--convert and --binary: Transaction record %s is read from a stream, not a file (path: \"%s\")",
+                transactionRecords[i].name,
+                filePath
+            );
+        }
+
+        char const * const lastSlash = strrchr(filePath, '/');
+        char const * const baseName = lastSlash != NULL ? lastSlash + 1 : filePath;
+        char const * const extension = strrchr(baseName, '.');
+        size_t const stemLength = (
+            extension != NULL && extension != baseName ? (size_t)(extension - filePath) : strlen(filePath)
+        );
+        binaryPaths[i] = safeMalloc(stemLength + sizeof ".bin", "binaryFilePaths");
+        memcpy(binaryPaths[i], filePath, stemLength);
+        strcpy(binaryPaths[i] + stemLength, ".bin");
+    }
+    return binaryPaths;
+}
+
+static void printUsage(char const * const programName) {
+    printf(
+        "Usage: %s [options] [NAME=PATH...]\n"
+        "\n"
+        "Each NAME=PATH processes the transaction record NAME from PATH, instead of Vlad.in, Frank.in, Bigfoot.in,\n"
+        "Casper.in and Gomez.in. PATH may be - for standard input, fd:N for inherited file descriptor N, or a FIFO.\n"
+        "\n"
+        "Options:\n"
+        "    --processes                    process each transaction record in a separate child process\n"
+        "    --min-pages N                  never shrink the page pool below N pages (default: 1)\n"
+        "    --max-pages N                  never grow the page pool above N pages (default: unlimited)\n"
+        "    --page-pressure-interval-ms N  sample the page fault rate every N ms (default: 1000)\n"
+        "    --page-faults-high N           grow the page pool when an interval has at least N faults\n"
+        "    --page-faults-low N            shrink the page pool when an interval has at most N faults\n"
+        "    --page-resize-step N           number of pages to grow or shrink by at a time (default: 1)\n"
+        "    --page-control-fifo PATH       accept \"grow N\", \"shrink N\" and \"resize N\" commands on a FIFO\n"
+        "    --nodes N                      spread the records across N memory nodes which lend each other frames\n"
+        "    --node-socket-dir PATH         directory for the nodes' Unix domain sockets (default: /tmp)\n"
+        "    --node-borrow-batch N          number of frames a node borrows from a peer at a time (default: 4)\n"
+        "    --seed N                       run deterministically: same seed, same output (no real delays)\n"
+        "    --stats                        print fault latency, lock wait and victim scan percentiles at exit\n"
+        "    --stats-json PATH              also write the stats histograms to PATH as JSON (implies --stats)\n"
+        "    --prevalidate                  validate and index every record file in parallel before any thread runs\n"
+        "    --prevalidate-threads N        validate on N threads (implies --prevalidate; default: one per CPU)\n"
+        "    --split                        process the records in order, summing chunks of each file in parallel\n"
+        "    --split-threads N              sum the chunks on N threads (implies --split; default: one per CPU)\n"
+        "    --follow                       keep reading the record files as they grow, applying sections on arrival\n"
+        "    --follow-idle-timeout-ms N     stop following a file after N ms without growth (implies --follow)\n"
+        "    --prefetch                     read each record's next section on a helper thread during the current one\n"
+        "    --io-uring                     read all record files up front in one io_uring batch instead of mapping\n"
+        "    --columnar                     parse every record once into in-memory columns and run from those\n"
+        "    --runs N                       process the records N times in a row (default: 1)\n"
+        "    --section-cache                cache section sums in PATH.hw8cache; only re-read changed files\n"
+        "    --benchmark-lexer N            compare the transaction lexer to the regex parser on N lines, then exit\n"
+        "    --benchmark-cents N            compare the cents parser to strtof on about N amounts, then exit\n"
+        "    --benchmark-sum N              compare the SIMD and scalar sums of a section of N amounts, then exit\n"
+        "    --benchmark-decode N           compare varint decoding to the lexer on about N lines, then exit\n"
+        "    --convert                      convert each record's PATH to the binary transaction format at PATH with\n"
+        "                                   a .bin extension, then exit\n"
+        "    --convert-compressed           like --convert, but compress the amounts into zig-zag varint blocks\n"
+        "    --binary                       read each record from PATH with a .bin extension, made by --convert\n"
+        "    --page-access-profile NAME     scale each thread's page fault chance by a workload profile: uniform,\n"
+        "                                   zipfian, bursty, diurnal or phase-change (default: uniform)\n"
+        "    --profile-period N             sections per day, phase or burst of a profile (default: 8; generator:\n"
+        "                                   a quarter of the sections per record)\n"
+        "    -h, --help                     print this help\n",
+        programName
+    );
+    printf(
+        "\n"
+        "Durability options:\n"
+        "    --journal PATH                 journal each applied section to PATH, committing in batches\n"
+        "    --journal-window-us N          wait up to N us for more entries before each commit (default: 1000)\n"
+        "    --journal-batch N              commit as soon as N entries are waiting (default: no limit)\n"
+        "    --checkpoint PATH              snapshot the balance, record offsets and page frames to PATH\n"
+        "    --checkpoint-interval N        snapshot every N applied sections, and at the end (default: 16)\n"
+        "    --resume                       start from the checkpoint and the journal entries after it\n"
+    );
+    printf(
+        "\n"
+        "Ledger options:\n"
+        "    --ledger                       keep a balance per account, from lines like ID:AMOUNT (default: ID 0),\n"
+        "                                   applying the records in parallel without delays or page accesses\n"
+        "    --ledger-stripes N             lock the accounts in N stripes, up to 64 (implies --ledger; default: 64)\n"
+        "    --ledger-capacity N            hold up to N accounts (implies --ledger; default: 65536)\n"
+        "    --ledger-threads N             apply the records on N threads (implies --ledger; default: one per CPU)\n"
+    );
+    printf(
+        "\n"
+        "Generator options:\n"
+        "    --generate DIR                 write generated records to DIR/recordN.in (seeded by --seed), then exit\n"
+        "    --generate-records N           number of records to generate (default: 5)\n"
+        "    --generate-sections N          number of sections per generated record (default: 8)\n"
+        "    --generate-transactions N      number of transactions per generated section (default: 4)\n"
+        "    --generate-distribution NAME   uniform, normal or exponential amounts (default: uniform)\n"
+        "    --generate-max-amount AMOUNT   largest generated amount in dollars, like 500.00 (default: 500.00)\n"
+        "    --generate-format FORMAT       text (recordN.in), binary (recordN.bin) or both (default: text)\n"
+        "    --generate-threads N           generate files on N threads (default: one per CPU)\n"
+        "    --generate-volume-profile NAME scale transactions per section by a workload profile (default: uniform)\n"
+        "    --generate-accounts N          give each section an account ID from 1 to N (text only; default: none)\n"
+    );
+}
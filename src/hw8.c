@@ -1,190 +1,680 @@
 #include "../include/hw8.h"
 
-#include "../include/util/list.h"
+#include "../include/hw8/PagePool.h"
+#include "../include/hw8/PagePressureController.h"
+#include "../include/hw8/SharedFrameTable.h"
+#include "../include/hw8/FrameNode.h"
+#include "../include/hw8/DeterministicScheduler.h"
+#include "../include/hw8/PageStats.h"
+#include "../include/hw8/TransactionReader.h"
+#include "../include/hw8/TransactionStore.h"
+#include "../include/hw8/WorkloadProfile.h"
+#include "../include/hw8/Journal.h"
+#include "../include/hw8/Checkpoint.h"
+#include "../include/hw8/Ledger.h"
 #include "../include/util/memory.h"
+#include "../include/util/ThreadPool.h"
+#include "../include/util/lists.h"
 #include "../include/util/thread.h"
+#include "../include/util/process.h"
+#include "../include/util/time.h"
+#include "../include/util/cents.h"
 #include "../include/util/file.h"
+#include "../include/util/fileBatch.h"
 #include "../include/util/random.h"
+#include "../include/util/hash.h"
 #include "../include/util/guard.h"
 #include "../include/util/error.h"
-#include "../include/util/regex.h"
 #include "../include/util/macro.h"
 
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <stdio.h>
-#include <regex.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
-static bool initialized = false;
-static regex_t beginTransactionSectionRegex;
-static regex_t transactionRegex;
-static regex_t endTransactionSectionRegex;
-
-static void ensureInitialized(void);
-
-struct Page {
-    char const *owner;
-    bool referenced;
-    bool modified;
+/**
+ * How far a run of transaction threads has got. It is only changed under the balance lock, so a checkpoint written
+ * under the lock is consistent with the balance and the page frames.
+ */
+struct RunProgress {
+    uint64_t runId;
+    char const *checkpointPath;
+    size_t checkpointIntervalSectionCount;
+    uint64_t appliedSectionCount;
+    struct CheckpointRecordState *records;
+    size_t recordCount;
+    PagePool pagePool;
 };
-DEFINE_CIRCULAR_LINKED_LIST(Pages, struct Page)
-DEFINE_LIST(PageNodeList, PagesNode)
 
 struct ProcessTransactionsThreadStartArg {
     struct HW8TransactionRecord const *transactionRecordPtr;
+    size_t transactionRecordIndex;
+    TransactionReader transactionReader;
+    bool prefetchSections;
+    bool simulateDelays;
 
-    float *balancePtr;
+    int64_t *balanceCentsPtr;
     pthread_mutex_t *balanceMutexPtr;
+    PageStats stats;
+
+    PagePool pagePool;
+    SharedFrameTable sharedFrameTable;
+    FrameNode frameNode;
+    size_t pageOwnerIndex;
+
+    DeterministicScheduler scheduler;
+    size_t schedulerThreadIndex;
+    struct RandomStream randomStream;
 
-    Pages pages;
-    PagesNode initialOwnedPageNode;
-    pthread_mutex_t *pagesMutexPtr;
+    struct WorkloadProfileCursor pageAccessCursor;
+
+    Journal journal;
+    struct RunProgress *runProgressPtr;
+    uint64_t firstSectionIndex;
 };
 static void *processTransactionsThreadStart(void *argAsVoidPtr);
+static int threadRandomInt(struct ProcessTransactionsThreadStartArg *argPtr, int minInclusive, int maxExclusive);
+static bool threadRequiresAdditionalPage(struct ProcessTransactionsThreadStartArg *argPtr);
+static uint64_t lockBalance(struct ProcessTransactionsThreadStartArg const *argPtr);
+static void unlockBalance(struct ProcessTransactionsThreadStartArg const *argPtr, uint64_t lockedTimeNs);
+static void recordSectionApplied(
+    struct ProcessTransactionsThreadStartArg const *argPtr,
+    size_t sectionEndOffset,
+    uint64_t sectionIndex,
+    int64_t balanceCents,
+    uint64_t journalSequenceNumber
+);
+static void runTransactionThreads(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr,
+    TransactionStore transactionStore
+);
+static TransactionStore buildTransactionStore(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr
+);
+static TransactionReader *openTransactionReaders(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr,
+    TransactionStore transactionStore
+);
+static void batchReadTransactionFiles(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    TransactionReader *transactionReaders,
+    struct HW8Options const *optionsPtr
+);
+static void indexTransactionReader(void *transactionReadersAsVoidPtr, size_t transactionRecordIndex);
+static void closeTransactionReaders(TransactionReader *transactionReaders, size_t transactionRecordCount);
+static void joinTransactionThreads(pthread_t const *threadIds, size_t transactionRecordCount);
+static void printFinalBalance(int64_t balanceCents);
+static int64_t resumeRun(
+    struct RunProgress *runProgressPtr,
+    TransactionReader const *transactionReaders,
+    struct HW8Options const *optionsPtr
+);
+static uint64_t newRunId(void);
+static void accessPages(
+    struct ProcessTransactionsThreadStartArg const *argPtr,
+    bool requireAdditionalPage,
+    enum PageAccess access
+);
 
 struct PeriodicallyResetPagesReferencedThreadStartArg {
-    Pages pages;
-    pthread_mutex_t *pagesMutexPtr;
+    PagePool const *pagePools;
+    size_t pagePoolCount;
+    SharedFrameTable sharedFrameTable;
 
     bool *stopPtr;
+    pthread_mutex_t *stopMutexPtr;
+    pthread_cond_t *stopConditionPtr;
 };
 static void *periodicallyResetPagesReferencedThreadStart(void *argAsVoidPtr);
+static void resetPagesReferenced(void *argAsVoidPtr);
+
+/**
+ * The chunks of a split transaction record file, and the section deltas summed from each.
+ */
+struct SumTransactionChunkArg {
+    TransactionReader const *chunkReaders;
+    Int64List *sectionDeltaCentsLists;
+};
+static void runSplitTransactionRecords(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr
+);
+static void sumTransactionChunk(void *argAsVoidPtr, size_t chunkIndex);
+
+/**
+ * The ledger, and the transaction records whose sections are applied to it, one record per task.
+ */
+struct ApplyLedgerRecordArg {
+    struct HW8TransactionRecord const *transactionRecords;
+    TransactionReader const *transactionReaders;
+    Ledger ledger;
+};
+static void runLedgerTransactionRecords(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr
+);
+static void applyLedgerRecord(void *argAsVoidPtr, size_t transactionRecordIndex);
+
+/**
+ * The account balance and its mutex, placed in shared memory when transaction records are processed by child processes.
+ */
+struct SharedBalance {
+    pthread_mutex_t mutex;
+    int64_t balanceCents;
+};
+static void runTransactionProcesses(
+    struct HW8TransactionRecord const *transactionRecords,
+    size_t transactionRecordCount,
+    struct HW8Options const *optionsPtr,
+    TransactionStore transactionStore
+);
+
+/**
+ * Get the default HW8 options. These run the assignment as specified: the page pool has one unowned page plus one page
+ * per transaction record and is never resized.
+ *
+ * @returns The default options.
+ */
+struct HW8Options hw8DefaultOptions(void) {
+    return (struct HW8Options){
+        .multiProcess = false,
+        .minPageCount = 1,
+        .maxPageCount = 0,
+        .pagePressureIntervalMs = 1000,
+        .pageFaultsPerIntervalHigh = 0,
+        .pageFaultsPerIntervalLow = 0,
+        .pageResizeStep = 1,
+        .pageControlFifoPath = NULL,
+        .nodeCount = 0,
+        .nodeSocketDirectoryPath = "/tmp",
+        .nodeBorrowBatchSize = 4,
+        .deterministic = false,
+        .seed = 0,
+        .collectStats = false,
+        .statsJsonPath = NULL,
+        .prevalidate = false,
+        .prevalidateThreadCount = 0,
+        .splitRecords = false,
+        .splitThreadCount = 0,
+        .follow = false,
+        .followIdleTimeoutMs = 0,
+        .prefetchSections = false,
+        .batchReadFiles = false,
+        .columnarStore = false,
+        .runCount = 1,
+        .sectionCache = false,
+        .pageAccessProfile = WorkloadProfile_uniform,
+        .pageAccessProfilePeriodLength = 8,
+        .journalPath = NULL,
+        .journalGroupCommitWindowUs = 1000,
+        .journalMaxBatchSize = 0,
+        .checkpointPath = NULL,
+        .checkpointIntervalSectionCount = 16,
+        .resume = false,
+        .ledger = false,
+        .ledgerAccountCapacity = 65536,
+        .ledgerStripeCount = 64,
+        .ledgerThreadCount = 0,
+        .binaryRecords = false
+    };
+}
+
+/**
+ * Run CSCI 451 HW8 with the default options. See hw8WithOptions.
+ *
+ * @param transactionRecords The transaction records to process.
+ * @param transactionRecordCount The number of transaction records.
+ */
+void hw8(struct HW8TransactionRecord const * const transactionRecords, size_t const transactionRecordCount) {
+    struct HW8Options const options = hw8DefaultOptions();
+    hw8WithOptions(transactionRecords, transactionRecordCount, &options);
+}
 
 /**
  * Run CSCI 451 HW8. This uses the given transaction records to model multithreaded deposit and withdrawal transactions
  * on an account balance. A separate thread is launched to process each transaction record. The threads will pause in
  * between each transaction section to simulate a random order of occurrence.
  *
- * @param transactionRecords The transaction records to process.
+ * @param transactionRecords The transaction records to process. A file path may also be "-" for standard input, "fd:N"
+ *                           for an inherited file descriptor, or a FIFO; these are read as streams and never mapped.
  * @param transactionRecordCount The number of transaction records.
+ * @param optionsPtr The options. See HW8Options. The transaction records are processed runCount times in a row.
  */
-void hw8(struct HW8TransactionRecord const * const transactionRecords, size_t const transactionRecordCount) {
-    ensureInitialized();
+void hw8WithOptions(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr
+) {
+    guardNotNull(transactionRecords, "transactionRecords", "hw8WithOptions");
+    guardNotNull(optionsPtr, "optionsPtr", "hw8WithOptions");
+
+    bool const resizePagePool = (
+        optionsPtr->pageFaultsPerIntervalHigh > 0 || optionsPtr->pageControlFifoPath != NULL
+    );
+    guard(
+        !optionsPtr->deterministic || (!optionsPtr->multiProcess && !resizePagePool),
+        "hw8WithOptions: Deterministic mode cannot be combined with multiProcess or page pool resizing"
+    );
+    guard(
+        optionsPtr->nodeCount == 0 || (!resizePagePool && optionsPtr->maxPageCount == 0),
+        "hw8WithOptions: Nodes cannot be combined with a maximum page count or page pool resizing; they only borrow frames"
+    );
+    guard(
+        !optionsPtr->collectStats || !optionsPtr->multiProcess,
+        "hw8WithOptions: Stats cannot be collected with multiProcess"
+    );
+    guard(
+        !optionsPtr->splitRecords || (!optionsPtr->multiProcess && optionsPtr->nodeCount == 0 && !optionsPtr->deterministic),
+        "hw8WithOptions: Split records cannot be combined with multiProcess, nodes or deterministic mode"
+    );
 
-    guardNotNull(transactionRecords, "transactionRecords", "hw8");
+    guard(
+        !optionsPtr->follow || (!optionsPtr->prevalidate && !optionsPtr->splitRecords && !optionsPtr->deterministic),
+        "hw8WithOptions: Follow mode cannot be combined with prevalidate, split records or deterministic mode"
+    );
 
-    float balance = 0;
+    guard(
+        !optionsPtr->batchReadFiles || !optionsPtr->follow,
+        "hw8WithOptions: Batch reading files cannot be combined with follow mode"
+    );
+
+    guard(
+        optionsPtr->journalPath == NULL || (!optionsPtr->multiProcess && !optionsPtr->splitRecords),
+        "hw8WithOptions: A journal cannot be combined with multiProcess or split records"
+    );
+
+    guard(optionsPtr->runCount > 0, "hw8WithOptions: runCount must be positive");
+    bool const useTransactionStore = optionsPtr->columnarStore || optionsPtr->sectionCache;
+    guard(
+        !useTransactionStore || (!optionsPtr->splitRecords && !optionsPtr->follow),
+        "hw8WithOptions: A columnar store or section cache cannot be combined with split records or follow mode"
+    );
+
+    bool const trackRunProgress = optionsPtr->checkpointPath != NULL || optionsPtr->resume;
+    guard(
+        !trackRunProgress || (
+            !optionsPtr->multiProcess
+            && !optionsPtr->splitRecords
+            && optionsPtr->nodeCount == 0
+            && !optionsPtr->follow
+            && !optionsPtr->prefetchSections
+            && !optionsPtr->prevalidate
+            && !useTransactionStore
+            && optionsPtr->runCount == 1
+        ),
+        (
+            "hw8WithOptions: Checkpoints and resuming cannot be combined with multiProcess, split records, nodes,"
+            " follow mode, prefetching, prevalidate, a columnar store or section cache, or more than one run"
+        )
+    );
+    guard(
+        !optionsPtr->resume || optionsPtr->checkpointPath != NULL || optionsPtr->journalPath != NULL,
+        "hw8WithOptions: Resuming needs a checkpoint or a journal"
+    );
+
+    guard(
+        !optionsPtr->ledger || (
+            !optionsPtr->multiProcess
+            && !optionsPtr->splitRecords
+            && optionsPtr->nodeCount == 0
+            && !optionsPtr->deterministic
+            && !optionsPtr->follow
+            && !optionsPtr->prefetchSections
+            && !optionsPtr->prevalidate
+            && !useTransactionStore
+            && optionsPtr->journalPath == NULL
+            && !trackRunProgress
+            && !optionsPtr->binaryRecords
+        ),
+        (
+            "hw8WithOptions: A ledger cannot be combined with multiProcess, split records, nodes, deterministic mode,"
+            " follow mode, prefetching, prevalidate, a columnar store or section cache, a journal, checkpoints or"
+            " binary transaction records"
+        )
+    );
+
+    TransactionStore const transactionStore = (
+        useTransactionStore
+            ? buildTransactionStore(transactionRecords, transactionRecordCount, optionsPtr)
+            : NULL
+    );
+
+    for (size_t i = 0; i < optionsPtr->runCount; i += 1) {
+        if (optionsPtr->ledger) {
+            runLedgerTransactionRecords(transactionRecords, transactionRecordCount, optionsPtr);
+        } else if (optionsPtr->splitRecords) {
+            runSplitTransactionRecords(transactionRecords, transactionRecordCount, optionsPtr);
+        } else if (optionsPtr->multiProcess) {
+            runTransactionProcesses(transactionRecords, transactionRecordCount, optionsPtr, transactionStore);
+        } else {
+            runTransactionThreads(transactionRecords, transactionRecordCount, optionsPtr, transactionStore);
+        }
+    }
+
+    if (transactionStore != NULL) {
+        TransactionStore_destroy(transactionStore);
+    }
+}
+
+/**
+ * Process the transaction records once, each by a separate thread. Each thread needs an additional page, faulting, for
+ * a quarter of its sections on average, scaled by its weight in the page access profile. If a journal is kept, a
+ * thread does not go on to its next section until its entry is durable. If resuming, the run starts from the
+ * checkpoint and then the journal entries after it: only the sections in those entries are read again, each checked
+ * against its entry, and their page accesses are not replayed.
+ *
+ * @param transactionRecords The transaction records to process.
+ * @param transactionRecordCount The number of transaction records.
+ * @param optionsPtr The options.
+ * @param transactionStore The store to read the transaction sections from, or null to read the files.
+ */
+static void runTransactionThreads(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr,
+    TransactionStore const transactionStore
+) {
+    TransactionReader * const transactionReaders = openTransactionReaders(
+        transactionRecords,
+        transactionRecordCount,
+        optionsPtr,
+        transactionStore
+    );
+
+    int64_t balanceCents = 0;
     pthread_mutex_t balanceMutex;
-    safeMutexInit(&balanceMutex, NULL, "hw8");
+    safeMutexInit(&balanceMutex, NULL, "hw8 runTransactionThreads");
+
+    size_t const pagePoolCount = optionsPtr->nodeCount > 0 ? optionsPtr->nodeCount : 1;
+    PagePool * const pagePools = safeMalloc(sizeof *pagePools * pagePoolCount, "hw8 runTransactionThreads");
+    FrameNode * const frameNodes = safeMalloc(sizeof *frameNodes * pagePoolCount, "hw8 runTransactionThreads");
+    for (size_t i = 0; i < pagePoolCount; i += 1) {
+        if (optionsPtr->nodeCount == 0) {
+            pagePools[i] = PagePool_create(1, optionsPtr->minPageCount, optionsPtr->maxPageCount);
+            frameNodes[i] = NULL;
+        } else {
+            pagePools[i] = PagePool_create(1, optionsPtr->minPageCount, 0);
+            frameNodes[i] = FrameNode_start(
+                i,
+                pagePools[i],
+                optionsPtr->nodeSocketDirectoryPath,
+                optionsPtr->nodeBorrowBatchSize
+            );
+        }
+    }
+    if (optionsPtr->nodeCount > 0) {
+        FrameNode_connectPeers(frameNodes, pagePoolCount);
+    }
 
-    Pages const pages = Pages_create();
-    Pages_add(pages, (struct Page){
-        .owner = NULL,
-        .referenced = false,
-        .modified = false
-    });
-    pthread_mutex_t pagesMutex;
-    safeMutexInit(&pagesMutex, NULL, "hw8");
-    safeMutexLock(&pagesMutex, "hw8");
+    struct PeriodicallyResetPagesReferencedThreadStartArg resetPagesReferencedArg = {
+        .pagePools = pagePools,
+        .pagePoolCount = pagePoolCount,
+        .sharedFrameTable = NULL,
+        .stopPtr = NULL,
+        .stopMutexPtr = NULL,
+        .stopConditionPtr = NULL
+    };
+
+    // In deterministic mode, the R bits are reset every second of virtual time instead of by a separate thread
+    DeterministicScheduler scheduler = NULL;
+    if (optionsPtr->deterministic) {
+        scheduler = DeterministicScheduler_create(
+            transactionRecordCount,
+            optionsPtr->seed,
+            UINT64_C(1000000000),
+            resetPagesReferenced,
+            &resetPagesReferencedArg
+        );
+    }
 
     struct ProcessTransactionsThreadStartArg * const threadStartArgs = (
-        safeMalloc(sizeof *threadStartArgs * transactionRecordCount, "hw8")
+        safeMalloc(sizeof *threadStartArgs * transactionRecordCount, "hw8 runTransactionThreads")
     );
-    pthread_t * const threadIds = safeMalloc(sizeof *threadIds * transactionRecordCount, "hw8");
     for (size_t i = 0; i < transactionRecordCount; i += 1) {
         struct HW8TransactionRecord const * const transactionRecordPtr = &transactionRecords[i];
         struct ProcessTransactionsThreadStartArg * const threadStartArgPtr = &threadStartArgs[i];
 
         threadStartArgPtr->transactionRecordPtr = transactionRecordPtr;
+        threadStartArgPtr->transactionRecordIndex = i;
+        threadStartArgPtr->transactionReader = transactionReaders[i];
+        threadStartArgPtr->prefetchSections = optionsPtr->prefetchSections;
+        threadStartArgPtr->simulateDelays = !optionsPtr->follow;
 
-        threadStartArgPtr->balancePtr = &balance;
+        threadStartArgPtr->balanceCentsPtr = &balanceCents;
         threadStartArgPtr->balanceMutexPtr = &balanceMutex;
+        threadStartArgPtr->stats = optionsPtr->collectStats ? PageStats_create() : NULL;
+
+        // With multiple nodes, the transaction records are spread across them round-robin
+        PagePool const pagePool = pagePools[i % pagePoolCount];
+        threadStartArgPtr->pagePool = pagePool;
+        threadStartArgPtr->sharedFrameTable = NULL;
+        threadStartArgPtr->frameNode = frameNodes[i % pagePoolCount];
+        threadStartArgPtr->pageOwnerIndex = PagePool_addOwner(pagePool, transactionRecordPtr->name);
+        PagePool_setOwnerStats(pagePool, threadStartArgPtr->pageOwnerIndex, threadStartArgPtr->stats);
+
+        threadStartArgPtr->scheduler = scheduler;
+        threadStartArgPtr->schedulerThreadIndex = i;
+        initializeRandomStream(&threadStartArgPtr->randomStream, optionsPtr->seed, i + 1);
+        initializeWorkloadProfileCursor(
+            &threadStartArgPtr->pageAccessCursor,
+            optionsPtr->pageAccessProfile,
+            i,
+            transactionRecordCount,
+            optionsPtr->pageAccessProfilePeriodLength,
+            optionsPtr->seed
+        );
+    }
+
+    // Resumed before the journal is opened for appending, since resuming replays the journal's tail
+    uint64_t runId = optionsPtr->resume ? 0 : newRunId();
+    struct RunProgress runProgress = {.records = NULL};
+    bool const trackRunProgress = optionsPtr->checkpointPath != NULL || optionsPtr->resume;
+    if (trackRunProgress) {
+        runProgress = (struct RunProgress){
+            .runId = runId,
+            .checkpointPath = optionsPtr->checkpointPath,
+            .checkpointIntervalSectionCount = optionsPtr->checkpointIntervalSectionCount,
+            .appliedSectionCount = 0,
+            .records = safeMalloc(sizeof *runProgress.records * transactionRecordCount, "hw8 runTransactionThreads"),
+            .recordCount = transactionRecordCount,
+            .pagePool = pagePools[0]
+        };
+        for (size_t i = 0; i < transactionRecordCount; i += 1) {
+            runProgress.records[i] = (struct CheckpointRecordState){
+                .offset = (uint64_t)TransactionReader_offset(transactionReaders[i]),
+                .sectionIndex = 0
+            };
+        }
+        if (optionsPtr->resume) {
+            balanceCents = resumeRun(&runProgress, transactionReaders, optionsPtr);
+            runId = runProgress.runId;
+        } else if (runProgress.checkpointPath != NULL) {
+            // Replace any earlier run's checkpoint, so that resuming after a crash before the first one starts over
+            writeCheckpoint(
+                runProgress.checkpointPath,
+                runId,
+                0,
+                0,
+                runProgress.records,
+                runProgress.recordCount,
+                runProgress.pagePool
+            );
+        }
+    }
+
+    Journal journal = NULL;
+    if (optionsPtr->journalPath != NULL) {
+        journal = Journal_start(optionsPtr->journalPath, &(struct JournalOptions){
+            .groupCommitWindowUs = optionsPtr->journalGroupCommitWindowUs,
+            .maxBatchSize = optionsPtr->journalMaxBatchSize,
+            .append = optionsPtr->resume,
+            .runId = runId
+        });
+    }
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        threadStartArgs[i].journal = journal;
+        threadStartArgs[i].runProgressPtr = trackRunProgress ? &runProgress : NULL;
+        threadStartArgs[i].firstSectionIndex = trackRunProgress ? runProgress.records[i].sectionIndex : 0;
+    }
 
-        threadStartArgPtr->pages = pages;
-        PagesNode const initialOwnedPageNode = Pages_add(pages, (struct Page){
-            .owner = transactionRecordPtr->name,
-            .referenced = false,
-            .modified = false
+    PagePressureController pagePressureController = NULL;
+    bool const resizePagePool = (
+        optionsPtr->pageFaultsPerIntervalHigh > 0 || optionsPtr->pageControlFifoPath != NULL
+    );
+    if (optionsPtr->nodeCount == 0 && resizePagePool) {
+        pagePressureController = PagePressureController_start(pagePools[0], &(struct PagePressureControllerOptions){
+            .intervalMs = optionsPtr->pagePressureIntervalMs,
+            .faultsPerIntervalHigh = optionsPtr->pageFaultsPerIntervalHigh,
+            .faultsPerIntervalLow = optionsPtr->pageFaultsPerIntervalLow,
+            .step = optionsPtr->pageResizeStep,
+            .controlFifoPath = optionsPtr->pageControlFifoPath
         });
-        threadStartArgPtr->initialOwnedPageNode = initialOwnedPageNode;
-        threadStartArgPtr->pagesMutexPtr = &pagesMutex;
+    }
 
+    pthread_t * const threadIds = safeMalloc(sizeof *threadIds * transactionRecordCount, "hw8 runTransactionThreads");
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
         threadIds[i] = safePthreadCreate(
             NULL,
             processTransactionsThreadStart,
-            threadStartArgPtr,
-            "hw8"
+            &threadStartArgs[i],
+            "hw8 runTransactionThreads"
         );
     }
 
-    safeMutexUnlock(&pagesMutex, "hw8");
-
     bool stopPeriodicallyResettingPagesReferenced = false;
-    safePthreadCreate(
-        NULL,
-        periodicallyResetPagesReferencedThreadStart,
-        &(struct PeriodicallyResetPagesReferencedThreadStartArg){
-            .pages = pages,
-            .pagesMutexPtr = &pagesMutex,
-            .stopPtr = &stopPeriodicallyResettingPagesReferenced
-        },
-        "hw8"
-    );
+    pthread_mutex_t stopPeriodicallyResettingPagesReferencedMutex;
+    safeMutexInit(&stopPeriodicallyResettingPagesReferencedMutex, NULL, "hw8 runTransactionThreads");
+    pthread_cond_t stopPeriodicallyResettingPagesReferencedCondition;
+    safeConditionInit(&stopPeriodicallyResettingPagesReferencedCondition, NULL, "hw8 runTransactionThreads");
+    if (scheduler == NULL) {
+        resetPagesReferencedArg.stopPtr = &stopPeriodicallyResettingPagesReferenced;
+        resetPagesReferencedArg.stopMutexPtr = &stopPeriodicallyResettingPagesReferencedMutex;
+        resetPagesReferencedArg.stopConditionPtr = &stopPeriodicallyResettingPagesReferencedCondition;
+        pthread_t const periodicallyResetPagesReferencedThreadId = safePthreadCreate(
+            NULL,
+            periodicallyResetPagesReferencedThreadStart,
+            &resetPagesReferencedArg,
+            "hw8 runTransactionThreads"
+        );
 
-    for (size_t i = 0; i < transactionRecordCount; i += 1) {
-        pthread_t const threadId = threadIds[i];
-        safePthreadJoin(threadId, "hw8");
+        joinTransactionThreads(threadIds, transactionRecordCount);
+
+        safeMutexLock(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionThreads");
+        stopPeriodicallyResettingPagesReferenced = true;
+        safeConditionSignal(&stopPeriodicallyResettingPagesReferencedCondition, "hw8 runTransactionThreads");
+        safeMutexUnlock(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionThreads");
+        safePthreadJoin(periodicallyResetPagesReferencedThreadId, "hw8 runTransactionThreads");
+    } else {
+        joinTransactionThreads(threadIds, transactionRecordCount);
+        DeterministicScheduler_destroy(scheduler);
     }
+    safeConditionDestroy(&stopPeriodicallyResettingPagesReferencedCondition, "hw8 runTransactionThreads");
+    safeMutexDestroy(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionThreads");
+
+    if (runProgress.checkpointPath != NULL) {
+        writeCheckpoint(
+            runProgress.checkpointPath,
+            runProgress.runId,
+            runProgress.appliedSectionCount,
+            balanceCents,
+            runProgress.records,
+            runProgress.recordCount,
+            runProgress.pagePool
+        );
+    }
+    free(runProgress.records);
 
-    stopPeriodicallyResettingPagesReferenced = true;
-    safeMutexLock(&pagesMutex, "hw8");
-    Pages_destroy(pages);
-    safeMutexUnlock(&pagesMutex, "hw8");
+    if (pagePressureController != NULL) {
+        PagePressureController_stop(pagePressureController);
+    }
+    for (size_t i = 0; i < pagePoolCount; i += 1) {
+        if (frameNodes[i] != NULL) {
+            FrameNode_printStats(frameNodes[i]);
+            FrameNode_stop(frameNodes[i]);
+        }
+        PagePool_destroy(pagePools[i]);
+    }
+    free(frameNodes);
+    free(pagePools);
+
+    PageStats stats = NULL;
+    if (optionsPtr->collectStats) {
+        stats = PageStats_create();
+        for (size_t i = 0; i < transactionRecordCount; i += 1) {
+            PageStats_merge(stats, threadStartArgs[i].stats);
+            PageStats_destroy(threadStartArgs[i].stats);
+        }
+    }
 
     free(threadStartArgs);
     free(threadIds);
+    closeTransactionReaders(transactionReaders, transactionRecordCount);
 
-    safeMutexDestroy(&balanceMutex, "hw8");
-    safeMutexDestroy(&pagesMutex, "hw8");
+    safeMutexDestroy(&balanceMutex, "hw8 runTransactionThreads");
 
-    printf("Final account balance is $%.2f\n", (double)balance);
-}
+    printFinalBalance(balanceCents);
 
-static void ensureInitialized(void) {
-    if (initialized) {
-        return;
+    if (journal != NULL) {
+        Journal_printStats(journal, stdout);
+        Journal_stop(journal);
     }
 
-    safeRegcomp(&beginTransactionSectionRegex, "^R$", REG_EXTENDED | REG_NOSUB, "hw8 ensureInitialized");
-    // ^[+-][0-9]+\.?[0-9]*|[0-9]*\.[0-9]+$
-    safeRegcomp(&transactionRegex, "^[+-][0-9]+\\.?[0-9]*|[0-9]*\\.[0-9]+$", REG_EXTENDED | REG_NOSUB, "hw8 ensureInitialized");
-    safeRegcomp(&endTransactionSectionRegex, "^W$", REG_EXTENDED | REG_NOSUB, "hw8 ensureInitialized");
-
-    initialized = true;
+    if (stats != NULL) {
+        PageStats_print(stats, stdout);
+        if (optionsPtr->statsJsonPath != NULL) {
+            FILE * const statsJsonFile = safeFopen(optionsPtr->statsJsonPath, "w", "hw8 runTransactionThreads");
+            PageStats_writeJson(stats, statsJsonFile);
+            fclose(statsJsonFile);
+        }
+        PageStats_destroy(stats);
+    }
 }
 
 static void *processTransactionsThreadStart(void * const argAsVoidPtr) {
     assert(argAsVoidPtr != NULL);
     struct ProcessTransactionsThreadStartArg * const argPtr = argAsVoidPtr;
 
-    FILE * const transactionFile = (
-        safeFopen(argPtr->transactionRecordPtr->filePath, "r", "hw8 processTransactionsThreadStart")
-    );
-
-    PageNodeList const ownedPageNodes = PageNodeList_create();
-    PageNodeList_add(ownedPageNodes, argPtr->initialOwnedPageNode);
+    // Started here rather than when the reader is opened, so that it also runs in a forked child
+    if (argPtr->prefetchSections) {
+        TransactionReader_startPrefetch(argPtr->transactionReader);
+    }
 
     bool isFirstTransactionSection = true;
+    uint64_t sectionIndex = argPtr->firstSectionIndex;
     while (true) {
-        char * const beginTransactionSectionLine = readFileLine(transactionFile);
-        if (beginTransactionSectionLine == NULL) {
-            break;
-        }
-        if (regexec(&beginTransactionSectionRegex, beginTransactionSectionLine, 0, NULL, 0) == REG_NOMATCH) {
-            abortWithErrorFmt(
-                "hw8 processTransactionsThreadStart: %s thread failed to parse BeginTransactionSection symbol from \"%s\" (line: \"%s\")",
-                argPtr->transactionRecordPtr->name,
-                argPtr->transactionRecordPtr->filePath,
-                beginTransactionSectionLine
-            );
+        // Sum the whole section before taking the balance lock, so that only applying it is serialized
+        int64_t sectionDeltaCents;
+        if (!TransactionReader_readSection(argPtr->transactionReader, &sectionDeltaCents)) {
             break;
         }
-        free(beginTransactionSectionLine);
+        size_t const sectionEndOffset = (
+            argPtr->runProgressPtr != NULL ? TransactionReader_offset(argPtr->transactionReader) : 0
+        );
 
-        if (!isFirstTransactionSection) {
+        if (argPtr->scheduler != NULL) {
+            // Simulate delay between transaction sections in virtual time; the scheduler runs the sections in the
+            // order they would have woken up in
+            uint64_t delayNs = 0;
+            if (!isFirstTransactionSection) {
+                delayNs = (uint64_t)threadRandomInt(argPtr, 0, 2) * UINT64_C(1000000000);
+                delayNs += (uint64_t)threadRandomInt(argPtr, 0, 1000 * 1000 * 1000);
+            }
+            DeterministicScheduler_beginTurn(argPtr->scheduler, argPtr->schedulerThreadIndex, delayNs);
+        } else if (argPtr->simulateDelays && !isFirstTransactionSection) {
             // Simulate delay between transaction sections
             nanosleep(&(struct timespec){
                 .tv_sec = randomInt(0, 2),
@@ -192,177 +682,798 @@ static void *processTransactionsThreadStart(void * const argAsVoidPtr) {
             }, NULL);
         }
 
-        safeMutexLock(argPtr->balanceMutexPtr, "hw8 processTransactionsThreadStart");
+        uint64_t const balanceLockedTimeNs = lockBalance(argPtr);
 
-        float balance = *argPtr->balancePtr;
+        int64_t const balanceCents = ADD_CENTS(*argPtr->balanceCentsPtr, sectionDeltaCents);
 
-        while (true) {
-            char * const line = readFileLine(transactionFile);
-            if (line == NULL) {
-                abortWithErrorFmt(
-                    "hw8 processTransactionsThreadStart: %s thread reached EOF before EndTransactionSection symbol was parsed from \"%s\"",
-                    argPtr->transactionRecordPtr->name,
-                    argPtr->transactionRecordPtr->filePath
-                );
-                break;
-            }
-            if (regexec(&endTransactionSectionRegex, line, 0, NULL, 0) == 0) {
-                free(line);
-                break;
-            }
-            if (regexec(&transactionRegex, line, 0, NULL, 0) == REG_NOMATCH) {
-                abortWithErrorFmt(
-                    "hw8 processTransactionsThreadStart: %s thread failed to parse Deposit, Withdraw, or EndTransactionSection symbol from \"%s\" (line: \"%s\")",
-                    argPtr->transactionRecordPtr->name,
-                    argPtr->transactionRecordPtr->filePath,
-                    line
-                );
-                break;
-            }
+        bool const requireAdditionalPage = threadRequiresAdditionalPage(argPtr);
+        accessPages(
+            argPtr,
+            requireAdditionalPage,
+            balanceCents < 0 ? PageAccess_write : balanceCents > 0 ? PageAccess_read : PageAccess_none
+        );
+
+        *argPtr->balanceCentsPtr = balanceCents;
+        char balanceString[CENTS_STRING_CAPACITY];
+        formatCents(balanceCents, balanceString);
+        printf("Account balance after thread %s is $%s\n", argPtr->transactionRecordPtr->name, balanceString);
+
+        // Appended under the balance lock so that the journal is in the same order as the balance
+        uint64_t journalSequenceNumber = 0;
+        if (argPtr->journal != NULL) {
+            journalSequenceNumber = Journal_append(argPtr->journal, &(struct JournalEntry){
+                .transactionRecordIndex = (uint64_t)argPtr->transactionRecordIndex,
+                .sectionIndex = sectionIndex,
+                .deltaCents = sectionDeltaCents,
+                .balanceCents = balanceCents
+            });
+        }
+        if (argPtr->runProgressPtr != NULL) {
+            recordSectionApplied(argPtr, sectionEndOffset, sectionIndex, balanceCents, journalSequenceNumber);
+        }
 
-            float const transactionAmount = strtof(line, NULL);
-            free(line);
+        unlockBalance(argPtr, balanceLockedTimeNs);
+        if (argPtr->scheduler != NULL) {
+            DeterministicScheduler_endTurn(argPtr->scheduler, argPtr->schedulerThreadIndex);
+        }
 
-            balance += transactionAmount;
+        // Waited for only after giving up the balance lock and turn, so that other threads can join the same commit
+        if (argPtr->journal != NULL) {
+            Journal_waitDurable(argPtr->journal, journalSequenceNumber);
         }
 
-        safeMutexLock(argPtr->pagesMutexPtr, "hw8 processTransactionsThreadStart");
+        isFirstTransactionSection = false;
+        sectionIndex += 1;
+    }
 
-        for (int i = 0; (size_t)i < PageNodeList_count(ownedPageNodes); i += 1) {
-            PagesNode const ownedPageNode = PageNodeList_get(ownedPageNodes, (size_t)i);
-            if (Pages_item(argPtr->pages, ownedPageNode).owner != argPtr->transactionRecordPtr->name) {
-                PageNodeList_removeAt(ownedPageNodes, (size_t)i);
-                i -= 1;
-            }
+    if (argPtr->scheduler != NULL) {
+        DeterministicScheduler_finish(argPtr->scheduler, argPtr->schedulerThreadIndex);
+    }
+
+    return NULL;
+}
+
+static TransactionStore buildTransactionStore(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr
+) {
+    // The store validates every file as it is built, so the source readers are not indexed first
+    struct HW8Options sourceOptions = *optionsPtr;
+    sourceOptions.prevalidate = false;
+    TransactionReader * const sourceReaders = openTransactionReaders(
+        transactionRecords,
+        transactionRecordCount,
+        &sourceOptions,
+        NULL
+    );
+    if (!optionsPtr->sectionCache) {
+        TransactionStore const transactionStore = TransactionStore_build(
+            sourceReaders,
+            transactionRecordCount,
+            optionsPtr->prevalidateThreadCount
+        );
+        closeTransactionReaders(sourceReaders, transactionRecordCount);
+        return transactionStore;
+    }
+
+    char const ** const filePaths = safeMalloc(sizeof *filePaths * transactionRecordCount, "hw8 buildTransactionStore");
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        filePaths[i] = transactionRecords[i].filePath;
+    }
+    enum SectionCacheResult * const cacheResults = safeMalloc(
+        sizeof *cacheResults * transactionRecordCount,
+        "hw8 buildTransactionStore"
+    );
+    TransactionStore const transactionStore = TransactionStore_buildCached(
+        sourceReaders,
+        filePaths,
+        transactionRecordCount,
+        optionsPtr->prevalidateThreadCount,
+        cacheResults
+    );
+
+    if (optionsPtr->collectStats) {
+        size_t resultCounts[SectionCacheResult_uncached + 1] = {0};
+        for (size_t i = 0; i < transactionRecordCount; i += 1) {
+            resultCounts[cacheResults[i]] += 1;
         }
+        printf(
+            "Section cache: %zu unchanged, %zu appended, %zu read in full, %zu streamed\n",
+            resultCounts[SectionCacheResult_hit],
+            resultCounts[SectionCacheResult_appended],
+            resultCounts[SectionCacheResult_miss],
+            resultCounts[SectionCacheResult_uncached]
+        );
+    }
 
-        bool const requireAdditionalPage = randomInt(0, 4) == 0;
-        if (PageNodeList_empty(ownedPageNodes) || requireAdditionalPage) {
-            printf("Page fault in thread %s\n", argPtr->transactionRecordPtr->name);
-
-            PagesNode unownedAdditionalPageNode = NULL;
-            PagesNode class0AdditionalPageNode = NULL;
-            PagesNode class1AdditionalPageNode = NULL;
-            PagesNode class2AdditionalPageNode = NULL;
-            PagesNode class3AdditionalPageNode = NULL;
-
-            PagesNode const headPageNode = Pages_head(argPtr->pages);
-            PagesNode currentPageNode = headPageNode;
-            while (true) {
-                struct Page * const currentPagePtr = Pages_itemPtr(argPtr->pages, currentPageNode);
-
-                if (currentPagePtr->owner == NULL) {
-                    unownedAdditionalPageNode = currentPageNode;
-                    break;
-                }
-
-                bool const currentPageReferenced = currentPagePtr->referenced;
-                bool const currentPageModified = currentPagePtr->modified;
-                if (!currentPageReferenced && !currentPageModified) {
-                    class0AdditionalPageNode = currentPageNode;
-                } else if (!currentPageReferenced && currentPageModified) {
-                    class1AdditionalPageNode = currentPageNode;
-                } else if (currentPageReferenced && !currentPageModified) {
-                    class2AdditionalPageNode = currentPageNode;
-                } else { // currentPageReferenced && currentPageModified
-                    class3AdditionalPageNode = currentPageNode;
-                }
-
-                PagesNode const nextPageNode = Pages_next(argPtr->pages, currentPageNode);
-                if (nextPageNode == headPageNode) {
-                    break;
-                }
-                currentPageNode = nextPageNode;
-            }
+    free(cacheResults);
+    free(filePaths);
+    closeTransactionReaders(sourceReaders, transactionRecordCount);
+    return transactionStore;
+}
 
-            PagesNode const additionalPageNode = (
-                unownedAdditionalPageNode != NULL ? (
-                    unownedAdditionalPageNode
-                ) : class0AdditionalPageNode != NULL ? (
-                    class0AdditionalPageNode
-                ) : class1AdditionalPageNode != NULL ? (
-                    class1AdditionalPageNode
-                ) : class2AdditionalPageNode != NULL ? (
-                    class2AdditionalPageNode
-                ) : ( // class3AdditionalPageNode != NULL
-                    class3AdditionalPageNode
-                )
+static TransactionReader *openTransactionReaders(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr,
+    TransactionStore const transactionStore
+) {
+    TransactionReader * const transactionReaders = safeMalloc(
+        sizeof *transactionReaders * transactionRecordCount,
+        "hw8 openTransactionReaders"
+    );
+    if (transactionStore != NULL) {
+        for (size_t i = 0; i < transactionRecordCount; i += 1) {
+            transactionReaders[i] = TransactionStore_openReader(
+                transactionStore,
+                i,
+                transactionRecords[i].name,
+                transactionRecords[i].filePath
             );
-            struct Page * const additionalPagePtr = Pages_itemPtr(argPtr->pages, additionalPageNode);
-            printf(
-                "Page being removed: {owner=%s, referenced=%s, modified=%s}\n",
-                additionalPagePtr->owner == NULL ? "[UNOWNED]" : additionalPagePtr->owner,
-                additionalPagePtr->referenced ? "yes" : "no",
-                additionalPagePtr->modified ? "yes" : "no"
+        }
+        return transactionReaders;
+    }
+
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        struct HW8TransactionRecord const * const transactionRecordPtr = &transactionRecords[i];
+        if (optionsPtr->follow) {
+            transactionReaders[i] = TransactionReader_openFollowing(
+                transactionRecordPtr->name,
+                transactionRecordPtr->filePath,
+                optionsPtr->followIdleTimeoutMs
             );
+        } else if (optionsPtr->batchReadFiles && !TransactionReader_isStreamPath(transactionRecordPtr->filePath)) {
+            // Read below, together with the other regular files
+            transactionReaders[i] = NULL;
+        } else {
+            transactionReaders[i] = TransactionReader_open(transactionRecordPtr->name, transactionRecordPtr->filePath);
+        }
+    }
+    if (optionsPtr->batchReadFiles) {
+        batchReadTransactionFiles(transactionRecords, transactionRecordCount, transactionReaders, optionsPtr);
+    }
+
+    if (optionsPtr->prevalidate) {
+        ThreadPool const threadPool = ThreadPool_create(optionsPtr->prevalidateThreadCount);
+        ThreadPool_run(threadPool, transactionRecordCount, indexTransactionReader, transactionReaders);
+        ThreadPool_destroy(threadPool);
+    }
 
-            PageNodeList_add(ownedPageNodes, additionalPageNode);
-            additionalPagePtr->owner = argPtr->transactionRecordPtr->name;
-            additionalPagePtr->referenced = false;
-            additionalPagePtr->modified = false;
+    return transactionReaders;
+}
+
+static void batchReadTransactionFiles(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    TransactionReader * const transactionReaders,
+    struct HW8Options const * const optionsPtr
+) {
+    size_t * const recordIndexes = safeMalloc(sizeof *recordIndexes * transactionRecordCount, "hw8 batchReadTransactionFiles");
+    char const ** const filePaths = safeMalloc(sizeof *filePaths * transactionRecordCount, "hw8 batchReadTransactionFiles");
+    size_t fileCount = 0;
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        if (transactionReaders[i] == NULL) {
+            recordIndexes[fileCount] = i;
+            filePaths[fileCount] = transactionRecords[i].filePath;
+            fileCount += 1;
         }
+    }
 
-        for (size_t i = 0; i < PageNodeList_count(ownedPageNodes); i += 1) {
-            PagesNode const ownedPageNode = PageNodeList_get(ownedPageNodes, i);
-            if (balance < 0) {
-                Pages_itemPtr(argPtr->pages, ownedPageNode)->referenced = true;
-                Pages_itemPtr(argPtr->pages, ownedPageNode)->modified = true;
-            } else if (balance > 0) {
-                Pages_itemPtr(argPtr->pages, ownedPageNode)->referenced = true;
-            }
+    struct FileContents * const fileContents = safeMalloc(
+        sizeof *fileContents * transactionRecordCount,
+        "hw8 batchReadTransactionFiles"
+    );
+    struct FileBatchStats fileBatchStats;
+    readFilesBatched(filePaths, fileCount, fileContents, &fileBatchStats);
+    for (size_t i = 0; i < fileCount; i += 1) {
+        struct HW8TransactionRecord const * const transactionRecordPtr = &transactionRecords[recordIndexes[i]];
+        transactionReaders[recordIndexes[i]] = TransactionReader_openContents(
+            transactionRecordPtr->name,
+            transactionRecordPtr->filePath,
+            fileContents[i].chars,
+            fileContents[i].length
+        );
+    }
+
+    if (optionsPtr->collectStats) {
+        printf(
+            "Read %zu files (%llu bytes) using %s in %llu system calls\n",
+            fileCount,
+            (unsigned long long)fileBatchStats.byteCount,
+            fileBatchStats.usedIoRing ? "io_uring" : "pread",
+            (unsigned long long)fileBatchStats.systemCallCount
+        );
+    }
+
+    free(fileContents);
+    free(filePaths);
+    free(recordIndexes);
+}
+
+static void indexTransactionReader(void * const transactionReadersAsVoidPtr, size_t const transactionRecordIndex) {
+    TransactionReader const * const transactionReaders = transactionReadersAsVoidPtr;
+    TransactionReader_index(transactionReaders[transactionRecordIndex]);
+}
+
+static void closeTransactionReaders(TransactionReader * const transactionReaders, size_t const transactionRecordCount) {
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        TransactionReader_close(transactionReaders[i]);
+    }
+    free(transactionReaders);
+}
+
+static void joinTransactionThreads(pthread_t const * const threadIds, size_t const transactionRecordCount) {
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        pthread_t const threadId = threadIds[i];
+        safePthreadJoin(threadId, "hw8 runTransactionThreads");
+    }
+}
+
+static void printFinalBalance(int64_t const balanceCents) {
+    char balanceString[CENTS_STRING_CAPACITY];
+    formatCents(balanceCents, balanceString);
+    printf("Final account balance is $%s\n", balanceString);
+}
+
+/**
+ * Bring a run up to date with its checkpoint, if there is one, and then with the journal entries after it, if there is
+ * a journal. Each transaction reader is moved to the record's next section, and each section in a journal entry is read
+ * again and checked against the entry, so this takes time in proportion to the journal's tail rather than to the whole
+ * run. The run keeps the ID of the checkpoint, or else of the journal, and the journal must belong to the same run as
+ * the checkpoint.
+ *
+ * @returns The balance to resume from.
+ */
+static int64_t resumeRun(
+    struct RunProgress * const runProgressPtr,
+    TransactionReader const * const transactionReaders,
+    struct HW8Options const * const optionsPtr
+) {
+    int64_t balanceCents = 0;
+    struct MappedCheckpoint checkpoint;
+    bool const haveCheckpoint = (
+        optionsPtr->checkpointPath != NULL
+        && mapCheckpoint(&checkpoint, optionsPtr->checkpointPath, runProgressPtr->recordCount)
+    );
+    if (haveCheckpoint) {
+        runProgressPtr->runId = checkpoint.headerPtr->runId;
+        balanceCents = checkpoint.headerPtr->balanceCents;
+        runProgressPtr->appliedSectionCount = checkpoint.headerPtr->appliedSectionCount;
+        for (size_t i = 0; i < runProgressPtr->recordCount; i += 1) {
+            runProgressPtr->records[i] = checkpoint.records[i];
+            TransactionReader_skipTo(
+                transactionReaders[i],
+                (size_t)checkpoint.records[i].offset,
+                (size_t)checkpoint.records[i].sectionIndex
+            );
+        }
+        restoreCheckpointPages(&checkpoint, runProgressPtr->pagePool);
+        unmapCheckpoint(&checkpoint);
+    }
+    uint64_t const checkpointSectionCount = runProgressPtr->appliedSectionCount;
+
+    // A journal from another run than the checkpoint's would replay sections which were never applied to it
+    uint64_t journalRunId = 0;
+    size_t journalEntryCount = 0;
+    struct JournalEntry * const journalEntries = (
+        optionsPtr->journalPath != NULL
+            ? readJournalEntries(
+                optionsPtr->journalPath,
+                runProgressPtr->runId,
+                checkpointSectionCount,
+                &journalRunId,
+                &journalEntryCount
+            )
+            : NULL
+    );
+    if (runProgressPtr->runId == 0) {
+        runProgressPtr->runId = journalRunId != 0 ? journalRunId : newRunId();
+    }
+    for (size_t i = 0; i < journalEntryCount; i += 1) {
+        struct JournalEntry const entry = journalEntries[i];
+        if (entry.transactionRecordIndex >= (uint64_t)runProgressPtr->recordCount) {
+            abortWithErrorFmt(
+                "hw8 resumeRun: Journal entry %llu is for transaction record %llu, but there are only %zu",
+                (unsigned long long)(checkpointSectionCount + i),
+                (unsigned long long)entry.transactionRecordIndex,
+                runProgressPtr->recordCount
+            );
         }
+        size_t const transactionRecordIndex = (size_t)entry.transactionRecordIndex;
+        struct CheckpointRecordState * const recordPtr = &runProgressPtr->records[transactionRecordIndex];
+        TransactionReader const transactionReader = transactionReaders[transactionRecordIndex];
+
+        int64_t sectionDeltaCents = 0;
+        bool const matches = (
+            entry.sectionIndex == recordPtr->sectionIndex
+            && TransactionReader_readSection(transactionReader, &sectionDeltaCents)
+            && sectionDeltaCents == entry.deltaCents
+        );
+        if (!matches) {
+            abortWithErrorFmt(
+                "hw8 resumeRun: Section %llu of transaction record %zu does not match journal entry %llu",
+                (unsigned long long)recordPtr->sectionIndex,
+                transactionRecordIndex,
+                (unsigned long long)(checkpointSectionCount + i)
+            );
+        }
+
+        recordPtr->offset = (uint64_t)TransactionReader_offset(transactionReader);
+        recordPtr->sectionIndex += 1;
+        runProgressPtr->appliedSectionCount += 1;
+        balanceCents = entry.balanceCents;
+    }
+    free(journalEntries);
+
+    char balanceString[CENTS_STRING_CAPACITY];
+    formatCents(balanceCents, balanceString);
+    printf(
+        "Resuming after %llu sections (%llu from the checkpoint, %zu from the journal) with balance $%s\n",
+        (unsigned long long)runProgressPtr->appliedSectionCount,
+        (unsigned long long)checkpointSectionCount,
+        journalEntryCount,
+        balanceString
+    );
+    return balanceCents;
+}
+
+/**
+ * Make up an ID for a new run, to stamp its journal and checkpoints with. It is never 0.
+ *
+ * @returns The run ID.
+ */
+static uint64_t newRunId(void) {
+    uint64_t const parts[] = {
+        (uint64_t)safeTime("hw8 newRunId"),
+        safeMonotonicTimeNs("hw8 newRunId"),
+        (uint64_t)getpid()
+    };
+    uint64_t const runId = hashBytes(parts, sizeof parts);
+    return runId != 0 ? runId : 1;
+}
 
-        safeMutexUnlock(argPtr->pagesMutexPtr, "hw8 processTransactionsThreadStart");
+static int threadRandomInt(
+    struct ProcessTransactionsThreadStartArg * const argPtr,
+    int const minInclusive,
+    int const maxExclusive
+) {
+    if (argPtr->scheduler != NULL) {
+        return randomStreamInt(&argPtr->randomStream, minInclusive, maxExclusive);
+    }
+    return randomInt(minInclusive, maxExclusive);
+}
 
-        *argPtr->balancePtr = balance;
-        printf("Account balance after thread %s is $%.2f\n", argPtr->transactionRecordPtr->name, (double)balance);
+static bool threadRequiresAdditionalPage(struct ProcessTransactionsThreadStartArg * const argPtr) {
+    // The uniform profile keeps the original one-in-four draw, so seeded runs print what they always have
+    if (argPtr->pageAccessCursor.profile == WorkloadProfile_uniform) {
+        return threadRandomInt(argPtr, 0, 4) == 0;
+    }
 
-        safeMutexUnlock(argPtr->balanceMutexPtr, "hw8 processTransactionsThreadStart");
+    double const weight = nextWorkloadProfileWeight(&argPtr->pageAccessCursor);
+    int const thresholdPerMillion = (int)(weight * 1000 * 1000 / 4);
+    return threadRandomInt(argPtr, 0, 1000 * 1000) < thresholdPerMillion;
+}
 
-        isFirstTransactionSection = false;
+static uint64_t lockBalance(struct ProcessTransactionsThreadStartArg const * const argPtr) {
+    if (argPtr->sharedFrameTable != NULL) {
+        if (safeRobustMutexLock(argPtr->balanceMutexPtr, "hw8 lockBalance")) {
+            fprintf(stderr, "hw8 lockBalance: A process died while holding the balance lock; continuing\n");
+        }
+        return 0;
     }
 
-    PageNodeList_destroy(ownedPageNodes);
-    fclose(transactionFile);
+    if (argPtr->stats == NULL) {
+        safeMutexLock(argPtr->balanceMutexPtr, "hw8 lockBalance");
+        return 0;
+    }
 
-    return NULL;
+    uint64_t const lockStartTimeNs = safeMonotonicTimeNs("hw8 lockBalance");
+    safeMutexLock(argPtr->balanceMutexPtr, "hw8 lockBalance");
+    uint64_t const lockedTimeNs = safeMonotonicTimeNs("hw8 lockBalance");
+    PageStats_record(argPtr->stats, PageStat_balanceMutexWaitNs, lockedTimeNs - lockStartTimeNs);
+    return lockedTimeNs;
+}
+
+static void unlockBalance(struct ProcessTransactionsThreadStartArg const * const argPtr, uint64_t const lockedTimeNs) {
+    if (argPtr->stats != NULL) {
+        PageStats_record(
+            argPtr->stats,
+            PageStat_balanceMutexHoldNs,
+            safeMonotonicTimeNs("hw8 unlockBalance") - lockedTimeNs
+        );
+    }
+    safeMutexUnlock(argPtr->balanceMutexPtr, "hw8 unlockBalance");
+}
+
+/**
+ * Record that a section has been applied to the balance, and write a checkpoint if one is due. The balance lock must be
+ * held.
+ */
+static void recordSectionApplied(
+    struct ProcessTransactionsThreadStartArg const * const argPtr,
+    size_t const sectionEndOffset,
+    uint64_t const sectionIndex,
+    int64_t const balanceCents,
+    uint64_t const journalSequenceNumber
+) {
+    struct RunProgress * const runProgressPtr = argPtr->runProgressPtr;
+    runProgressPtr->records[argPtr->transactionRecordIndex] = (struct CheckpointRecordState){
+        .offset = (uint64_t)sectionEndOffset,
+        .sectionIndex = sectionIndex + 1
+    };
+    runProgressPtr->appliedSectionCount += 1;
+
+    bool const checkpointDue = (
+        runProgressPtr->checkpointPath != NULL
+        && runProgressPtr->checkpointIntervalSectionCount > 0
+        && runProgressPtr->appliedSectionCount % runProgressPtr->checkpointIntervalSectionCount == 0
+    );
+    if (!checkpointDue) {
+        return;
+    }
+
+    // A checkpoint must never get ahead of the journal, or resuming from it would find the journal's tail missing
+    if (argPtr->journal != NULL) {
+        Journal_waitDurable(argPtr->journal, journalSequenceNumber);
+    }
+    writeCheckpoint(
+        runProgressPtr->checkpointPath,
+        runProgressPtr->runId,
+        runProgressPtr->appliedSectionCount,
+        balanceCents,
+        runProgressPtr->records,
+        runProgressPtr->recordCount,
+        runProgressPtr->pagePool
+    );
+}
+
+static void accessPages(
+    struct ProcessTransactionsThreadStartArg const * const argPtr,
+    bool const requireAdditionalPage,
+    enum PageAccess const access
+) {
+    if (argPtr->frameNode != NULL) {
+        FrameNode_access(argPtr->frameNode, argPtr->pageOwnerIndex, requireAdditionalPage, access);
+    } else if (argPtr->pagePool != NULL) {
+        PagePool_access(argPtr->pagePool, argPtr->pageOwnerIndex, requireAdditionalPage, access);
+    } else {
+        SharedFrameTable_access(argPtr->sharedFrameTable, argPtr->pageOwnerIndex, requireAdditionalPage, access);
+    }
 }
 
 static void *periodicallyResetPagesReferencedThreadStart(void * const argAsVoidPtr) {
     assert(argAsVoidPtr != NULL);
     struct PeriodicallyResetPagesReferencedThreadStartArg * const argPtr = argAsVoidPtr;
 
-    while (true) {
-        nanosleep(&(struct timespec){
-            .tv_sec = 1,
-            .tv_nsec = 0
-        }, NULL);
-
-        if (*argPtr->stopPtr) {
-            break;
+    // A wakeup without a stop request is spurious, so the wait resumes towards the same absolute deadline rather than
+    // counting as a period
+    safeMutexLock(argPtr->stopMutexPtr, "hw8 periodicallyResetPagesReferencedThreadStart");
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    while (!*argPtr->stopPtr) {
+        bool const signaled = safeConditionTimedWait(
+            argPtr->stopConditionPtr,
+            argPtr->stopMutexPtr,
+            &deadline,
+            "hw8 periodicallyResetPagesReferencedThreadStart"
+        );
+        if (signaled || *argPtr->stopPtr) {
+            continue;
         }
 
-        safeMutexLock(argPtr->pagesMutexPtr, "hw8 periodicallyResetPagesReferencedThreadStart");
+        resetPagesReferenced(argPtr);
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+    }
+    safeMutexUnlock(argPtr->stopMutexPtr, "hw8 periodicallyResetPagesReferencedThreadStart");
+
+    return NULL;
+}
+
+static void resetPagesReferenced(void * const argAsVoidPtr) {
+    assert(argAsVoidPtr != NULL);
+    struct PeriodicallyResetPagesReferencedThreadStartArg const * const argPtr = argAsVoidPtr;
 
-        if (*argPtr->stopPtr) {
-            safeMutexUnlock(argPtr->pagesMutexPtr, "hw8 periodicallyResetPagesReferencedThreadStart");
-            break;
+    if (argPtr->sharedFrameTable == NULL) {
+        for (size_t i = 0; i < argPtr->pagePoolCount; i += 1) {
+            PagePool_resetReferenced(argPtr->pagePools[i]);
         }
+    } else {
+        SharedFrameTable_resetReferenced(argPtr->sharedFrameTable);
+    }
+}
+
+/**
+ * Process the transaction records one after another, without any delays or page accesses, splitting each file into
+ * chunks of whole sections which are summed in parallel. Each chunk records the delta of each of its sections, and the
+ * deltas are then applied to the balance in file order, so the printed balances are the same as processing the
+ * records serially.
+ *
+ * @param transactionRecords The transaction records to process.
+ * @param transactionRecordCount The number of transaction records.
+ * @param optionsPtr The options.
+ */
+static void runSplitTransactionRecords(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr
+) {
+    TransactionReader * const transactionReaders = openTransactionReaders(
+        transactionRecords,
+        transactionRecordCount,
+        optionsPtr,
+        NULL
+    );
+
+    // A few chunks per thread keeps the threads busy when sections vary in size
+    ThreadPool const threadPool = ThreadPool_create(optionsPtr->splitThreadCount);
+    size_t const maxChunkCount = ThreadPool_threadCount(threadPool) * 4;
+    TransactionReader * const chunkReaders = safeMalloc(
+        sizeof *chunkReaders * maxChunkCount,
+        "hw8 runSplitTransactionRecords"
+    );
+    Int64List * const sectionDeltaCentsLists = safeMalloc(
+        sizeof *sectionDeltaCentsLists * maxChunkCount,
+        "hw8 runSplitTransactionRecords"
+    );
+
+    int64_t balanceCents = 0;
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        size_t const chunkCount = TransactionReader_split(transactionReaders[i], maxChunkCount, chunkReaders);
+        ThreadPool_run(threadPool, chunkCount, sumTransactionChunk, &(struct SumTransactionChunkArg){
+            .chunkReaders = chunkReaders,
+            .sectionDeltaCentsLists = sectionDeltaCentsLists
+        });
 
-        PagesNode const headPageNode = Pages_head(argPtr->pages);
-        PagesNode currentPageNode = headPageNode;
-        while (true) {
-            Pages_itemPtr(argPtr->pages, currentPageNode)->referenced = false;
+        for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex += 1) {
+            Int64List const sectionDeltaCentsList = sectionDeltaCentsLists[chunkIndex];
+            int64_t const * const sectionDeltasCents = Int64List_items(sectionDeltaCentsList);
+            size_t const sectionCount = Int64List_count(sectionDeltaCentsList);
+            for (size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex += 1) {
+                balanceCents = ADD_CENTS(balanceCents, sectionDeltasCents[sectionIndex]);
 
-            PagesNode const nextPageNode = Pages_next(argPtr->pages, currentPageNode);
-            if (nextPageNode == headPageNode) {
-                break;
+                char balanceString[CENTS_STRING_CAPACITY];
+                formatCents(balanceCents, balanceString);
+                printf("Account balance after thread %s is $%s\n", transactionRecords[i].name, balanceString);
             }
-            currentPageNode = nextPageNode;
+
+            Int64List_destroy(sectionDeltaCentsList);
+            TransactionReader_close(chunkReaders[chunkIndex]);
         }
+    }
+
+    free(sectionDeltaCentsLists);
+    free(chunkReaders);
+    ThreadPool_destroy(threadPool);
+    closeTransactionReaders(transactionReaders, transactionRecordCount);
+
+    printFinalBalance(balanceCents);
+}
 
-        safeMutexUnlock(argPtr->pagesMutexPtr, "hw8 periodicallyResetPagesReferencedThreadStart");
+static void sumTransactionChunk(void * const argAsVoidPtr, size_t const chunkIndex) {
+    struct SumTransactionChunkArg const * const argPtr = argAsVoidPtr;
+
+    Int64List const sectionDeltaCentsList = Int64List_create();
+    int64_t sectionDeltaCents;
+    while (TransactionReader_readSection(argPtr->chunkReaders[chunkIndex], &sectionDeltaCents)) {
+        Int64List_add(sectionDeltaCentsList, sectionDeltaCents);
     }
+    argPtr->sectionDeltaCentsLists[chunkIndex] = sectionDeltaCentsList;
+}
 
-    return NULL;
+/**
+ * Process the transaction records once against a ledger of account balances, each record by a task on a thread pool,
+ * without any delays or page accesses. Each transaction line may carry the ID of the account it applies to (see
+ * lexAccountTransactionLine), and each section is applied to every account it touches at once, so sections touching
+ * accounts in different stripes are applied in parallel. The files must be in the text format. The balance of each
+ * account is printed at the end.
+ *
+ * @param transactionRecords The transaction records to process.
+ * @param transactionRecordCount The number of transaction records.
+ * @param optionsPtr The options.
+ */
+static void runLedgerTransactionRecords(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr
+) {
+    TransactionReader * const transactionReaders = openTransactionReaders(
+        transactionRecords,
+        transactionRecordCount,
+        optionsPtr,
+        NULL
+    );
+    Ledger const ledger = Ledger_create(optionsPtr->ledgerAccountCapacity, optionsPtr->ledgerStripeCount);
+
+    ThreadPool const threadPool = ThreadPool_create(optionsPtr->ledgerThreadCount);
+    ThreadPool_run(threadPool, transactionRecordCount, applyLedgerRecord, &(struct ApplyLedgerRecordArg){
+        .transactionRecords = transactionRecords,
+        .transactionReaders = transactionReaders,
+        .ledger = ledger
+    });
+    ThreadPool_destroy(threadPool);
+    closeTransactionReaders(transactionReaders, transactionRecordCount);
+
+    Uint64List const accountIds = Uint64List_create();
+    Int64List const balancesCents = Int64List_create();
+    Ledger_balances(ledger, accountIds, balancesCents);
+    int64_t totalBalanceCents = 0;
+    for (size_t i = 0; i < Uint64List_count(accountIds); i += 1) {
+        int64_t const balanceCents = Int64List_get(balancesCents, i);
+        totalBalanceCents = ADD_CENTS(totalBalanceCents, balanceCents);
+
+        char balanceString[CENTS_STRING_CAPACITY];
+        formatCents(balanceCents, balanceString);
+        printf(
+            "Final balance of account %llu is $%s\n",
+            (unsigned long long)Uint64List_get(accountIds, i),
+            balanceString
+        );
+    }
+    Int64List_destroy(balancesCents);
+    Uint64List_destroy(accountIds);
+
+    printFinalBalance(totalBalanceCents);
+    Ledger_printStats(ledger, stdout);
+    Ledger_destroy(ledger);
+}
+
+static void applyLedgerRecord(void * const argAsVoidPtr, size_t const transactionRecordIndex) {
+    struct ApplyLedgerRecordArg const * const argPtr = argAsVoidPtr;
+    char const * const name = argPtr->transactionRecords[transactionRecordIndex].name;
+    TransactionReader const transactionReader = argPtr->transactionReaders[transactionRecordIndex];
+
+    Uint64List const accountIds = Uint64List_create();
+    Int64List const accountDeltasCents = Int64List_create();
+    Int64List const accountBalancesCents = Int64List_create();
+    while (TransactionReader_readAccountSection(transactionReader, accountIds, accountDeltasCents)) {
+        Ledger_apply(argPtr->ledger, accountIds, accountDeltasCents, accountBalancesCents);
+
+        for (size_t i = 0; i < Uint64List_count(accountIds); i += 1) {
+            char balanceString[CENTS_STRING_CAPACITY];
+            formatCents(Int64List_get(accountBalancesCents, i), balanceString);
+            printf(
+                "Account %llu balance after thread %s is $%s\n",
+                (unsigned long long)Uint64List_get(accountIds, i),
+                name,
+                balanceString
+            );
+        }
+
+        Uint64List_clear(accountIds);
+        Int64List_clear(accountDeltasCents);
+        Int64List_clear(accountBalancesCents);
+    }
+    Int64List_destroy(accountBalancesCents);
+    Int64List_destroy(accountDeltasCents);
+    Uint64List_destroy(accountIds);
+}
+
+/**
+ * Process each transaction record in a separate child process. The balance, its mutex and the frame table are placed
+ * in shared memory before forking, so the page pool is fixed in size. This process resets the R bits periodically
+ * while it waits for the children.
+ *
+ * @param transactionRecords The transaction records to process.
+ * @param transactionRecordCount The number of transaction records.
+ * @param optionsPtr The options.
+ * @param transactionStore The store to read the transaction sections from, or null to read the files.
+ */
+static void runTransactionProcesses(
+    struct HW8TransactionRecord const * const transactionRecords,
+    size_t const transactionRecordCount,
+    struct HW8Options const * const optionsPtr,
+    TransactionStore const transactionStore
+) {
+    // The readers are opened before forking, so the children inherit the mappings and any index
+    TransactionReader * const transactionReaders = openTransactionReaders(
+        transactionRecords,
+        transactionRecordCount,
+        optionsPtr,
+        transactionStore
+    );
+
+    struct SharedBalance * const sharedBalancePtr = safeSharedMalloc(sizeof *sharedBalancePtr, "hw8 runTransactionProcesses");
+    safeProcessSharedMutexInit(&sharedBalancePtr->mutex, "hw8 runTransactionProcesses");
+    sharedBalancePtr->balanceCents = 0;
+
+    SharedFrameTable const sharedFrameTable = SharedFrameTable_create(1, transactionRecordCount);
+    size_t * const pageOwnerIndexes = safeMalloc(sizeof *pageOwnerIndexes * transactionRecordCount, "hw8 runTransactionProcesses");
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        pageOwnerIndexes[i] = SharedFrameTable_addOwner(sharedFrameTable, transactionRecords[i].name);
+    }
+
+    pid_t * const processIds = safeMalloc(sizeof *processIds * transactionRecordCount, "hw8 runTransactionProcesses");
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        pid_t const processId = safeFork("hw8 runTransactionProcesses");
+        if (processId == 0) {
+            // Each child needs its own random sequence, and its output must reach the terminal before it unlocks
+            initializeRandom((unsigned int)time(NULL) ^ (unsigned int)getpid());
+            setvbuf(stdout, NULL, _IOLBF, 0);
+
+            struct ProcessTransactionsThreadStartArg threadStartArg = {
+                .transactionRecordPtr = &transactionRecords[i],
+                .transactionRecordIndex = i,
+                .transactionReader = transactionReaders[i],
+                .prefetchSections = optionsPtr->prefetchSections,
+                .simulateDelays = !optionsPtr->follow,
+                .balanceCentsPtr = &sharedBalancePtr->balanceCents,
+                .balanceMutexPtr = &sharedBalancePtr->mutex,
+                .stats = NULL,
+                .pagePool = NULL,
+                .sharedFrameTable = sharedFrameTable,
+                .frameNode = NULL,
+                .pageOwnerIndex = pageOwnerIndexes[i],
+                .scheduler = NULL,
+                .journal = NULL,
+                .runProgressPtr = NULL,
+                .firstSectionIndex = 0
+            };
+            initializeWorkloadProfileCursor(
+                &threadStartArg.pageAccessCursor,
+                optionsPtr->pageAccessProfile,
+                i,
+                transactionRecordCount,
+                optionsPtr->pageAccessProfilePeriodLength,
+                optionsPtr->seed
+            );
+            processTransactionsThreadStart(&threadStartArg);
+
+            fflush(stdout);
+            _exit(EXIT_SUCCESS);
+        }
+        processIds[i] = processId;
+    }
+
+    bool stopPeriodicallyResettingPagesReferenced = false;
+    pthread_mutex_t stopPeriodicallyResettingPagesReferencedMutex;
+    safeMutexInit(&stopPeriodicallyResettingPagesReferencedMutex, NULL, "hw8 runTransactionProcesses");
+    pthread_cond_t stopPeriodicallyResettingPagesReferencedCondition;
+    safeConditionInit(&stopPeriodicallyResettingPagesReferencedCondition, NULL, "hw8 runTransactionProcesses");
+    pthread_t const periodicallyResetPagesReferencedThreadId = safePthreadCreate(
+        NULL,
+        periodicallyResetPagesReferencedThreadStart,
+        &(struct PeriodicallyResetPagesReferencedThreadStartArg){
+            .pagePools = NULL,
+            .pagePoolCount = 0,
+            .sharedFrameTable = sharedFrameTable,
+            .stopPtr = &stopPeriodicallyResettingPagesReferenced,
+            .stopMutexPtr = &stopPeriodicallyResettingPagesReferencedMutex,
+            .stopConditionPtr = &stopPeriodicallyResettingPagesReferencedCondition
+        },
+        "hw8 runTransactionProcesses"
+    );
+
+    for (size_t i = 0; i < transactionRecordCount; i += 1) {
+        int const status = safeWaitpid(processIds[i], "hw8 runTransactionProcesses");
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(
+                stderr,
+                "hw8 runTransactionProcesses: %s process exited abnormally (status: %d)\n",
+                transactionRecords[i].name,
+                status
+            );
+        }
+    }
+
+    safeMutexLock(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionProcesses");
+    stopPeriodicallyResettingPagesReferenced = true;
+    safeConditionSignal(&stopPeriodicallyResettingPagesReferencedCondition, "hw8 runTransactionProcesses");
+    safeMutexUnlock(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionProcesses");
+    safePthreadJoin(periodicallyResetPagesReferencedThreadId, "hw8 runTransactionProcesses");
+    safeConditionDestroy(&stopPeriodicallyResettingPagesReferencedCondition, "hw8 runTransactionProcesses");
+    safeMutexDestroy(&stopPeriodicallyResettingPagesReferencedMutex, "hw8 runTransactionProcesses");
+
+    int64_t const balanceCents = sharedBalancePtr->balanceCents;
+
+    free(processIds);
+    free(pageOwnerIndexes);
+    closeTransactionReaders(transactionReaders, transactionRecordCount);
+    SharedFrameTable_destroy(sharedFrameTable);
+    safeMutexDestroy(&sharedBalancePtr->mutex, "hw8 runTransactionProcesses");
+    safeSharedFree(sharedBalancePtr, sizeof *sharedBalancePtr, "hw8 runTransactionProcesses");
+
+    printFinalBalance(balanceCents);
 }
@@ -0,0 +1,538 @@
+#include "../../include/hw8/BinaryTransactionFile.h"
+
+#include "../../include/hw8/TransactionLexer.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/file.h"
+#include "../../include/util/cents.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+// A varint holds 7 bits per byte, so a 64-bit value takes at most 10 bytes
+#define VARINT_MAX_LENGTH 10
+// Frame-of-reference amounts are unpacked with one 8-byte load, which covers any 56 bits after a bit offset of up to 7
+#define FRAME_OF_REFERENCE_MAX_BIT_WIDTH 56
+// A frame-of-reference block of identical amounts has an empty payload, so its amount count is capped separately
+#define VARINT_SECTION_MAX_AMOUNT_COUNT (UINT64_C(1) << 32)
+
+static void writeBinary(FILE *file, void const *data, size_t size, char const *binaryFilePath);
+static uint64_t zigZagEncode(int64_t value);
+static int64_t zigZagDecode(uint64_t value);
+static size_t varintLength(uint64_t value);
+static size_t writeVarint(uint64_t value, unsigned char *out);
+static bool readVarint(unsigned char const *bytes, size_t length, size_t *positionPtr, uint64_t *valueOutPtr);
+static unsigned int frameOfReferenceBitWidth(int64_t const *amountsCents, size_t amountCount, int64_t *minCentsOutPtr);
+static uint64_t loadPackedWord(unsigned char const *packed, size_t packedLength, size_t byteIndex);
+static void storePackedWord(unsigned char *packed, size_t packedLength, size_t byteIndex, uint64_t word);
+
+/**
+ * Convert a text transaction record file to the binary transaction file format. The text file is validated completely
+ * here, so that readers of the binary file do not need to validate each amount. If the text file is malformed, or the
+ * binary file cannot be written, abort the program with an error message.
+ *
+ * @param textFilePath The path to the text transaction record file.
+ * @param binaryFilePath The path to write the binary transaction file to. An existing file is overwritten.
+ * @param encoding How to encode the sections: as plain 8-byte amounts, or compressed into varint blocks.
+ */
+void convertTransactionFileToBinary(
+    char const * const textFilePath,
+    char const * const binaryFilePath,
+    enum BinaryTransactionEncoding const encoding
+) {
+    guardNotNull(textFilePath, "textFilePath", "convertTransactionFileToBinary");
+    guardNotNull(binaryFilePath, "binaryFilePath", "convertTransactionFileToBinary");
+
+    struct MappedFile textFile;
+    safeMapFile(&textFile, textFilePath, "convertTransactionFileToBinary");
+    FILE * const binaryFile = safeFopen(binaryFilePath, "wb", "convertTransactionFileToBinary");
+
+    // The section count is only known at the end, so the header is written again once it is
+    struct BinaryTransactionFileHeader header = {
+        .version = BINARY_TRANSACTION_FILE_VERSION,
+        .encoding = (uint32_t)encoding,
+        .sectionCount = 0
+    };
+    memcpy(header.magic, BINARY_TRANSACTION_FILE_MAGIC, BINARY_TRANSACTION_FILE_MAGIC_LENGTH);
+    writeBinary(binaryFile, &header, sizeof header, binaryFilePath);
+
+    int64_t *amountsCents = NULL;
+    size_t amountCapacity = 0;
+    unsigned char *encodedSection = NULL;
+    size_t encodedSectionCapacity = 0;
+    size_t lineNumber = 0;
+    while (true) {
+        struct FileLine line;
+        if (!readMappedFileLine(&textFile, &line)) {
+            break;
+        }
+        lineNumber += 1;
+
+        int64_t amountCents;
+        if (lexTransactionLine(line.chars, line.length, &amountCents) != TransactionToken_beginSection) {
+            abortWithErrorFmt(
+                "convertTransactionFileToBinary: Failed to parse BeginTransactionSection symbol from \"%s\" (line %zu: \"%.*s\")",
+                textFilePath,
+                lineNumber,
+                (int)line.length,
+                line.chars
+            );
+            break;
+        }
+
+        uint64_t amountCount = 0;
+        while (true) {
+            if (!readMappedFileLine(&textFile, &line)) {
+                abortWithErrorFmt(
+                    "convertTransactionFileToBinary: Reached EOF before EndTransactionSection symbol was parsed from \"%s\"",
+                    textFilePath
+                );
+                break;
+            }
+            lineNumber += 1;
+
+            enum TransactionToken const token = lexTransactionLine(line.chars, line.length, &amountCents);
+            if (token == TransactionToken_endSection) {
+                break;
+            }
+            if (token != TransactionToken_transaction) {
+                abortWithErrorFmt(
+                    "convertTransactionFileToBinary: Failed to parse Deposit, Withdraw, or EndTransactionSection symbol from \"%s\" (line %zu: \"%.*s\")",
+                    textFilePath,
+                    lineNumber,
+                    (int)line.length,
+                    line.chars
+                );
+                break;
+            }
+
+            if (amountCount == amountCapacity) {
+                amountCapacity = amountCapacity == 0 ? 16 : amountCapacity * 2;
+                amountsCents = safeRealloc(amountsCents, sizeof *amountsCents * amountCapacity, "convertTransactionFileToBinary");
+            }
+            amountsCents[amountCount] = amountCents;
+            amountCount += 1;
+        }
+
+        switch (encoding) {
+            case BinaryTransactionEncoding_int64: {
+                writeBinary(binaryFile, &amountCount, sizeof amountCount, binaryFilePath);
+                writeBinary(binaryFile, amountsCents, sizeof *amountsCents * amountCount, binaryFilePath);
+                break;
+            }
+            case BinaryTransactionEncoding_varint: {
+                size_t const maxLength = varintSectionMaxLength((size_t)amountCount);
+                if (maxLength > encodedSectionCapacity) {
+                    encodedSectionCapacity = maxLength;
+                    encodedSection = safeRealloc(
+                        encodedSection,
+                        encodedSectionCapacity,
+                        "convertTransactionFileToBinary"
+                    );
+                }
+                size_t const encodedLength = encodeVarintSection(amountsCents, (size_t)amountCount, encodedSection);
+                writeBinary(binaryFile, encodedSection, encodedLength, binaryFilePath);
+                break;
+            }
+            default: {
+                abortWithErrorFmt("convertTransactionFileToBinary: Invalid encoding (%d)", (int)encoding);
+                break;
+            }
+        }
+        header.sectionCount += 1;
+    }
+
+    if (fseek(binaryFile, 0, SEEK_SET) != 0) {
+        int const fseekErrorCode = errno;
+        abortWithErrorFmt(
+            "convertTransactionFileToBinary: Failed to seek to the start of \"%s\" using fseek (error code: %d; error message: \"%s\")",
+            binaryFilePath,
+            fseekErrorCode,
+            strerror(fseekErrorCode)
+        );
+    }
+    writeBinary(binaryFile, &header, sizeof header, binaryFilePath);
+    if (fclose(binaryFile) != 0) {
+        int const fcloseErrorCode = errno;
+        abortWithErrorFmt(
+            "convertTransactionFileToBinary: Failed to close \"%s\" using fclose (error code: %d; error message: \"%s\")",
+            binaryFilePath,
+            fcloseErrorCode,
+            strerror(fcloseErrorCode)
+        );
+    }
+
+    free(encodedSection);
+    free(amountsCents);
+    safeUnmapFile(&textFile, "convertTransactionFileToBinary");
+}
+
+/**
+ * Get the most bytes encodeVarintSection can write for a section of the given number of amounts.
+ *
+ * @param amountCount The number of amounts in the section.
+ *
+ * @returns The maximum encoded length.
+ */
+size_t varintSectionMaxLength(size_t const amountCount) {
+    // Amount count, packing and payload length, then at worst one full varint per amount
+    return VARINT_MAX_LENGTH + 1 + VARINT_MAX_LENGTH + VARINT_MAX_LENGTH * amountCount;
+}
+
+/**
+ * Encode a section as a block of a varint binary transaction file. The block starts with a header: the amount count as
+ * a varint, a VarintSectionPacking byte and the payload length as a varint. The payload then packs the amounts in
+ * whichever of these ways is smallest:
+ *
+ *  - zigZag: each amount as a zig-zag varint, so that small deposits and withdrawals both take one or two bytes.
+ *  - delta: each amount's difference from the amount before it (the first from 0) as a zig-zag varint, for sections
+ *    of similar amounts.
+ *  - frameOfReference: the smallest amount as a zig-zag varint, a bit width byte, then each amount's difference from
+ *    the smallest packed into that many bits, least significant first, for sections of amounts within a narrow range.
+ *
+ * Varints are little-endian base 128: 7 bits per byte, with the high bit set on every byte but the last.
+ *
+ * @param amountsCents The amounts of the section in cents.
+ * @param amountCount The number of amounts. It must not exceed VARINT_SECTION_MAX_AMOUNT_COUNT.
+ * @param out Where to write the block. It must hold at least varintSectionMaxLength(amountCount) bytes.
+ *
+ * @returns The length of the block.
+ */
+size_t encodeVarintSection(int64_t const * const amountsCents, size_t const amountCount, unsigned char * const out) {
+    guardFmt(
+        amountCount <= VARINT_SECTION_MAX_AMOUNT_COUNT,
+        "encodeVarintSection: A section of %zu amounts exceeds the limit of %" PRIu64,
+        amountCount,
+        VARINT_SECTION_MAX_AMOUNT_COUNT
+    );
+    guard(amountCount == 0 || amountsCents != NULL, "encodeVarintSection: amountsCents is null");
+    guardNotNull(out, "out", "encodeVarintSection");
+
+    size_t zigZagLength = 0;
+    size_t deltaLength = 0;
+    int64_t previousAmountCents = 0;
+    for (size_t i = 0; i < amountCount; i += 1) {
+        zigZagLength += varintLength(zigZagEncode(amountsCents[i]));
+        deltaLength += varintLength(zigZagEncode((int64_t)((uint64_t)amountsCents[i] - (uint64_t)previousAmountCents)));
+        previousAmountCents = amountsCents[i];
+    }
+
+    int64_t minCents = 0;
+    unsigned int const bitWidth = frameOfReferenceBitWidth(amountsCents, amountCount, &minCents);
+    size_t const packedLength = (amountCount * bitWidth + 7) / 8;
+    size_t const frameOfReferenceLength = (
+        bitWidth <= FRAME_OF_REFERENCE_MAX_BIT_WIDTH
+            ? varintLength(zigZagEncode(minCents)) + 1 + packedLength
+            : SIZE_MAX
+    );
+
+    enum VarintSectionPacking packing = VarintSectionPacking_zigZag;
+    size_t payloadLength = zigZagLength;
+    if (deltaLength < payloadLength) {
+        packing = VarintSectionPacking_delta;
+        payloadLength = deltaLength;
+    }
+    if (frameOfReferenceLength < payloadLength) {
+        packing = VarintSectionPacking_frameOfReference;
+        payloadLength = frameOfReferenceLength;
+    }
+
+    size_t length = writeVarint((uint64_t)amountCount, out);
+    out[length] = (unsigned char)packing;
+    length += 1;
+    length += writeVarint((uint64_t)payloadLength, out + length);
+
+    switch (packing) {
+        case VarintSectionPacking_zigZag: {
+            for (size_t i = 0; i < amountCount; i += 1) {
+                length += writeVarint(zigZagEncode(amountsCents[i]), out + length);
+            }
+            break;
+        }
+        case VarintSectionPacking_delta: {
+            previousAmountCents = 0;
+            for (size_t i = 0; i < amountCount; i += 1) {
+                uint64_t const deltaCents = (uint64_t)amountsCents[i] - (uint64_t)previousAmountCents;
+                length += writeVarint(zigZagEncode((int64_t)deltaCents), out + length);
+                previousAmountCents = amountsCents[i];
+            }
+            break;
+        }
+        case VarintSectionPacking_frameOfReference: {
+            length += writeVarint(zigZagEncode(minCents), out + length);
+            out[length] = (unsigned char)bitWidth;
+            length += 1;
+
+            unsigned char * const packed = out + length;
+            memset(packed, 0, packedLength);
+            for (size_t i = 0; i < amountCount && bitWidth > 0; i += 1) {
+                size_t const bitIndex = i * bitWidth;
+                uint64_t const offsetCents = (uint64_t)amountsCents[i] - (uint64_t)minCents;
+                uint64_t const word = loadPackedWord(packed, packedLength, bitIndex / 8);
+                storePackedWord(packed, packedLength, bitIndex / 8, word | offsetCents << (bitIndex % 8));
+            }
+            length += packedLength;
+            break;
+        }
+        default: {
+            abortWithErrorFmt("encodeVarintSection: Invalid packing (%d)", (int)packing);
+            break;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * Read the header of a varint section block. See encodeVarintSection.
+ *
+ * @param chars The contents of the binary transaction file.
+ * @param length The length of the contents.
+ * @param position The offset of the block.
+ * @param sectionOutPtr Where to store the section.
+ *
+ * @returns Whether the header is well formed, the amount count is within VARINT_SECTION_MAX_AMOUNT_COUNT and the block
+ *          fits within the contents.
+ */
+bool readVarintSectionHeader(
+    char const * const chars,
+    size_t const length,
+    size_t const position,
+    struct VarintSection * const sectionOutPtr
+) {
+    guard(length == 0 || chars != NULL, "readVarintSectionHeader: chars is null");
+    guardNotNull(sectionOutPtr, "sectionOutPtr", "readVarintSectionHeader");
+
+    unsigned char const * const bytes = (unsigned char const *)chars;
+    size_t headerPosition = position;
+    uint64_t amountCount;
+    if (!readVarint(bytes, length, &headerPosition, &amountCount) || headerPosition == length) {
+        return false;
+    }
+    unsigned char const packing = bytes[headerPosition];
+    headerPosition += 1;
+    uint64_t payloadLength;
+    bool const valid = (
+        amountCount <= VARINT_SECTION_MAX_AMOUNT_COUNT
+        && packing <= VarintSectionPacking_frameOfReference
+        && readVarint(bytes, length, &headerPosition, &payloadLength)
+        && payloadLength <= length - headerPosition
+    );
+    if (!valid) {
+        return false;
+    }
+
+    *sectionOutPtr = (struct VarintSection){
+        .amountCount = amountCount,
+        .packing = (enum VarintSectionPacking)packing,
+        .payloadBegin = headerPosition,
+        .end = headerPosition + (size_t)payloadLength
+    };
+    return true;
+}
+
+/**
+ * Decode the amounts of a varint section block and sum them.
+ *
+ * @param chars The contents of the binary transaction file.
+ * @param sectionPtr The section, as read by readVarintSectionHeader.
+ * @param amountsCents The list to append each amount to, or null.
+ * @param sectionDeltaCentsOutPtr Where to store the sum of the amounts.
+ *
+ * @returns Whether the payload is well formed and holds exactly the section's amounts.
+ */
+bool decodeVarintSection(
+    char const * const chars,
+    struct VarintSection const * const sectionPtr,
+    Int64List const amountsCents,
+    int64_t * const sectionDeltaCentsOutPtr
+) {
+    guardNotNull(sectionPtr, "sectionPtr", "decodeVarintSection");
+    guardNotNull(sectionDeltaCentsOutPtr, "sectionDeltaCentsOutPtr", "decodeVarintSection");
+
+    // Positions are relative to the payload, so that a varint can never be read past its end
+    unsigned char const * const payload = (unsigned char const *)chars + sectionPtr->payloadBegin;
+    size_t const payloadLength = sectionPtr->end - sectionPtr->payloadBegin;
+    uint64_t const amountCount = sectionPtr->amountCount;
+    size_t position = 0;
+    int64_t deltaCents = 0;
+
+    switch (sectionPtr->packing) {
+        case VarintSectionPacking_zigZag:
+        case VarintSectionPacking_delta: {
+            bool const delta = sectionPtr->packing == VarintSectionPacking_delta;
+            uint64_t amountCents = 0;
+            for (uint64_t i = 0; i < amountCount; i += 1) {
+                uint64_t value;
+                // Most amounts fit in one or two bytes, so the first byte is checked inline
+                if (position < payloadLength && payload[position] < 0x80) {
+                    value = payload[position];
+                    position += 1;
+                } else if (!readVarint(payload, payloadLength, &position, &value)) {
+                    return false;
+                }
+                amountCents = delta ? amountCents + (uint64_t)zigZagDecode(value) : (uint64_t)zigZagDecode(value);
+                deltaCents = ADD_CENTS(deltaCents, amountCents);
+                if (amountsCents != NULL) {
+                    Int64List_add(amountsCents, (int64_t)amountCents);
+                }
+            }
+            break;
+        }
+        case VarintSectionPacking_frameOfReference: {
+            uint64_t minCents;
+            if (!readVarint(payload, payloadLength, &position, &minCents) || position == payloadLength) {
+                return false;
+            }
+            unsigned int const bitWidth = payload[position];
+            position += 1;
+            size_t const remainingLength = payloadLength - position;
+            bool const valid = (
+                bitWidth <= FRAME_OF_REFERENCE_MAX_BIT_WIDTH
+                && (bitWidth == 0 || amountCount <= (uint64_t)remainingLength * 8 / bitWidth)
+                && remainingLength == ((size_t)amountCount * bitWidth + 7) / 8
+            );
+            if (!valid) {
+                return false;
+            }
+
+            unsigned char const * const packed = payload + position;
+            uint64_t const mask = (UINT64_C(1) << bitWidth) - 1;
+            uint64_t const referenceCents = (uint64_t)zigZagDecode(minCents);
+            for (size_t i = 0; i < (size_t)amountCount; i += 1) {
+                size_t const bitIndex = i * bitWidth;
+                uint64_t const word = bitWidth > 0 ? loadPackedWord(packed, remainingLength, bitIndex / 8) : 0;
+                int64_t const amountCents = (int64_t)(referenceCents + (word >> (bitIndex % 8) & mask));
+                deltaCents = ADD_CENTS(deltaCents, amountCents);
+                if (amountsCents != NULL) {
+                    Int64List_add(amountsCents, amountCents);
+                }
+            }
+            position = payloadLength;
+            break;
+        }
+        default: {
+            return false;
+        }
+    }
+
+    *sectionDeltaCentsOutPtr = deltaCents;
+    return position == payloadLength;
+}
+
+static void writeBinary(FILE * const file, void const * const data, size_t const size, char const * const binaryFilePath) {
+    if (size > 0 && fwrite(data, size, 1, file) != 1) {
+        int const fwriteErrorCode = errno;
+        abortWithErrorFmt(
+            "convertTransactionFileToBinary: Failed to write %zu bytes to \"%s\" using fwrite (error code: %d; error message: \"%s\")",
+            size,
+            binaryFilePath,
+            fwriteErrorCode,
+            strerror(fwriteErrorCode)
+        );
+    }
+}
+
+static uint64_t zigZagEncode(int64_t const value) {
+    // Interleave positive and negative values, so that small magnitudes of either sign encode small
+    return (uint64_t)value << 1 ^ (UINT64_C(0) - ((uint64_t)value >> 63));
+}
+
+static int64_t zigZagDecode(uint64_t const value) {
+    return (int64_t)(value >> 1 ^ (UINT64_C(0) - (value & 1)));
+}
+
+static size_t varintLength(uint64_t const value) {
+    size_t length = 1;
+    for (uint64_t remaining = value >> 7; remaining != 0; remaining >>= 7) {
+        length += 1;
+    }
+    return length;
+}
+
+static size_t writeVarint(uint64_t const value, unsigned char * const out) {
+    size_t length = 0;
+    uint64_t remaining = value;
+    while (remaining >= 0x80) {
+        out[length] = (unsigned char)(remaining & 0x7F) | 0x80;
+        length += 1;
+        remaining >>= 7;
+    }
+    out[length] = (unsigned char)remaining;
+    return length + 1;
+}
+
+static bool readVarint(
+    unsigned char const * const bytes,
+    size_t const length,
+    size_t * const positionPtr,
+    uint64_t * const valueOutPtr
+) {
+    uint64_t value = 0;
+    size_t position = *positionPtr;
+    for (unsigned int shift = 0; shift < 7 * VARINT_MAX_LENGTH; shift += 7) {
+        if (position == length) {
+            return false;
+        }
+        unsigned char const byte = bytes[position];
+        position += 1;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            *positionPtr = position;
+            *valueOutPtr = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the number of bits needed to pack every amount as its difference from the smallest amount.
+ */
+static unsigned int frameOfReferenceBitWidth(
+    int64_t const * const amountsCents,
+    size_t const amountCount,
+    int64_t * const minCentsOutPtr
+) {
+    if (amountCount == 0) {
+        *minCentsOutPtr = 0;
+        return 0;
+    }
+
+    int64_t minCents = amountsCents[0];
+    int64_t maxCents = amountsCents[0];
+    for (size_t i = 1; i < amountCount; i += 1) {
+        minCents = amountsCents[i] < minCents ? amountsCents[i] : minCents;
+        maxCents = amountsCents[i] > maxCents ? amountsCents[i] : maxCents;
+    }
+
+    unsigned int bitWidth = 0;
+    for (uint64_t range = (uint64_t)maxCents - (uint64_t)minCents; range != 0; range >>= 1) {
+        bitWidth += 1;
+    }
+    *minCentsOutPtr = minCents;
+    return bitWidth;
+}
+
+static uint64_t loadPackedWord(unsigned char const * const packed, size_t const packedLength, size_t const byteIndex) {
+    uint64_t word = 0;
+    size_t const availableLength = packedLength - byteIndex;
+    memcpy(&word, packed + byteIndex, availableLength < sizeof word ? availableLength : sizeof word);
+    return word;
+}
+
+static void storePackedWord(
+    unsigned char * const packed,
+    size_t const packedLength,
+    size_t const byteIndex,
+    uint64_t const word
+) {
+    size_t const availableLength = packedLength - byteIndex;
+    memcpy(packed + byteIndex, &word, availableLength < sizeof word ? availableLength : sizeof word);
+}
@@ -0,0 +1,223 @@
+#include "../../include/hw8/Checkpoint.h"
+
+#include "../../include/hw8/PagePool.h"
+#include "../../include/util/file.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/hash.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static uint64_t checkpointChecksum(void const *checkpointData, size_t length);
+
+/**
+ * Write a consistent snapshot of a run to a checkpoint file: the balance, how far each transaction record had been
+ * applied, and the state of every page frame. The file is written to a temporary file, synced and then renamed over
+ * any earlier checkpoint, so the file at filePath is always a whole checkpoint, even after a crash.
+ *
+ * @param filePath The path of the checkpoint file.
+ * @param runId The ID of the run, shared with its journal.
+ * @param appliedSectionCount The number of sections applied to the balance so far, in all transaction records.
+ * @param balanceCents The balance.
+ * @param records The state of each transaction record.
+ * @param recordCount The number of transaction records.
+ * @param pagePool The page pool. Nothing may access it while the checkpoint is written.
+ */
+void writeCheckpoint(
+    char const * const filePath,
+    uint64_t const runId,
+    uint64_t const appliedSectionCount,
+    int64_t const balanceCents,
+    struct CheckpointRecordState const * const records,
+    size_t const recordCount,
+    PagePool const pagePool
+) {
+    guardNotNull(filePath, "filePath", "writeCheckpoint");
+    guard(recordCount == 0 || records != NULL, "writeCheckpoint: records is null");
+    guardNotNull(pagePool, "pagePool", "writeCheckpoint");
+
+    size_t const pageCount = PagePool_pageCount(pagePool);
+    struct PageState * const pageStates = safeMalloc(sizeof *pageStates * pageCount, "writeCheckpoint");
+    PagePool_pageStates(pagePool, pageStates, pageCount);
+
+    size_t const recordsOffset = sizeof(struct CheckpointHeader);
+    size_t const pagesOffset = recordsOffset + sizeof(struct CheckpointRecordState) * recordCount;
+    size_t const length = pagesOffset + sizeof(struct CheckpointPageState) * pageCount;
+    char * const checkpointData = safeMalloc(length, "writeCheckpoint");
+    memset(checkpointData, 0, length);
+
+    struct CheckpointHeader header = {
+        .version = CHECKPOINT_VERSION,
+        .reserved = 0,
+        .checksum = 0,
+        .runId = runId,
+        .appliedSectionCount = appliedSectionCount,
+        .balanceCents = balanceCents,
+        .recordCount = (uint64_t)recordCount,
+        .pageCount = (uint64_t)pageCount
+    };
+    memcpy(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH);
+    memcpy(checkpointData, &header, sizeof header);
+    memcpy(checkpointData + recordsOffset, records, sizeof *records * recordCount);
+    for (size_t i = 0; i < pageCount; i += 1) {
+        struct CheckpointPageState const pageState = {
+            .ownerIndex = pageStates[i].ownerIndex == PAGE_UNOWNED ? UINT64_MAX : (uint64_t)pageStates[i].ownerIndex,
+            .referenced = pageStates[i].referenced,
+            .modified = pageStates[i].modified
+        };
+        memcpy(checkpointData + pagesOffset + sizeof pageState * i, &pageState, sizeof pageState);
+    }
+    header.checksum = checkpointChecksum(checkpointData, length);
+    memcpy(checkpointData, &header, sizeof header);
+    free(pageStates);
+
+    char * const temporaryPath = formatString("%s.%ld.tmp", filePath, (long)getpid());
+    int const fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool written = fd != -1;
+    size_t writtenLength = 0;
+    while (written && writtenLength < length) {
+        ssize_t const result = write(fd, checkpointData + writtenLength, length - writtenLength);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        written = result != -1;
+        writtenLength += written ? (size_t)result : 0;
+    }
+    written = written && fsync(fd) == 0;
+    if (fd != -1) {
+        written = close(fd) == 0 && written;
+    }
+    if (!written || rename(temporaryPath, filePath) == -1) {
+        int const writeErrorCode = errno;
+        unlink(temporaryPath);
+        abortWithErrorFmt(
+            "writeCheckpoint: Failed to write \"%s\" (error code: %d; error message: \"%s\")",
+            filePath,
+            writeErrorCode,
+            strerror(writeErrorCode)
+        );
+    }
+
+    free(temporaryPath);
+    free(checkpointData);
+}
+
+/**
+ * Map a checkpoint file written by writeCheckpoint into memory, and check that it is whole and matches the run.
+ *
+ * @param checkpointOutPtr Where to store the mapped checkpoint. The caller is responsible for unmapping it.
+ * @param filePath The path of the checkpoint file.
+ * @param recordCount The number of transaction records in the run, which must match the checkpoint.
+ *
+ * @returns Whether there is a checkpoint at filePath. A checkpoint which is corrupt or does not match is an error.
+ */
+bool mapCheckpoint(
+    struct MappedCheckpoint * const checkpointOutPtr,
+    char const * const filePath,
+    size_t const recordCount
+) {
+    guardNotNull(checkpointOutPtr, "checkpointOutPtr", "mapCheckpoint");
+    guardNotNull(filePath, "filePath", "mapCheckpoint");
+
+    if (access(filePath, F_OK) == -1 && errno == ENOENT) {
+        return false;
+    }
+    struct MappedFile file;
+    safeMapFile(&file, filePath, "mapCheckpoint");
+
+    struct CheckpointHeader const * const headerPtr = file.mapping;
+    bool valid = (
+        file.length >= sizeof *headerPtr
+        && memcmp(headerPtr->magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH) == 0
+        && headerPtr->version == CHECKPOINT_VERSION
+    );
+    valid = valid && (
+        headerPtr->pageCount >= 1
+        && headerPtr->recordCount <= file.length / sizeof(struct CheckpointRecordState)
+        && headerPtr->pageCount <= file.length / sizeof(struct CheckpointPageState)
+        && (
+            file.length
+            == sizeof *headerPtr
+                + sizeof(struct CheckpointRecordState) * (size_t)headerPtr->recordCount
+                + sizeof(struct CheckpointPageState) * (size_t)headerPtr->pageCount
+        )
+    );
+    if (!valid || headerPtr->checksum != checkpointChecksum(file.mapping, file.length)) {
+        abortWithErrorFmt("mapCheckpoint: \"%s\" is not a whole version %d checkpoint", filePath, CHECKPOINT_VERSION);
+    }
+    if (headerPtr->recordCount != (uint64_t)recordCount) {
+        abortWithErrorFmt(
+            "mapCheckpoint: \"%s\" is for %llu transaction records, not %zu",
+            filePath,
+            (unsigned long long)headerPtr->recordCount,
+            recordCount
+        );
+    }
+
+    // The header and every state are whole words, so the states of the mapping are word-aligned
+    char const * const recordsChars = file.chars + sizeof *headerPtr;
+    char const * const pagesChars = recordsChars + sizeof(struct CheckpointRecordState) * recordCount;
+    *checkpointOutPtr = (struct MappedCheckpoint){
+        .file = file,
+        .headerPtr = headerPtr,
+        .records = (struct CheckpointRecordState const *)(void const *)recordsChars,
+        .pages = (struct CheckpointPageState const *)(void const *)pagesChars
+    };
+    return true;
+}
+
+/**
+ * Unmap a checkpoint mapped by mapCheckpoint.
+ *
+ * @param checkpointPtr The mapped checkpoint.
+ */
+void unmapCheckpoint(struct MappedCheckpoint * const checkpointPtr) {
+    guardNotNull(checkpointPtr, "checkpointPtr", "unmapCheckpoint");
+
+    safeUnmapFile(&checkpointPtr->file, "unmapCheckpoint");
+    checkpointPtr->headerPtr = NULL;
+    checkpointPtr->records = NULL;
+    checkpointPtr->pages = NULL;
+}
+
+/**
+ * Replace the page frames of a page pool with those of a checkpoint.
+ *
+ * @param checkpointPtr The mapped checkpoint.
+ * @param pagePool The page pool. Its owners must have been added in the same order as in the checkpointed run.
+ */
+void restoreCheckpointPages(struct MappedCheckpoint const * const checkpointPtr, PagePool const pagePool) {
+    guardNotNull(checkpointPtr, "checkpointPtr", "restoreCheckpointPages");
+    guardNotNull(pagePool, "pagePool", "restoreCheckpointPages");
+
+    size_t const pageCount = (size_t)checkpointPtr->headerPtr->pageCount;
+    struct PageState * const pageStates = safeMalloc(sizeof *pageStates * pageCount, "restoreCheckpointPages");
+    for (size_t i = 0; i < pageCount; i += 1) {
+        struct CheckpointPageState const pageState = checkpointPtr->pages[i];
+        pageStates[i] = (struct PageState){
+            .ownerIndex = pageState.ownerIndex == UINT64_MAX ? PAGE_UNOWNED : (size_t)pageState.ownerIndex,
+            .referenced = pageState.referenced != 0,
+            .modified = pageState.modified != 0
+        };
+    }
+    PagePool_restorePageStates(pagePool, pageStates, pageCount);
+    free(pageStates);
+}
+
+/**
+ * Hash everything in a checkpoint after its checksum field.
+ */
+static uint64_t checkpointChecksum(void const * const checkpointData, size_t const length) {
+    size_t const checksumEnd = offsetof(struct CheckpointHeader, checksum) + sizeof(uint64_t);
+    return hashBytes((char const *)checkpointData + checksumEnd, length - checksumEnd);
+}
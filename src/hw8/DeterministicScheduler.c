@@ -0,0 +1,262 @@
+#include "../../include/hw8/DeterministicScheduler.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/random.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define NO_THREAD SIZE_MAX
+
+enum DeterministicSchedulerThreadState {
+    DeterministicSchedulerThreadState_running,
+    DeterministicSchedulerThreadState_waiting,
+    DeterministicSchedulerThreadState_finished
+};
+
+struct DeterministicSchedulerThread {
+    enum DeterministicSchedulerThreadState state;
+    uint64_t clockNs;
+    uint64_t wakeTimeNs;
+};
+
+/**
+ * Represents a scheduler which runs the turns of a fixed set of threads one at a time, in an order that depends only on
+ * the seed and the delays the threads ask for. Time is virtual: a thread which asks to be delayed is not put to sleep,
+ * it is simply ordered after every thread which would wake before it. A turn is only handed out once every unfinished
+ * thread is waiting for one, so the order never depends on how the OS schedules the threads. Threads which would wake
+ * at the same virtual time are ordered using the seed.
+ *
+ * Every time the virtual clock passes a multiple of the tick interval, the tick action is run by the thread whose turn
+ * it is, before its turn begins.
+ */
+struct DeterministicScheduler {
+    pthread_mutex_t mutex;
+    pthread_cond_t turnCondition;
+
+    size_t threadCount;
+    struct DeterministicSchedulerThread *threads;
+    size_t turnThreadIndex;
+    size_t *tiedThreadIndexes;
+    struct RandomStream tieBreakStream;
+
+    uint64_t clockNs;
+    uint64_t tickNs;
+    uint64_t tickCount;
+    DeterministicSchedulerTickAction tickAction;
+    void *tickActionArg;
+};
+
+static void DeterministicScheduler_chooseTurnIfReady(DeterministicScheduler scheduler);
+
+/**
+ * Create a DeterministicScheduler.
+ *
+ * @param threadCount The number of threads which will take turns. Threads are identified by their index.
+ * @param seed The seed used to order threads which would wake at the same virtual time.
+ * @param tickNs The virtual time between runs of the tick action.
+ * @param tickAction The action to run every tickNs of virtual time.
+ * @param tickActionArg The argument passed to the tick action.
+ *
+ * @returns The newly created DeterministicScheduler. The caller is responsible for freeing it.
+ */
+DeterministicScheduler DeterministicScheduler_create(
+    size_t const threadCount,
+    uint64_t const seed,
+    uint64_t const tickNs,
+    DeterministicSchedulerTickAction const tickAction,
+    void * const tickActionArg
+) {
+    guard(tickAction != NULL, "DeterministicScheduler_create: tickAction must not be null");
+    guard(tickNs > 0, "DeterministicScheduler_create: tickNs must be greater than 0");
+
+    DeterministicScheduler const scheduler = safeMalloc(sizeof *scheduler, "DeterministicScheduler_create");
+    safeMutexInit(&scheduler->mutex, NULL, "DeterministicScheduler_create");
+    safeConditionInit(&scheduler->turnCondition, NULL, "DeterministicScheduler_create");
+
+    scheduler->threadCount = threadCount;
+    scheduler->threads = safeMalloc(sizeof *scheduler->threads * threadCount, "DeterministicScheduler_create");
+    for (size_t i = 0; i < threadCount; i += 1) {
+        scheduler->threads[i] = (struct DeterministicSchedulerThread){
+            .state = DeterministicSchedulerThreadState_running,
+            .clockNs = 0,
+            .wakeTimeNs = 0
+        };
+    }
+    scheduler->turnThreadIndex = NO_THREAD;
+    scheduler->tiedThreadIndexes = safeMalloc(
+        sizeof *scheduler->tiedThreadIndexes * threadCount,
+        "DeterministicScheduler_create"
+    );
+    // Stream 0 is the scheduler's; callers may hand streams 1..threadCount to the threads themselves, and streams
+    // threadCount + 1..2 * threadCount are the threads' workload profile cursors (see initializeWorkloadProfileCursor)
+    initializeRandomStream(&scheduler->tieBreakStream, seed, 0);
+
+    scheduler->clockNs = 0;
+    scheduler->tickNs = tickNs;
+    scheduler->tickCount = 0;
+    scheduler->tickAction = tickAction;
+    scheduler->tickActionArg = tickActionArg;
+
+    return scheduler;
+}
+
+/**
+ * Free the memory associated with the DeterministicScheduler. Every thread must have finished.
+ *
+ * @param scheduler The DeterministicScheduler instance.
+ */
+void DeterministicScheduler_destroy(DeterministicScheduler const scheduler) {
+    guardNotNull(scheduler, "scheduler", "DeterministicScheduler_destroy");
+
+    free(scheduler->tiedThreadIndexes);
+    free(scheduler->threads);
+    safeConditionDestroy(&scheduler->turnCondition, "DeterministicScheduler_destroy");
+    safeMutexDestroy(&scheduler->mutex, "DeterministicScheduler_destroy");
+    free(scheduler);
+}
+
+/**
+ * Block until it is the given thread's turn. The turn lasts until the thread calls DeterministicScheduler_endTurn, and
+ * no other thread's turn can begin until this thread either asks for another turn or finishes.
+ *
+ * @param scheduler The DeterministicScheduler instance.
+ * @param threadIndex The index of the calling thread.
+ * @param delayNs The virtual time the thread would like to wait since the end of its previous turn.
+ */
+void DeterministicScheduler_beginTurn(
+    DeterministicScheduler const scheduler,
+    size_t const threadIndex,
+    uint64_t const delayNs
+) {
+    guardNotNull(scheduler, "scheduler", "DeterministicScheduler_beginTurn");
+    guardFmt(
+        threadIndex < scheduler->threadCount,
+        "DeterministicScheduler_beginTurn: Thread index %zu is out of range (thread count: %zu)",
+        threadIndex,
+        scheduler->threadCount
+    );
+
+    safeMutexLock(&scheduler->mutex, "DeterministicScheduler_beginTurn");
+
+    struct DeterministicSchedulerThread * const threadPtr = &scheduler->threads[threadIndex];
+    guard(
+        threadPtr->state == DeterministicSchedulerThreadState_running && scheduler->turnThreadIndex != threadIndex,
+        "DeterministicScheduler_beginTurn: The thread is already waiting for or taking a turn, or has finished"
+    );
+    threadPtr->state = DeterministicSchedulerThreadState_waiting;
+    threadPtr->wakeTimeNs = threadPtr->clockNs + delayNs;
+
+    DeterministicScheduler_chooseTurnIfReady(scheduler);
+    while (scheduler->turnThreadIndex != threadIndex) {
+        safeConditionWait(&scheduler->turnCondition, &scheduler->mutex, "DeterministicScheduler_beginTurn");
+    }
+
+    threadPtr->state = DeterministicSchedulerThreadState_running;
+    if (threadPtr->wakeTimeNs > scheduler->clockNs) {
+        scheduler->clockNs = threadPtr->wakeTimeNs;
+    }
+    uint64_t const tickCount = scheduler->clockNs / scheduler->tickNs;
+    bool const ticked = tickCount != scheduler->tickCount;
+    scheduler->tickCount = tickCount;
+
+    safeMutexUnlock(&scheduler->mutex, "DeterministicScheduler_beginTurn");
+
+    // No other turn can begin until this one ends, so the tick action runs in the same place in every run
+    if (ticked) {
+        scheduler->tickAction(scheduler->tickActionArg);
+    }
+}
+
+/**
+ * End the given thread's turn.
+ *
+ * @param scheduler The DeterministicScheduler instance.
+ * @param threadIndex The index of the calling thread, whose turn it must be.
+ */
+void DeterministicScheduler_endTurn(DeterministicScheduler const scheduler, size_t const threadIndex) {
+    guardNotNull(scheduler, "scheduler", "DeterministicScheduler_endTurn");
+
+    safeMutexLock(&scheduler->mutex, "DeterministicScheduler_endTurn");
+    guardFmt(
+        scheduler->turnThreadIndex == threadIndex,
+        "DeterministicScheduler_endTurn: It is not thread %zu's turn",
+        threadIndex
+    );
+    scheduler->threads[threadIndex].clockNs = scheduler->clockNs;
+    scheduler->turnThreadIndex = NO_THREAD;
+    safeMutexUnlock(&scheduler->mutex, "DeterministicScheduler_endTurn");
+}
+
+/**
+ * Mark the given thread as finished. It will take no more turns.
+ *
+ * @param scheduler The DeterministicScheduler instance.
+ * @param threadIndex The index of the calling thread.
+ */
+void DeterministicScheduler_finish(DeterministicScheduler const scheduler, size_t const threadIndex) {
+    guardNotNull(scheduler, "scheduler", "DeterministicScheduler_finish");
+    guardFmt(
+        threadIndex < scheduler->threadCount,
+        "DeterministicScheduler_finish: Thread index %zu is out of range (thread count: %zu)",
+        threadIndex,
+        scheduler->threadCount
+    );
+
+    safeMutexLock(&scheduler->mutex, "DeterministicScheduler_finish");
+    guard(
+        scheduler->turnThreadIndex != threadIndex,
+        "DeterministicScheduler_finish: The thread must end its turn before finishing"
+    );
+    scheduler->threads[threadIndex].state = DeterministicSchedulerThreadState_finished;
+    DeterministicScheduler_chooseTurnIfReady(scheduler);
+    safeMutexUnlock(&scheduler->mutex, "DeterministicScheduler_finish");
+}
+
+/**
+ * If no turn is in progress and every unfinished thread is waiting, hand the next turn to the waiting thread with the
+ * earliest wake time. The scheduler's mutex must be held.
+ *
+ * @param scheduler The DeterministicScheduler instance.
+ */
+static void DeterministicScheduler_chooseTurnIfReady(DeterministicScheduler const scheduler) {
+    if (scheduler->turnThreadIndex != NO_THREAD) {
+        return;
+    }
+
+    size_t tiedThreadCount = 0;
+    uint64_t earliestWakeTimeNs = UINT64_MAX;
+    for (size_t i = 0; i < scheduler->threadCount; i += 1) {
+        struct DeterministicSchedulerThread const * const threadPtr = &scheduler->threads[i];
+        if (threadPtr->state == DeterministicSchedulerThreadState_running) {
+            return;
+        }
+        if (threadPtr->state != DeterministicSchedulerThreadState_waiting) {
+            continue;
+        }
+
+        if (threadPtr->wakeTimeNs < earliestWakeTimeNs) {
+            earliestWakeTimeNs = threadPtr->wakeTimeNs;
+            tiedThreadCount = 0;
+        }
+        if (threadPtr->wakeTimeNs == earliestWakeTimeNs) {
+            scheduler->tiedThreadIndexes[tiedThreadCount] = i;
+            tiedThreadCount += 1;
+        }
+    }
+    if (tiedThreadCount == 0) {
+        return;
+    }
+
+    size_t const tieIndex = (
+        tiedThreadCount == 1
+            ? 0
+            : (size_t)(randomStreamNext(&scheduler->tieBreakStream) % tiedThreadCount)
+    );
+    scheduler->turnThreadIndex = scheduler->tiedThreadIndexes[tieIndex];
+    safeConditionBroadcast(&scheduler->turnCondition, "DeterministicScheduler_chooseTurnIfReady");
+}
@@ -0,0 +1,503 @@
+#include "../../include/hw8/FrameNode.h"
+
+#include "../../include/hw8/PagePool.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+
+enum FrameNodeRequestType {
+    FrameNodeRequestType_borrow = 1,
+    FrameNodeRequestType_borrowEvicting = 2
+};
+
+/**
+ * A request sent by a client node to a daemon node: lend up to `count` page frames to the client. A borrowEvicting
+ * request may take frames away from the daemon node's owners if it has no unowned frames to spare.
+ */
+struct FrameNodeRequest {
+    uint32_t type;
+    uint32_t clientNodeIndex;
+    uint64_t count;
+};
+
+struct FrameNodeResponse {
+    uint64_t grantedCount;
+};
+
+struct FrameNodePeer {
+    size_t nodeIndex;
+    int fd;
+    pthread_mutex_t mutex;
+};
+
+struct FrameNodeFaultStats {
+    size_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+};
+
+/**
+ * Represents one memory node in a simulated cluster. Each node owns a PagePool and runs a daemon thread which serves
+ * frame borrowing requests from other nodes over a Unix domain socket. When one of the node's owners faults and the
+ * node's pool has no unowned frames, the node borrows a batch of frames from its peers, so that the next few faults
+ * are serviced without another round trip. Peers are first asked for spare unowned frames, and only then asked to
+ * evict.
+ */
+struct FrameNode {
+    size_t nodeIndex;
+    PagePool pool;
+    size_t borrowBatchSize;
+
+    char *socketPath;
+    int listenFd;
+    int stopPipeFds[2];
+    pthread_t daemonThreadId;
+
+    struct FrameNodePeer *peers;
+    size_t peerCount;
+    pthread_mutex_t borrowMutex;
+
+    struct FrameNodeFaultStats localFaultStats;
+    struct FrameNodeFaultStats remoteFaultStats;
+    pthread_mutex_t statsMutex;
+};
+
+static void *FrameNode_daemonThreadStart(void *argAsVoidPtr);
+static bool FrameNode_serveRequest(FrameNode node, int connectionFd);
+static size_t FrameNode_borrowFrames(FrameNode node);
+static size_t FrameNode_requestFrames(FrameNode node, struct FrameNodePeer *peerPtr, enum FrameNodeRequestType type);
+static void FrameNode_recordFault(FrameNode node, bool remote, uint64_t durationNs);
+static void sendMessage(int fd, void const *message, size_t messageSize, char const *callerDescription);
+static bool receiveMessage(int fd, void *message, size_t messageSize, char const *callerDescription);
+
+/**
+ * Start a FrameNode: bind its Unix domain socket and start its daemon thread.
+ *
+ * @param nodeIndex The index of the node in the cluster.
+ * @param pool The node's PagePool. Frames are added to and removed from it as they are borrowed and lent. The pool
+ *             must outlive the node and should not have a maximum page count.
+ * @param socketDirectoryPath The directory in which to create the node's socket.
+ * @param borrowBatchSize The number of frames to ask a peer for at a time.
+ *
+ * @returns The newly started FrameNode. The caller is responsible for stopping it, which frees its memory.
+ */
+FrameNode FrameNode_start(
+    size_t const nodeIndex,
+    PagePool const pool,
+    char const * const socketDirectoryPath,
+    size_t const borrowBatchSize
+) {
+    guardNotNull(pool, "pool", "FrameNode_start");
+    guardNotNull(socketDirectoryPath, "socketDirectoryPath", "FrameNode_start");
+    guard(borrowBatchSize > 0, "FrameNode_start: borrowBatchSize must be greater than 0");
+
+    FrameNode const node = safeMalloc(sizeof *node, "FrameNode_start");
+    node->nodeIndex = nodeIndex;
+    node->pool = pool;
+    node->borrowBatchSize = borrowBatchSize;
+    node->peers = NULL;
+    node->peerCount = 0;
+    safeMutexInit(&node->borrowMutex, NULL, "FrameNode_start");
+    node->localFaultStats = (struct FrameNodeFaultStats){.count = 0, .totalNs = 0, .maxNs = 0};
+    node->remoteFaultStats = (struct FrameNodeFaultStats){.count = 0, .totalNs = 0, .maxNs = 0};
+    safeMutexInit(&node->statsMutex, NULL, "FrameNode_start");
+
+    node->socketPath = formatString("%s/hw8-%ld-node%zu.sock", socketDirectoryPath, (long)getpid(), nodeIndex);
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    guardFmt(
+        strlen(node->socketPath) < sizeof address.sun_path,
+        "FrameNode_start: Socket path \"%s\" is too long",
+        node->socketPath
+    );
+    strcpy(address.sun_path, node->socketPath);
+    unlink(node->socketPath);
+
+    node->listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (
+        node->listenFd == -1
+        || bind(node->listenFd, (struct sockaddr const *)&address, sizeof address) == -1
+        || listen(node->listenFd, SOMAXCONN) == -1
+        || pipe(node->stopPipeFds) == -1
+    ) {
+        int const socketErrorCode = errno;
+        abortWithErrorFmt(
+            "FrameNode_start: Failed to listen on Unix domain socket \"%s\" (error code: %d; error message: \"%s\")",
+            node->socketPath,
+            socketErrorCode,
+            strerror(socketErrorCode)
+        );
+    }
+
+    node->daemonThreadId = safePthreadCreate(NULL, FrameNode_daemonThreadStart, node, "FrameNode_start");
+
+    return node;
+}
+
+/**
+ * Connect every node to every other node's socket. This must be called once, after all nodes have been started and
+ * before any of their owners access pages.
+ *
+ * @param nodes The nodes in the cluster.
+ * @param nodeCount The number of nodes.
+ */
+void FrameNode_connectPeers(FrameNode const * const nodes, size_t const nodeCount) {
+    guardNotNull(nodes, "nodes", "FrameNode_connectPeers");
+
+    for (size_t i = 0; i < nodeCount; i += 1) {
+        FrameNode const node = nodes[i];
+        guard(node->peers == NULL, "FrameNode_connectPeers: The nodes are already connected");
+
+        node->peerCount = nodeCount - 1;
+        node->peers = safeMalloc(sizeof *node->peers * (node->peerCount > 0 ? node->peerCount : 1), "FrameNode_connectPeers");
+        for (size_t j = 0; j < node->peerCount; j += 1) {
+            // Start with the next node so that borrowing is spread around the cluster
+            FrameNode const peerNode = nodes[(i + 1 + j) % nodeCount];
+            struct FrameNodePeer * const peerPtr = &node->peers[j];
+            peerPtr->nodeIndex = peerNode->nodeIndex;
+            safeMutexInit(&peerPtr->mutex, NULL, "FrameNode_connectPeers");
+
+            struct sockaddr_un address = {.sun_family = AF_UNIX};
+            strcpy(address.sun_path, peerNode->socketPath);
+
+            peerPtr->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (peerPtr->fd == -1 || connect(peerPtr->fd, (struct sockaddr const *)&address, sizeof address) == -1) {
+                int const connectErrorCode = errno;
+                abortWithErrorFmt(
+                    "FrameNode_connectPeers: Failed to connect to Unix domain socket \"%s\" (error code: %d; error message: \"%s\")",
+                    peerNode->socketPath,
+                    connectErrorCode,
+                    strerror(connectErrorCode)
+                );
+            }
+        }
+    }
+}
+
+/**
+ * Disconnect the node from its peers, stop its daemon thread, remove its socket, and free its memory. The node's pool
+ * is not destroyed.
+ *
+ * @param node The FrameNode instance.
+ */
+void FrameNode_stop(FrameNode const node) {
+    guardNotNull(node, "node", "FrameNode_stop");
+
+    for (size_t i = 0; i < node->peerCount; i += 1) {
+        close(node->peers[i].fd);
+        safeMutexDestroy(&node->peers[i].mutex, "FrameNode_stop");
+    }
+    free(node->peers);
+
+    while (write(node->stopPipeFds[1], "", 1) == -1 && errno == EINTR) {
+        // Retry
+    }
+    safePthreadJoin(node->daemonThreadId, "FrameNode_stop");
+
+    close(node->stopPipeFds[0]);
+    close(node->stopPipeFds[1]);
+    close(node->listenFd);
+    unlink(node->socketPath);
+    free(node->socketPath);
+
+    safeMutexDestroy(&node->borrowMutex, "FrameNode_stop");
+    safeMutexDestroy(&node->statsMutex, "FrameNode_stop");
+    free(node);
+}
+
+/**
+ * Get the node's PagePool.
+ *
+ * @param node The FrameNode instance.
+ *
+ * @returns The PagePool.
+ */
+PagePool FrameNode_pool(FrameNode const node) {
+    guardNotNull(node, "node", "FrameNode_pool");
+    return node->pool;
+}
+
+/**
+ * Access the pages of one of the node's owners, as PagePool_access does. If the access will fault and the node's pool
+ * has no unowned frames, frames are first borrowed from a peer node. The time taken to service each fault is recorded
+ * as either local or remote.
+ *
+ * @param node The FrameNode instance.
+ * @param ownerIndex The index of the owner in the node's pool.
+ * @param requireAdditionalPage Whether to load an additional page even if the owner already has pages in memory.
+ * @param access How the owner's pages are accessed.
+ *
+ * @returns Whether a page fault occurred.
+ */
+bool FrameNode_access(
+    FrameNode const node,
+    size_t const ownerIndex,
+    bool const requireAdditionalPage,
+    enum PageAccess const access
+) {
+    guardNotNull(node, "node", "FrameNode_access");
+
+    uint64_t const startNs = safeMonotonicTimeNs("FrameNode_access");
+
+    size_t borrowedCount = 0;
+    bool const expectPageFault = requireAdditionalPage || PagePool_ownedPageCount(node->pool, ownerIndex) == 0;
+    if (expectPageFault && PagePool_unownedPageCount(node->pool) == 0) {
+        borrowedCount = FrameNode_borrowFrames(node);
+    }
+
+    bool const pageFault = PagePool_access(node->pool, ownerIndex, requireAdditionalPage, access);
+
+    if (pageFault) {
+        FrameNode_recordFault(node, borrowedCount > 0, safeMonotonicTimeNs("FrameNode_access") - startNs);
+    }
+
+    return pageFault;
+}
+
+/**
+ * Print the node's fault latency statistics, split into faults serviced locally and faults which needed frames to be
+ * borrowed from a peer.
+ *
+ * @param node The FrameNode instance.
+ */
+void FrameNode_printStats(FrameNode const node) {
+    guardNotNull(node, "node", "FrameNode_printStats");
+
+    safeMutexLock(&node->statsMutex, "FrameNode_printStats");
+    struct FrameNodeFaultStats const * const statsPtrs[] = {&node->localFaultStats, &node->remoteFaultStats};
+    char const * const statsNames[] = {"local", "remote"};
+    printf("Node %zu: %zu pages;", node->nodeIndex, PagePool_pageCount(node->pool));
+    for (size_t i = 0; i < 2; i += 1) {
+        struct FrameNodeFaultStats const * const statsPtr = statsPtrs[i];
+        printf(
+            " %zu %s faults (mean %.1f us, max %.1f us)%s",
+            statsPtr->count,
+            statsNames[i],
+            statsPtr->count == 0 ? 0 : (double)statsPtr->totalNs / (double)statsPtr->count / 1000,
+            (double)statsPtr->maxNs / 1000,
+            i == 0 ? "," : "\n"
+        );
+    }
+    safeMutexUnlock(&node->statsMutex, "FrameNode_printStats");
+}
+
+static void *FrameNode_daemonThreadStart(void * const argAsVoidPtr) {
+    guardNotNull(argAsVoidPtr, "argAsVoidPtr", "FrameNode_daemonThreadStart");
+    FrameNode const node = argAsVoidPtr;
+
+    size_t pollFdCount = 2;
+    struct pollfd *pollFds = safeMalloc(sizeof *pollFds * pollFdCount, "FrameNode_daemonThreadStart");
+    pollFds[0] = (struct pollfd){.fd = node->stopPipeFds[0], .events = POLLIN, .revents = 0};
+    pollFds[1] = (struct pollfd){.fd = node->listenFd, .events = POLLIN, .revents = 0};
+
+    while (true) {
+        if (poll(pollFds, pollFdCount, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            int const pollErrorCode = errno;
+            abortWithErrorFmt(
+                "FrameNode_daemonThreadStart: Failed to wait for requests using poll (error code: %d; error message: \"%s\")",
+                pollErrorCode,
+                strerror(pollErrorCode)
+            );
+        }
+
+        if (pollFds[0].revents != 0) {
+            break;
+        }
+
+        for (size_t i = 2; i < pollFdCount; i += 1) {
+            if (pollFds[i].revents == 0) {
+                continue;
+            }
+
+            if (!FrameNode_serveRequest(node, pollFds[i].fd)) {
+                close(pollFds[i].fd);
+                pollFds[i] = pollFds[pollFdCount - 1];
+                pollFdCount -= 1;
+                i -= 1;
+            }
+        }
+
+        if (pollFds[1].revents != 0) {
+            int const connectionFd = accept(node->listenFd, NULL, NULL);
+            if (connectionFd != -1) {
+                pollFdCount += 1;
+                pollFds = safeRealloc(pollFds, sizeof *pollFds * pollFdCount, "FrameNode_daemonThreadStart");
+                pollFds[pollFdCount - 1] = (struct pollfd){.fd = connectionFd, .events = POLLIN, .revents = 0};
+            }
+        }
+    }
+
+    for (size_t i = 2; i < pollFdCount; i += 1) {
+        close(pollFds[i].fd);
+    }
+    free(pollFds);
+
+    return NULL;
+}
+
+/**
+ * Serve one request from a connected client node.
+ *
+ * @returns Whether the connection is still open.
+ */
+static bool FrameNode_serveRequest(FrameNode const node, int const connectionFd) {
+    struct FrameNodeRequest request;
+    if (!receiveMessage(connectionFd, &request, sizeof request, "FrameNode_serveRequest")) {
+        return false;
+    }
+
+    size_t const requestedCount = (size_t)request.count;
+    size_t grantedCount = PagePool_shrinkUnowned(node->pool, requestedCount);
+    if (request.type == FrameNodeRequestType_borrowEvicting && grantedCount < requestedCount) {
+        grantedCount += PagePool_shrink(node->pool, requestedCount - grantedCount);
+    }
+    if (grantedCount > 0) {
+        printf("Node %zu lending %zu pages to node %u\n", node->nodeIndex, grantedCount, request.clientNodeIndex);
+    }
+
+    struct FrameNodeResponse const response = {.grantedCount = grantedCount};
+    sendMessage(connectionFd, &response, sizeof response, "FrameNode_serveRequest");
+    return true;
+}
+
+/**
+ * Borrow a batch of frames from the node's peers into its pool, unless another thread has already done so. Peers are
+ * asked for unowned frames first; if none has any to spare, the first peer able to evict is asked to.
+ *
+ * @returns The number of frames borrowed.
+ */
+static size_t FrameNode_borrowFrames(FrameNode const node) {
+    safeMutexLock(&node->borrowMutex, "FrameNode_borrowFrames");
+
+    size_t borrowedCount = 0;
+    if (PagePool_unownedPageCount(node->pool) == 0) {
+        enum FrameNodeRequestType const requestTypes[] = {
+            FrameNodeRequestType_borrow,
+            FrameNodeRequestType_borrowEvicting
+        };
+        for (size_t i = 0; borrowedCount == 0 && i < 2; i += 1) {
+            for (size_t j = 0; borrowedCount == 0 && j < node->peerCount; j += 1) {
+                borrowedCount = FrameNode_requestFrames(node, &node->peers[j], requestTypes[i]);
+            }
+        }
+
+        if (borrowedCount > 0) {
+            PagePool_grow(node->pool, borrowedCount);
+        }
+    }
+
+    safeMutexUnlock(&node->borrowMutex, "FrameNode_borrowFrames");
+
+    return borrowedCount;
+}
+
+static size_t FrameNode_requestFrames(
+    FrameNode const node,
+    struct FrameNodePeer * const peerPtr,
+    enum FrameNodeRequestType const type
+) {
+    struct FrameNodeRequest const request = {
+        .type = (uint32_t)type,
+        .clientNodeIndex = (uint32_t)node->nodeIndex,
+        .count = node->borrowBatchSize
+    };
+    struct FrameNodeResponse response;
+
+    safeMutexLock(&peerPtr->mutex, "FrameNode_requestFrames");
+    sendMessage(peerPtr->fd, &request, sizeof request, "FrameNode_requestFrames");
+    bool const received = receiveMessage(peerPtr->fd, &response, sizeof response, "FrameNode_requestFrames");
+    safeMutexUnlock(&peerPtr->mutex, "FrameNode_requestFrames");
+
+    guardFmt(received, "FrameNode_requestFrames: Node %zu closed the connection", peerPtr->nodeIndex);
+    return (size_t)response.grantedCount;
+}
+
+static void FrameNode_recordFault(FrameNode const node, bool const remote, uint64_t const durationNs) {
+    safeMutexLock(&node->statsMutex, "FrameNode_recordFault");
+    struct FrameNodeFaultStats * const statsPtr = remote ? &node->remoteFaultStats : &node->localFaultStats;
+    statsPtr->count += 1;
+    statsPtr->totalNs += durationNs;
+    if (durationNs > statsPtr->maxNs) {
+        statsPtr->maxNs = durationNs;
+    }
+    safeMutexUnlock(&node->statsMutex, "FrameNode_recordFault");
+}
+
+static void sendMessage(
+    int const fd,
+    void const * const message,
+    size_t const messageSize,
+    char const * const callerDescription
+) {
+    while (true) {
+        ssize_t const sentSize = send(fd, message, messageSize, MSG_NOSIGNAL);
+        if (sentSize == (ssize_t)messageSize) {
+            return;
+        }
+        if (sentSize == -1 && errno == EINTR) {
+            continue;
+        }
+
+        int const sendErrorCode = errno;
+        abortWithErrorFmt(
+            "%s: Failed to send %zu-byte message using send (error code: %d; error message: \"%s\")",
+            callerDescription,
+            messageSize,
+            sendErrorCode,
+            strerror(sendErrorCode)
+        );
+    }
+}
+
+/**
+ * Receive one message of the given size.
+ *
+ * @returns True if the message was received, or false if the peer closed the connection.
+ */
+static bool receiveMessage(
+    int const fd,
+    void * const message,
+    size_t const messageSize,
+    char const * const callerDescription
+) {
+    while (true) {
+        ssize_t const receivedSize = recv(fd, message, messageSize, 0);
+        if (receivedSize == (ssize_t)messageSize) {
+            return true;
+        }
+        if (receivedSize == 0) {
+            return false;
+        }
+        if (receivedSize == -1 && errno == EINTR) {
+            continue;
+        }
+
+        int const recvErrorCode = errno;
+        abortWithErrorFmt(
+            "%s: Failed to receive %zu-byte message using recv (received: %zd; error code: %d; error message: \"%s\")",
+            callerDescription,
+            messageSize,
+            receivedSize,
+            recvErrorCode,
+            strerror(recvErrorCode)
+        );
+    }
+}
@@ -0,0 +1,530 @@
+#include "../../include/hw8/Journal.h"
+
+#include "../../include/util/Histogram.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define JOURNAL_INITIAL_CAPACITY 64
+
+/**
+ * A batch of journal entries, with the time each was appended.
+ */
+struct JournalBatch {
+    struct JournalEntry *entries;
+    uint64_t *appendTimesNs;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * Represents an append-only journal file of applied sections with group commit. Appending only queues an entry; a
+ * dedicated writer thread writes every queued entry in one write and makes them durable with one fdatasync, then wakes
+ * the threads waiting for them. Once an entry is queued, the writer waits up to the group commit window for more
+ * entries to join the batch, unless the batch is already full.
+ */
+struct Journal {
+    char *filePath;
+    int fd;
+    struct JournalOptions options;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t appendedCondition;
+    pthread_cond_t durableCondition;
+    struct JournalBatch pendingBatch;
+    struct JournalBatch writingBatch;
+    uint64_t appendedSequenceNumber;
+    uint64_t durableSequenceNumber;
+    bool stopping;
+
+    uint64_t entryCount;
+    uint64_t batchCount;
+    Histogram batchSizes;
+    Histogram commitLatenciesNs;
+
+    pthread_t writerThreadId;
+};
+
+static void *Journal_writerThreadStart(void *journalAsVoidPtr);
+static void Journal_waitForBatch(Journal journal);
+static uint64_t Journal_openExisting(Journal journal);
+static void Journal_write(Journal journal, void const *data, size_t length);
+static void Journal_guardHeader(struct JournalFileHeader const *headerPtr, char const *filePath, char const *caller);
+static void Journal_initializeBatch(struct JournalBatch *batchPtr);
+static void Journal_destroyBatch(struct JournalBatch *batchPtr);
+
+/**
+ * Create a journal file, replacing any existing file, and start its writer thread.
+ *
+ * @param filePath The path of the journal file.
+ * @param optionsPtr The journal options. A group commit window of 0 writes each batch as soon as the writer is free,
+ *                   and a maximum batch size of 0 never cuts the window short. If append is set, an existing journal
+ *                   file is kept and appended to instead, after dropping any partly written entry at its end, and
+ *                   sequence numbers continue from its entry count; its run ID must then match runId. A new journal
+ *                   file is stamped with runId, which must not be 0.
+ *
+ * @returns The newly started Journal. The caller is responsible for stopping it, which frees its memory.
+ */
+Journal Journal_start(char const * const filePath, struct JournalOptions const * const optionsPtr) {
+    guardNotNull(filePath, "filePath", "Journal_start");
+    guardNotNull(optionsPtr, "optionsPtr", "Journal_start");
+    guard(optionsPtr->runId != 0, "Journal_start: runId must not be 0");
+
+    int const fd = open(filePath, O_RDWR | O_CREAT | (optionsPtr->append ? 0 : O_TRUNC) | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        int const openErrorCode = errno;
+        abortWithErrorFmt(
+            "Journal_start: Failed to open \"%s\" using open (error code: %d; error message: \"%s\")",
+            filePath,
+            openErrorCode,
+            strerror(openErrorCode)
+        );
+    }
+
+    Journal const journal = safeMalloc(sizeof *journal, "Journal_start");
+    journal->filePath = safeMalloc(strlen(filePath) + 1, "Journal_start");
+    strcpy(journal->filePath, filePath);
+    journal->fd = fd;
+    journal->options = *optionsPtr;
+
+    safeMutexInit(&journal->mutex, NULL, "Journal_start");
+    safeConditionInit(&journal->appendedCondition, NULL, "Journal_start");
+    safeConditionInit(&journal->durableCondition, NULL, "Journal_start");
+    Journal_initializeBatch(&journal->pendingBatch);
+    Journal_initializeBatch(&journal->writingBatch);
+    journal->appendedSequenceNumber = 0;
+    journal->durableSequenceNumber = 0;
+    journal->stopping = false;
+
+    journal->entryCount = 0;
+    journal->batchCount = 0;
+    journal->batchSizes = Histogram_create();
+    journal->commitLatenciesNs = Histogram_create();
+
+    uint64_t const existingEntryCount = Journal_openExisting(journal);
+    journal->appendedSequenceNumber = existingEntryCount;
+    journal->durableSequenceNumber = existingEntryCount;
+
+    journal->writerThreadId = safePthreadCreate(NULL, Journal_writerThreadStart, journal, "Journal_start");
+    return journal;
+}
+
+/**
+ * Make every appended entry durable, stop the writer thread, close the journal file and free the memory associated
+ * with the Journal.
+ *
+ * @param journal The Journal instance.
+ */
+void Journal_stop(Journal const journal) {
+    guardNotNull(journal, "journal", "Journal_stop");
+
+    safeMutexLock(&journal->mutex, "Journal_stop");
+    journal->stopping = true;
+    safeConditionSignal(&journal->appendedCondition, "Journal_stop");
+    safeMutexUnlock(&journal->mutex, "Journal_stop");
+    safePthreadJoin(journal->writerThreadId, "Journal_stop");
+
+    if (close(journal->fd) == -1) {
+        int const closeErrorCode = errno;
+        abortWithErrorFmt(
+            "Journal_stop: Failed to close \"%s\" using close (error code: %d; error message: \"%s\")",
+            journal->filePath,
+            closeErrorCode,
+            strerror(closeErrorCode)
+        );
+    }
+
+    Histogram_destroy(journal->commitLatenciesNs);
+    Histogram_destroy(journal->batchSizes);
+    Journal_destroyBatch(&journal->writingBatch);
+    Journal_destroyBatch(&journal->pendingBatch);
+    safeConditionDestroy(&journal->durableCondition, "Journal_stop");
+    safeConditionDestroy(&journal->appendedCondition, "Journal_stop");
+    safeMutexDestroy(&journal->mutex, "Journal_stop");
+    free(journal->filePath);
+    free(journal);
+}
+
+/**
+ * Queue an entry to be written to the journal. Entries are written in the order they are appended, so a caller which
+ * needs the journal to follow the balance must append while it holds the balance lock.
+ *
+ * @param journal The Journal instance.
+ * @param entryPtr The entry.
+ *
+ * @returns The sequence number of the entry, to wait for with Journal_waitDurable.
+ */
+uint64_t Journal_append(Journal const journal, struct JournalEntry const * const entryPtr) {
+    guardNotNull(journal, "journal", "Journal_append");
+    guardNotNull(entryPtr, "entryPtr", "Journal_append");
+
+    uint64_t const appendTimeNs = safeMonotonicTimeNs("Journal_append");
+
+    safeMutexLock(&journal->mutex, "Journal_append");
+    struct JournalBatch * const batchPtr = &journal->pendingBatch;
+    if (batchPtr->count == batchPtr->capacity) {
+        batchPtr->capacity *= 2;
+        batchPtr->entries = safeRealloc(
+            batchPtr->entries,
+            sizeof *batchPtr->entries * batchPtr->capacity,
+            "Journal_append"
+        );
+        batchPtr->appendTimesNs = safeRealloc(
+            batchPtr->appendTimesNs,
+            sizeof *batchPtr->appendTimesNs * batchPtr->capacity,
+            "Journal_append"
+        );
+    }
+    batchPtr->entries[batchPtr->count] = *entryPtr;
+    batchPtr->appendTimesNs[batchPtr->count] = appendTimeNs;
+    batchPtr->count += 1;
+
+    journal->appendedSequenceNumber += 1;
+    uint64_t const sequenceNumber = journal->appendedSequenceNumber;
+    safeConditionSignal(&journal->appendedCondition, "Journal_append");
+    safeMutexUnlock(&journal->mutex, "Journal_append");
+
+    return sequenceNumber;
+}
+
+/**
+ * Wait until the entry with the given sequence number, and every entry before it, is durable.
+ *
+ * @param journal The Journal instance.
+ * @param sequenceNumber The sequence number returned by Journal_append.
+ */
+void Journal_waitDurable(Journal const journal, uint64_t const sequenceNumber) {
+    guardNotNull(journal, "journal", "Journal_waitDurable");
+
+    safeMutexLock(&journal->mutex, "Journal_waitDurable");
+    while (journal->durableSequenceNumber < sequenceNumber) {
+        safeConditionWait(&journal->durableCondition, &journal->mutex, "Journal_waitDurable");
+    }
+    safeMutexUnlock(&journal->mutex, "Journal_waitDurable");
+}
+
+/**
+ * Print the number of entries and batches written, and the distributions of batch size and of commit latency: the
+ * time from appending an entry until it was durable.
+ *
+ * @param journal The Journal instance.
+ * @param file The file to print to.
+ */
+void Journal_printStats(Journal const journal, FILE * const file) {
+    guardNotNull(journal, "journal", "Journal_printStats");
+    guardNotNull(file, "file", "Journal_printStats");
+
+    safeMutexLock(&journal->mutex, "Journal_printStats");
+    fprintf(
+        file,
+        "Journal: %llu entries made durable in %llu batches\n",
+        (unsigned long long)journal->entryCount,
+        (unsigned long long)journal->batchCount
+    );
+    ConstHistogram const histograms[] = {journal->batchSizes, journal->commitLatenciesNs};
+    char const * const descriptions[] = {"Journal batch size (entries)", "Journal commit latency (ns)"};
+    for (size_t i = 0; i < 2; i += 1) {
+        fprintf(
+            file,
+            "%s: count=%llu, p50=%llu, p99=%llu, p999=%llu, max=%llu\n",
+            descriptions[i],
+            (unsigned long long)Histogram_count(histograms[i]),
+            (unsigned long long)Histogram_valueAtPermille(histograms[i], 500),
+            (unsigned long long)Histogram_valueAtPermille(histograms[i], 990),
+            (unsigned long long)Histogram_valueAtPermille(histograms[i], 999),
+            (unsigned long long)Histogram_max(histograms[i])
+        );
+    }
+    safeMutexUnlock(&journal->mutex, "Journal_printStats");
+}
+
+/**
+ * Read the entries of a journal file from the given entry on, for replaying the part of it after a checkpoint. A partly
+ * written entry at the end of the file is ignored, and a partly written header is read as an empty journal.
+ *
+ * @param filePath The path of the journal file.
+ * @param runId The ID of the run the journal must belong to, or 0 to accept any run.
+ * @param firstEntryIndex The index of the first entry to read. The journal must have at least this many entries; if
+ *                        it is 0, the journal file may also not exist.
+ * @param runIdOutPtr Where to store the ID of the run the journal belongs to, or 0 if it has no header.
+ * @param entryCountOutPtr Where to store the number of entries read.
+ *
+ * @returns The newly allocated entries, or null if there are none. The caller is responsible for freeing this memory.
+ */
+struct JournalEntry *readJournalEntries(
+    char const * const filePath,
+    uint64_t const runId,
+    uint64_t const firstEntryIndex,
+    uint64_t * const runIdOutPtr,
+    size_t * const entryCountOutPtr
+) {
+    guardNotNull(filePath, "filePath", "readJournalEntries");
+    guardNotNull(runIdOutPtr, "runIdOutPtr", "readJournalEntries");
+    guardNotNull(entryCountOutPtr, "entryCountOutPtr", "readJournalEntries");
+
+    *runIdOutPtr = 0;
+    *entryCountOutPtr = 0;
+    FILE * const journalFile = fopen(filePath, "rb");
+    if (journalFile == NULL) {
+        int const fopenErrorCode = errno;
+        if (fopenErrorCode == ENOENT && firstEntryIndex == 0) {
+            return NULL;
+        }
+        abortWithErrorFmt(
+            "readJournalEntries: Failed to open \"%s\" using fopen (error code: %d; error message: \"%s\")",
+            filePath,
+            fopenErrorCode,
+            strerror(fopenErrorCode)
+        );
+    }
+
+    struct stat journalStat;
+    if (fstat(fileno(journalFile), &journalStat) == -1) {
+        abortWithErrorFmt("readJournalEntries: Failed to get the size of \"%s\"", filePath);
+    }
+
+    // A journal cut short within its header, by a crash while it was being started, has no entries
+    struct JournalFileHeader header;
+    uint64_t entryCount = 0;
+    if ((uint64_t)journalStat.st_size >= sizeof header) {
+        if (fread(&header, sizeof header, 1, journalFile) != 1) {
+            abortWithErrorFmt("readJournalEntries: Failed to read the header of \"%s\"", filePath);
+        }
+        Journal_guardHeader(&header, filePath, "readJournalEntries");
+        if (runId != 0 && header.runId != runId) {
+            abortWithErrorFmt(
+                "readJournalEntries: \"%s\" belongs to another run than the checkpoint (run ID: %016llx; expected: %016llx)",
+                filePath,
+                (unsigned long long)header.runId,
+                (unsigned long long)runId
+            );
+        }
+        *runIdOutPtr = header.runId;
+        entryCount = ((uint64_t)journalStat.st_size - sizeof header) / sizeof(struct JournalEntry);
+    }
+    if (entryCount < firstEntryIndex) {
+        abortWithErrorFmt(
+            "readJournalEntries: \"%s\" ends before entry %llu (entry count: %llu)",
+            filePath,
+            (unsigned long long)firstEntryIndex,
+            (unsigned long long)entryCount
+        );
+    }
+
+    size_t const readEntryCount = (size_t)(entryCount - firstEntryIndex);
+    struct JournalEntry *entries = NULL;
+    if (readEntryCount > 0) {
+        entries = safeMalloc(sizeof *entries * readEntryCount, "readJournalEntries");
+        bool const read = (
+            fseeko(journalFile, (off_t)(sizeof header + firstEntryIndex * sizeof *entries), SEEK_SET) == 0
+            && fread(entries, sizeof *entries, readEntryCount, journalFile) == readEntryCount
+        );
+        if (!read) {
+            abortWithErrorFmt("readJournalEntries: Failed to read the entries of \"%s\"", filePath);
+        }
+    }
+    fclose(journalFile);
+
+    *entryCountOutPtr = readEntryCount;
+    return entries;
+}
+
+static void *Journal_writerThreadStart(void * const journalAsVoidPtr) {
+    Journal const journal = journalAsVoidPtr;
+
+    safeMutexLock(&journal->mutex, "Journal_writerThreadStart");
+    while (true) {
+        Journal_waitForBatch(journal);
+        if (journal->pendingBatch.count == 0) {
+            break;
+        }
+
+        // Swap the batches, so that appending continues into the other one while this one is written
+        struct JournalBatch const batch = journal->pendingBatch;
+        journal->pendingBatch = journal->writingBatch;
+        journal->pendingBatch.count = 0;
+        journal->writingBatch = batch;
+        uint64_t const batchSequenceNumber = journal->appendedSequenceNumber;
+        safeMutexUnlock(&journal->mutex, "Journal_writerThreadStart");
+
+        Journal_write(journal, batch.entries, sizeof *batch.entries * batch.count);
+        if (fdatasync(journal->fd) == -1) {
+            int const fdatasyncErrorCode = errno;
+            abortWithErrorFmt(
+                "Journal_writerThreadStart: Failed to sync \"%s\" using fdatasync"
+                " (error code: %d; error message: \"%s\")",
+                journal->filePath,
+                fdatasyncErrorCode,
+                strerror(fdatasyncErrorCode)
+            );
+        }
+        uint64_t const durableTimeNs = safeMonotonicTimeNs("Journal_writerThreadStart");
+
+        safeMutexLock(&journal->mutex, "Journal_writerThreadStart");
+        journal->durableSequenceNumber = batchSequenceNumber;
+        journal->entryCount += (uint64_t)batch.count;
+        journal->batchCount += 1;
+        Histogram_record(journal->batchSizes, (uint64_t)batch.count);
+        for (size_t i = 0; i < batch.count; i += 1) {
+            Histogram_record(journal->commitLatenciesNs, durableTimeNs - batch.appendTimesNs[i]);
+        }
+        safeConditionBroadcast(&journal->durableCondition, "Journal_writerThreadStart");
+    }
+    safeMutexUnlock(&journal->mutex, "Journal_writerThreadStart");
+
+    return NULL;
+}
+
+static void Journal_waitForBatch(Journal const journal) {
+    while (journal->pendingBatch.count == 0 && !journal->stopping) {
+        safeConditionWait(&journal->appendedCondition, &journal->mutex, "Journal_writerThreadStart");
+    }
+    if (journal->pendingBatch.count == 0 || journal->options.groupCommitWindowUs == 0) {
+        return;
+    }
+
+    // Give other threads the rest of the window to join the batch
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t const deadlineNs = (uint64_t)deadline.tv_nsec + (uint64_t)journal->options.groupCommitWindowUs * 1000;
+    deadline.tv_sec += (time_t)(deadlineNs / 1000000000);
+    deadline.tv_nsec = (long)(deadlineNs % 1000000000);
+
+    size_t const maxBatchSize = journal->options.maxBatchSize;
+    while (!journal->stopping && (maxBatchSize == 0 || journal->pendingBatch.count < maxBatchSize)) {
+        bool const signaled = safeConditionTimedWait(
+            &journal->appendedCondition,
+            &journal->mutex,
+            &deadline,
+            "Journal_writerThreadStart"
+        );
+        if (!signaled) {
+            break;
+        }
+    }
+}
+
+/**
+ * Write the header of a new or empty journal file, or check the header of an existing one and cut it back to whole
+ * entries.
+ *
+ * @returns The number of entries already in the journal.
+ */
+static uint64_t Journal_openExisting(Journal const journal) {
+    struct stat journalStat;
+    if (fstat(journal->fd, &journalStat) == -1) {
+        int const fstatErrorCode = errno;
+        abortWithErrorFmt(
+            "Journal_start: Failed to get the size of \"%s\" using fstat (error code: %d; error message: \"%s\")",
+            journal->filePath,
+            fstatErrorCode,
+            strerror(fstatErrorCode)
+        );
+    }
+
+    // A crash while the header was being written leaves part of it, which is treated as an empty journal
+    if ((uint64_t)journalStat.st_size < sizeof(struct JournalFileHeader)) {
+        if (journalStat.st_size > 0 && ftruncate(journal->fd, 0) == -1) {
+            int const ftruncateErrorCode = errno;
+            abortWithErrorFmt(
+                "Journal_start: Failed to truncate \"%s\" using ftruncate (error code: %d; error message: \"%s\")",
+                journal->filePath,
+                ftruncateErrorCode,
+                strerror(ftruncateErrorCode)
+            );
+        }
+        struct JournalFileHeader header = {.version = JOURNAL_VERSION, .reserved = 0, .runId = journal->options.runId};
+        memcpy(header.magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH);
+        Journal_write(journal, &header, sizeof header);
+        return 0;
+    }
+
+    struct JournalFileHeader header;
+    if (pread(journal->fd, &header, sizeof header, 0) != (ssize_t)sizeof header) {
+        abortWithErrorFmt("Journal_start: Failed to read the header of \"%s\"", journal->filePath);
+    }
+    Journal_guardHeader(&header, journal->filePath, "Journal_start");
+    if (header.runId != journal->options.runId) {
+        abortWithErrorFmt(
+            "Journal_start: \"%s\" belongs to another run (run ID: %016llx; expected: %016llx)",
+            journal->filePath,
+            (unsigned long long)header.runId,
+            (unsigned long long)journal->options.runId
+        );
+    }
+
+    // A crash can leave part of an entry which was never made durable; it is dropped before appending
+    uint64_t const entryCount = ((uint64_t)journalStat.st_size - sizeof header) / sizeof(struct JournalEntry);
+    off_t const entriesEnd = (off_t)(sizeof header + entryCount * sizeof(struct JournalEntry));
+    if (entriesEnd != journalStat.st_size && ftruncate(journal->fd, entriesEnd) == -1) {
+        int const ftruncateErrorCode = errno;
+        abortWithErrorFmt(
+            "Journal_start: Failed to truncate \"%s\" using ftruncate (error code: %d; error message: \"%s\")",
+            journal->filePath,
+            ftruncateErrorCode,
+            strerror(ftruncateErrorCode)
+        );
+    }
+    return entryCount;
+}
+
+static void Journal_guardHeader(
+    struct JournalFileHeader const * const headerPtr,
+    char const * const filePath,
+    char const * const callerDescription
+) {
+    bool const valid = (
+        memcmp(headerPtr->magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH) == 0
+        && headerPtr->version == JOURNAL_VERSION
+    );
+    if (!valid) {
+        abortWithErrorFmt("%s: \"%s\" is not a version %d journal", callerDescription, filePath, JOURNAL_VERSION);
+    }
+}
+
+static void Journal_write(Journal const journal, void const * const data, size_t const length) {
+    char const * const chars = data;
+    size_t writtenLength = 0;
+    while (writtenLength < length) {
+        ssize_t const result = write(journal->fd, chars + writtenLength, length - writtenLength);
+        if (result == -1) {
+            int const writeErrorCode = errno;
+            if (writeErrorCode == EINTR) {
+                continue;
+            }
+            abortWithErrorFmt(
+                "Journal_write: Failed to write \"%s\" using write (error code: %d; error message: \"%s\")",
+                journal->filePath,
+                writeErrorCode,
+                strerror(writeErrorCode)
+            );
+        }
+        writtenLength += (size_t)result;
+    }
+}
+
+static void Journal_initializeBatch(struct JournalBatch * const batchPtr) {
+    batchPtr->capacity = JOURNAL_INITIAL_CAPACITY;
+    batchPtr->count = 0;
+    batchPtr->entries = safeMalloc(sizeof *batchPtr->entries * batchPtr->capacity, "Journal_start");
+    batchPtr->appendTimesNs = safeMalloc(sizeof *batchPtr->appendTimesNs * batchPtr->capacity, "Journal_start");
+}
+
+static void Journal_destroyBatch(struct JournalBatch * const batchPtr) {
+    free(batchPtr->appendTimesNs);
+    free(batchPtr->entries);
+}
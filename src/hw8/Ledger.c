@@ -0,0 +1,365 @@
+#include "../../include/hw8/Ledger.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/hash.h"
+#include "../../include/util/cents.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define LEDGER_CACHE_LINE_SIZE 64
+
+// A slot's key is its account ID plus one, so that an empty slot is zero
+#define LEDGER_EMPTY_KEY UINT64_C(0)
+
+/**
+ * A slot of the hash table. Its key is claimed with a compare-and-swap, so accounts in different stripes can be added
+ * at the same time, while its balance is only read or changed under the lock of its account's stripe.
+ */
+struct LedgerSlot {
+    uint64_t key;
+    int64_t balanceCents;
+};
+
+/**
+ * A lock stripe and how often it was locked, padded to a cache line so threads locking neighbouring stripes do not
+ * contend for the same line.
+ */
+struct LedgerStripe {
+    pthread_mutex_t mutex;
+    uint64_t acquisitionCount;
+    uint64_t contendedAcquisitionCount;
+    char padding[LEDGER_CACHE_LINE_SIZE - (sizeof (pthread_mutex_t) + 2 * sizeof (uint64_t)) % LEDGER_CACHE_LINE_SIZE];
+};
+
+/**
+ * An account and its balance, as listed by Ledger_balances.
+ */
+struct LedgerAccount {
+    uint64_t accountId;
+    int64_t balanceCents;
+};
+
+/**
+ * Represents the balances of many accounts, in an open-addressing hash table with linear probing keyed by account ID.
+ * The accounts are spread across lock stripes by a hash of their ID, independent of the slot they sit in. Applying a
+ * section locks only the stripes of the accounts it touches, in ascending order, so sections touching accounts in
+ * different stripes are applied in parallel while each section is still applied to all of its accounts at once. The
+ * table has a fixed number of slots, at least twice the account capacity, so it is never resized under a stripe lock
+ * and a probe always reaches an empty slot.
+ */
+struct Ledger {
+    struct LedgerSlot *slots;
+    size_t slotMask;
+    size_t accountCapacity;
+    size_t accountCount;
+
+    struct LedgerStripe *stripes;
+    size_t stripeCount;
+};
+
+static uint64_t Ledger_hash(uint64_t accountId);
+static size_t Ledger_stripeIndex(Ledger ledger, uint64_t accountHash);
+static struct LedgerSlot *Ledger_findSlot(Ledger ledger, uint64_t accountId, uint64_t accountHash, bool add);
+static void Ledger_lockStripe(Ledger ledger, size_t stripeIndex);
+static int Ledger_compareAccounts(void const *firstAccountAsVoidPtr, void const *secondAccountAsVoidPtr);
+
+/**
+ * Create an empty ledger, in which every account has a balance of zero.
+ *
+ * @param accountCapacity The most accounts the ledger can hold. Applying a section to any more aborts the program.
+ * @param stripeCount The number of lock stripes, from 1 to LEDGER_MAX_STRIPE_COUNT. Sections touching accounts in
+ *                    different stripes are applied in parallel.
+ *
+ * @returns The newly created Ledger. The caller is responsible for freeing it with Ledger_destroy.
+ */
+Ledger Ledger_create(size_t const accountCapacity, size_t const stripeCount) {
+    guard(accountCapacity > 0, "Ledger_create: The account capacity must be positive");
+    guard(
+        accountCapacity <= SIZE_MAX / 4 / sizeof (struct LedgerSlot),
+        "Ledger_create: The account capacity is too large"
+    );
+    guard(
+        stripeCount > 0 && stripeCount <= LEDGER_MAX_STRIPE_COUNT,
+        "Ledger_create: The stripe count must be from 1 to LEDGER_MAX_STRIPE_COUNT"
+    );
+
+    size_t slotCount = 1;
+    while (slotCount < accountCapacity * 2) {
+        slotCount *= 2;
+    }
+
+    Ledger const ledger = safeMalloc(sizeof *ledger, "Ledger_create");
+    ledger->slots = safeMalloc(sizeof *ledger->slots * slotCount, "Ledger_create");
+    for (size_t i = 0; i < slotCount; i += 1) {
+        ledger->slots[i].key = LEDGER_EMPTY_KEY;
+        ledger->slots[i].balanceCents = 0;
+    }
+    ledger->slotMask = slotCount - 1;
+    ledger->accountCapacity = accountCapacity;
+    ledger->accountCount = 0;
+
+    size_t const stripesSize = sizeof *ledger->stripes * stripeCount;
+    ledger->stripes = aligned_alloc(LEDGER_CACHE_LINE_SIZE, stripesSize);
+    if (ledger->stripes == NULL) {
+        int const allocErrorCode = errno;
+        char const * const allocErrorMessage = strerror(allocErrorCode);
+
+        abortWithErrorFmt(
+            "Ledger_create: Failed to allocate %zu bytes of memory using aligned_alloc"
+            " (error code: %d; error message: \"%s\")",
+            stripesSize,
+            allocErrorCode,
+            allocErrorMessage
+        );
+    }
+    for (size_t i = 0; i < stripeCount; i += 1) {
+        safeMutexInit(&ledger->stripes[i].mutex, NULL, "Ledger_create");
+        ledger->stripes[i].acquisitionCount = 0;
+        ledger->stripes[i].contendedAcquisitionCount = 0;
+    }
+    ledger->stripeCount = stripeCount;
+
+    return ledger;
+}
+
+/**
+ * Free the memory associated with the ledger.
+ *
+ * @param ledger The Ledger instance. No section may be being applied to it.
+ */
+void Ledger_destroy(Ledger const ledger) {
+    guardNotNull(ledger, "ledger", "Ledger_destroy");
+
+    for (size_t i = 0; i < ledger->stripeCount; i += 1) {
+        safeMutexDestroy(&ledger->stripes[i].mutex, "Ledger_destroy");
+    }
+    free(ledger->stripes);
+    free(ledger->slots);
+    free(ledger);
+}
+
+/**
+ * Apply a section's change to each account it touches, all at once: no other section sees some of the accounts changed
+ * and not others. Only the stripes of these accounts are locked, so sections touching other stripes are not held up.
+ *
+ * @param ledger The Ledger instance.
+ * @param accountIds The IDs of the accounts the section touches, each listed once. An ID must be less than UINT64_MAX.
+ * @param deltasCents The change to each account's balance, in cents, in the same order.
+ * @param balancesCents The list to append each account's balance after the section to, in cents, in the same order.
+ */
+void Ledger_apply(
+    Ledger const ledger,
+    ConstUint64List const accountIds,
+    ConstInt64List const deltasCents,
+    Int64List const balancesCents
+) {
+    guardNotNull(ledger, "ledger", "Ledger_apply");
+    guardNotNull(accountIds, "accountIds", "Ledger_apply");
+    guardNotNull(deltasCents, "deltasCents", "Ledger_apply");
+    guardNotNull(balancesCents, "balancesCents", "Ledger_apply");
+
+    size_t const accountCount = Uint64List_count(accountIds);
+    guard(Int64List_count(deltasCents) == accountCount, "Ledger_apply: There must be one delta per account");
+    uint64_t const * const ids = Uint64List_items(accountIds);
+    int64_t const * const deltas = Int64List_items(deltasCents);
+
+    uint64_t stripeMask = 0;
+    for (size_t i = 0; i < accountCount; i += 1) {
+        guard(ids[i] != UINT64_MAX, "Ledger_apply: Account ID out of range");
+        stripeMask |= UINT64_C(1) << Ledger_stripeIndex(ledger, Ledger_hash(ids[i]));
+    }
+
+    // Every section locks its stripes in ascending order, so two sections cannot each wait for the other
+    for (size_t stripeIndex = 0; stripeIndex < ledger->stripeCount; stripeIndex += 1) {
+        if ((stripeMask & (UINT64_C(1) << stripeIndex)) != 0) {
+            Ledger_lockStripe(ledger, stripeIndex);
+        }
+    }
+
+    for (size_t i = 0; i < accountCount; i += 1) {
+        struct LedgerSlot * const slotPtr = Ledger_findSlot(ledger, ids[i], Ledger_hash(ids[i]), true);
+        slotPtr->balanceCents = ADD_CENTS(slotPtr->balanceCents, deltas[i]);
+        Int64List_add(balancesCents, slotPtr->balanceCents);
+    }
+
+    for (size_t stripeIndex = 0; stripeIndex < ledger->stripeCount; stripeIndex += 1) {
+        if ((stripeMask & (UINT64_C(1) << stripeIndex)) != 0) {
+            safeMutexUnlock(&ledger->stripes[stripeIndex].mutex, "Ledger_apply");
+        }
+    }
+}
+
+/**
+ * Get an account's balance.
+ *
+ * @param ledger The Ledger instance.
+ * @param accountId The ID of the account.
+ *
+ * @returns The balance, in cents. It is zero for an account no section has touched.
+ */
+int64_t Ledger_balance(Ledger const ledger, uint64_t const accountId) {
+    guardNotNull(ledger, "ledger", "Ledger_balance");
+    guard(accountId != UINT64_MAX, "Ledger_balance: Account ID out of range");
+
+    uint64_t const accountHash = Ledger_hash(accountId);
+    size_t const stripeIndex = Ledger_stripeIndex(ledger, accountHash);
+    Ledger_lockStripe(ledger, stripeIndex);
+    struct LedgerSlot const * const slotPtr = Ledger_findSlot(ledger, accountId, accountHash, false);
+    int64_t const balanceCents = slotPtr == NULL ? 0 : slotPtr->balanceCents;
+    safeMutexUnlock(&ledger->stripes[stripeIndex].mutex, "Ledger_balance");
+    return balanceCents;
+}
+
+/**
+ * Get the number of accounts any section has touched.
+ *
+ * @param ledger The Ledger instance.
+ *
+ * @returns The number of accounts.
+ */
+size_t Ledger_accountCount(Ledger const ledger) {
+    guardNotNull(ledger, "ledger", "Ledger_accountCount");
+    return __atomic_load_n(&ledger->accountCount, __ATOMIC_RELAXED);
+}
+
+/**
+ * List every account any section has touched, with its balance, in ascending order of account ID.
+ *
+ * @param ledger The Ledger instance. No section may be being applied to it.
+ * @param accountIds The list to append the account IDs to.
+ * @param balancesCents The list to append the balances to, in cents, in the same order.
+ */
+void Ledger_balances(Ledger const ledger, Uint64List const accountIds, Int64List const balancesCents) {
+    guardNotNull(ledger, "ledger", "Ledger_balances");
+    guardNotNull(accountIds, "accountIds", "Ledger_balances");
+    guardNotNull(balancesCents, "balancesCents", "Ledger_balances");
+
+    size_t const accountCount = Ledger_accountCount(ledger);
+    if (accountCount == 0) {
+        return;
+    }
+
+    struct LedgerAccount * const accounts = safeMalloc(sizeof *accounts * accountCount, "Ledger_balances");
+    size_t listedAccountCount = 0;
+    for (size_t slotIndex = 0; slotIndex <= ledger->slotMask; slotIndex += 1) {
+        struct LedgerSlot const * const slotPtr = &ledger->slots[slotIndex];
+        if (slotPtr->key != LEDGER_EMPTY_KEY) {
+            accounts[listedAccountCount] = (struct LedgerAccount){
+                .accountId = slotPtr->key - 1,
+                .balanceCents = slotPtr->balanceCents
+            };
+            listedAccountCount += 1;
+        }
+    }
+    assert(listedAccountCount == accountCount);
+
+    qsort(accounts, accountCount, sizeof *accounts, Ledger_compareAccounts);
+    for (size_t i = 0; i < accountCount; i += 1) {
+        Uint64List_add(accountIds, accounts[i].accountId);
+        Int64List_add(balancesCents, accounts[i].balanceCents);
+    }
+    free(accounts);
+}
+
+/**
+ * Print how many accounts the ledger holds and how often applying a section had to wait for a stripe lock.
+ *
+ * @param ledger The Ledger instance. No section may be being applied to it.
+ * @param file The file to print to.
+ */
+void Ledger_printStats(Ledger const ledger, FILE * const file) {
+    guardNotNull(ledger, "ledger", "Ledger_printStats");
+    guardNotNull(file, "file", "Ledger_printStats");
+
+    uint64_t acquisitionCount = 0;
+    uint64_t contendedAcquisitionCount = 0;
+    for (size_t i = 0; i < ledger->stripeCount; i += 1) {
+        acquisitionCount += ledger->stripes[i].acquisitionCount;
+        contendedAcquisitionCount += ledger->stripes[i].contendedAcquisitionCount;
+    }
+
+    fprintf(
+        file,
+        "Ledger: %zu accounts in %zu stripes; %llu of %llu stripe locks waited\n",
+        Ledger_accountCount(ledger),
+        ledger->stripeCount,
+        (unsigned long long)contendedAcquisitionCount,
+        (unsigned long long)acquisitionCount
+    );
+}
+
+static uint64_t Ledger_hash(uint64_t const accountId) {
+    return hashBytes(&accountId, sizeof accountId);
+}
+
+static size_t Ledger_stripeIndex(Ledger const ledger, uint64_t const accountHash) {
+    // The low bits of the hash pick the slot, so the stripe comes from the high bits
+    return (size_t)((accountHash >> 32) % ledger->stripeCount);
+}
+
+static struct LedgerSlot *Ledger_findSlot(
+    Ledger const ledger,
+    uint64_t const accountId,
+    uint64_t const accountHash,
+    bool const add
+) {
+    uint64_t const key = accountId + 1;
+    size_t slotIndex = (size_t)accountHash & ledger->slotMask;
+    while (true) {
+        struct LedgerSlot * const slotPtr = &ledger->slots[slotIndex];
+        uint64_t slotKey = __atomic_load_n(&slotPtr->key, __ATOMIC_ACQUIRE);
+        if (slotKey == LEDGER_EMPTY_KEY) {
+            if (!add) {
+                return NULL;
+            }
+
+            // An account of another stripe may claim the slot first, in which case the probe goes on past it
+            if (__atomic_compare_exchange_n(&slotPtr->key, &slotKey, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                size_t const accountCount = __atomic_add_fetch(&ledger->accountCount, 1, __ATOMIC_RELAXED);
+                if (accountCount > ledger->accountCapacity) {
+                    abortWithErrorFmt(
+                        "Ledger_apply: The ledger is full (capacity: %zu accounts)",
+                        ledger->accountCapacity
+                    );
+                }
+                return slotPtr;
+            }
+        }
+        if (slotKey == key) {
+            return slotPtr;
+        }
+        slotIndex = (slotIndex + 1) & ledger->slotMask;
+    }
+}
+
+static void Ledger_lockStripe(Ledger const ledger, size_t const stripeIndex) {
+    struct LedgerStripe * const stripePtr = &ledger->stripes[stripeIndex];
+    bool const contended = !safeMutexTryLock(&stripePtr->mutex, "Ledger_lockStripe");
+    if (contended) {
+        safeMutexLock(&stripePtr->mutex, "Ledger_lockStripe");
+    }
+
+    stripePtr->acquisitionCount += 1;
+    if (contended) {
+        stripePtr->contendedAcquisitionCount += 1;
+    }
+}
+
+static int Ledger_compareAccounts(void const * const firstAccountAsVoidPtr, void const * const secondAccountAsVoidPtr) {
+    struct LedgerAccount const * const firstAccountPtr = firstAccountAsVoidPtr;
+    struct LedgerAccount const * const secondAccountPtr = secondAccountAsVoidPtr;
+    if (firstAccountPtr->accountId < secondAccountPtr->accountId) {
+        return -1;
+    }
+    return firstAccountPtr->accountId > secondAccountPtr->accountId ? 1 : 0;
+}
@@ -0,0 +1,696 @@
+#include "../../include/hw8/PagePool.h"
+
+#include "../../include/hw8/PageStats.h"
+#include "../../include/util/list.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+struct Page {
+    size_t ownerIndex;
+    bool referenced;
+    bool modified;
+};
+DEFINE_CIRCULAR_LINKED_LIST(Pages, struct Page)
+DEFINE_LIST(PageNodeList, PagesNode)
+
+struct PagePoolOwner {
+    char const *name;
+    PageNodeList ownedPageNodes;
+    PageStats stats;
+};
+DEFINE_LIST(PagePoolOwnerList, struct PagePoolOwner *)
+
+/**
+ * Represents the ring of page frames managed by the Enhanced Second Chance - Clock (ESC-C) page replacement algorithm.
+ * The ring can be grown or shrunk while owner threads are running. Every operation holds the pool's mutex for its full
+ * duration, so a resize never observes a page fault that is only partially serviced.
+ */
+struct PagePool {
+    Pages pages;
+    size_t pageCount;
+    size_t minPageCount;
+    size_t maxPageCount;
+    size_t faultCount;
+
+    PagePoolOwnerList owners;
+    bool statsEnabled;
+
+    pthread_mutex_t mutex;
+};
+
+static PagesNode PagePool_findVictim(PagePool pool, size_t *scanLengthOutPtr);
+static void PagePool_printPage(ConstPagePool pool, struct Page const *pagePtr);
+static void PagePool_disown(PagePool pool, PagesNode pageNode);
+static size_t PagePool_growLocked(PagePool pool, size_t count);
+static size_t PagePool_shrinkLocked(PagePool pool, size_t count);
+
+/**
+ * Create a PagePool.
+ *
+ * @param unownedPageCount The number of initially unowned pages.
+ * @param minPageCount The minimum number of pages the pool may be shrunk to. Must be at least 1.
+ * @param maxPageCount The maximum number of pages the pool may be grown to, or 0 for no limit.
+ *
+ * @returns The newly allocated PagePool. The caller is responsible for freeing this memory.
+ */
+PagePool PagePool_create(size_t const unownedPageCount, size_t const minPageCount, size_t const maxPageCount) {
+    guard(minPageCount >= 1, "PagePool_create: minPageCount must be at least 1");
+    guard(
+        maxPageCount == 0 || maxPageCount >= minPageCount,
+        "PagePool_create: maxPageCount must be 0 or at least minPageCount"
+    );
+
+    PagePool const pool = safeMalloc(sizeof *pool, "PagePool_create");
+    pool->pages = Pages_create();
+    pool->pageCount = 0;
+    pool->minPageCount = minPageCount;
+    pool->maxPageCount = maxPageCount;
+    pool->faultCount = 0;
+    pool->owners = PagePoolOwnerList_create();
+    pool->statsEnabled = false;
+    safeMutexInit(&pool->mutex, NULL, "PagePool_create");
+
+    for (size_t i = 0; i < unownedPageCount; i += 1) {
+        Pages_add(pool->pages, (struct Page){
+            .ownerIndex = PAGE_UNOWNED,
+            .referenced = false,
+            .modified = false
+        });
+        pool->pageCount += 1;
+    }
+
+    return pool;
+}
+
+/**
+ * Free the memory associated with the PagePool. No other thread may be using the pool.
+ *
+ * @param pool The PagePool instance.
+ */
+void PagePool_destroy(PagePool const pool) {
+    guardNotNull(pool, "pool", "PagePool_destroy");
+
+    for (size_t i = 0; i < PagePoolOwnerList_count(pool->owners); i += 1) {
+        struct PagePoolOwner * const ownerPtr = PagePoolOwnerList_get(pool->owners, i);
+        PageNodeList_destroy(ownerPtr->ownedPageNodes);
+        free(ownerPtr);
+    }
+    PagePoolOwnerList_destroy(pool->owners);
+
+    Pages_destroy(pool->pages);
+    safeMutexDestroy(&pool->mutex, "PagePool_destroy");
+    free(pool);
+}
+
+/**
+ * Register a new page owner and load its initial page into a newly added frame.
+ *
+ * @param pool The PagePool instance.
+ * @param ownerName The name of the owner, used when printing page details. The string must outlive the pool.
+ *
+ * @returns The index identifying the owner in subsequent calls.
+ */
+size_t PagePool_addOwner(PagePool const pool, char const * const ownerName) {
+    guardNotNull(pool, "pool", "PagePool_addOwner");
+    guardNotNull(ownerName, "ownerName", "PagePool_addOwner");
+
+    safeMutexLock(&pool->mutex, "PagePool_addOwner");
+
+    size_t const ownerIndex = PagePoolOwnerList_count(pool->owners);
+
+    struct PagePoolOwner * const ownerPtr = safeMalloc(sizeof *ownerPtr, "PagePool_addOwner");
+    ownerPtr->name = ownerName;
+    ownerPtr->ownedPageNodes = PageNodeList_create();
+    ownerPtr->stats = NULL;
+    PagePoolOwnerList_add(pool->owners, ownerPtr);
+
+    PagesNode const initialOwnedPageNode = Pages_add(pool->pages, (struct Page){
+        .ownerIndex = ownerIndex,
+        .referenced = false,
+        .modified = false
+    });
+    pool->pageCount += 1;
+    PageNodeList_add(ownerPtr->ownedPageNodes, initialOwnedPageNode);
+
+    safeMutexUnlock(&pool->mutex, "PagePool_addOwner");
+
+    return ownerIndex;
+}
+
+/**
+ * Record the page subsystem statistics of the given owner's accesses: page pool mutex wait time, and the service time
+ * and victim scan length of its page faults. This must be called before the owner's pages are first accessed, and the
+ * stats must only be used by the thread which accesses the owner's pages until that thread is done.
+ *
+ * @param pool The PagePool instance.
+ * @param ownerIndex The index of the owner, as returned by PagePool_addOwner.
+ * @param stats The PageStats to record into, or null to stop recording.
+ */
+void PagePool_setOwnerStats(PagePool const pool, size_t const ownerIndex, PageStats const stats) {
+    guardNotNull(pool, "pool", "PagePool_setOwnerStats");
+
+    safeMutexLock(&pool->mutex, "PagePool_setOwnerStats");
+
+    guardFmt(
+        ownerIndex < PagePoolOwnerList_count(pool->owners),
+        "PagePool_setOwnerStats: ownerIndex (%zu) is out of range",
+        ownerIndex
+    );
+    PagePoolOwnerList_get(pool->owners, ownerIndex)->stats = stats;
+    if (stats != NULL) {
+        pool->statsEnabled = true;
+    }
+
+    safeMutexUnlock(&pool->mutex, "PagePool_setOwnerStats");
+}
+
+/**
+ * Access the pages of the given owner. If the owner has no pages in memory, or if an additional page is required, a
+ * page fault is generated and a victim page is chosen using ESC-C and handed to the owner. Afterwards, the R and M bits
+ * of every page owned by the owner are updated according to the access.
+ *
+ * @param pool The PagePool instance.
+ * @param ownerIndex The index of the owner, as returned by PagePool_addOwner.
+ * @param requireAdditionalPage Whether to load an additional page even if the owner already has pages in memory.
+ * @param access How the owner's pages are accessed. A read sets the R bit; a write sets both the R and M bits.
+ *
+ * @returns Whether a page fault occurred.
+ */
+bool PagePool_access(
+    PagePool const pool,
+    size_t const ownerIndex,
+    bool const requireAdditionalPage,
+    enum PageAccess const access
+) {
+    guardNotNull(pool, "pool", "PagePool_access");
+
+    // The clock is only read when some owner records stats, to keep the common path free of the overhead
+    bool const statsEnabled = pool->statsEnabled;
+    uint64_t const lockStartTimeNs = statsEnabled ? safeMonotonicTimeNs("PagePool_access") : 0;
+    safeMutexLock(&pool->mutex, "PagePool_access");
+    uint64_t const lockedTimeNs = statsEnabled ? safeMonotonicTimeNs("PagePool_access") : 0;
+
+    guardFmt(
+        ownerIndex < PagePoolOwnerList_count(pool->owners),
+        "PagePool_access: ownerIndex (%zu) is out of range",
+        ownerIndex
+    );
+    struct PagePoolOwner * const ownerPtr = PagePoolOwnerList_get(pool->owners, ownerIndex);
+    PageStats const stats = statsEnabled ? ownerPtr->stats : NULL;
+    if (stats != NULL) {
+        PageStats_record(stats, PageStat_pagesMutexWaitNs, lockedTimeNs - lockStartTimeNs);
+    }
+
+    bool const pageFault = PageNodeList_empty(ownerPtr->ownedPageNodes) || requireAdditionalPage;
+    if (pageFault) {
+        printf("Page fault in thread %s\n", ownerPtr->name);
+        pool->faultCount += 1;
+
+        size_t victimScanLength;
+        PagesNode const additionalPageNode = PagePool_findVictim(pool, &victimScanLength);
+        struct Page * const additionalPagePtr = Pages_itemPtr(pool->pages, additionalPageNode);
+        printf("Page being removed: ");
+        PagePool_printPage(pool, additionalPagePtr);
+
+        PagePool_disown(pool, additionalPageNode);
+        PageNodeList_add(ownerPtr->ownedPageNodes, additionalPageNode);
+        additionalPagePtr->ownerIndex = ownerIndex;
+        additionalPagePtr->referenced = false;
+        additionalPagePtr->modified = false;
+
+        if (stats != NULL) {
+            PageStats_record(stats, PageStat_victimScanLength, victimScanLength);
+            PageStats_record(stats, PageStat_faultServiceNs, safeMonotonicTimeNs("PagePool_access") - lockedTimeNs);
+        }
+    }
+
+    for (size_t i = 0; i < PageNodeList_count(ownerPtr->ownedPageNodes); i += 1) {
+        struct Page * const ownedPagePtr = Pages_itemPtr(pool->pages, PageNodeList_get(ownerPtr->ownedPageNodes, i));
+        switch (access) {
+            case PageAccess_none: {
+                break;
+            }
+            case PageAccess_read: {
+                ownedPagePtr->referenced = true;
+                break;
+            }
+            case PageAccess_write: {
+                ownedPagePtr->referenced = true;
+                ownedPagePtr->modified = true;
+                break;
+            }
+            default: {
+                abortWithErrorFmt("PagePool_access: Invalid access (%d)", (int)access);
+                break;
+            }
+        }
+    }
+
+    safeMutexUnlock(&pool->mutex, "PagePool_access");
+
+    return pageFault;
+}
+
+/**
+ * Reset the R bit of every page in the pool. This is done periodically so that the R bit reflects recent use.
+ *
+ * @param pool The PagePool instance.
+ */
+void PagePool_resetReferenced(PagePool const pool) {
+    guardNotNull(pool, "pool", "PagePool_resetReferenced");
+
+    safeMutexLock(&pool->mutex, "PagePool_resetReferenced");
+
+    PagesNode const headPageNode = Pages_head(pool->pages);
+    if (headPageNode != NULL) {
+        PagesNode currentPageNode = headPageNode;
+        while (true) {
+            Pages_itemPtr(pool->pages, currentPageNode)->referenced = false;
+
+            PagesNode const nextPageNode = Pages_next(pool->pages, currentPageNode);
+            if (nextPageNode == headPageNode) {
+                break;
+            }
+            currentPageNode = nextPageNode;
+        }
+    }
+
+    safeMutexUnlock(&pool->mutex, "PagePool_resetReferenced");
+}
+
+/**
+ * Get the number of page frames currently in the pool.
+ *
+ * @param pool The PagePool instance.
+ *
+ * @returns The page count.
+ */
+size_t PagePool_pageCount(PagePool const pool) {
+    guardNotNull(pool, "pool", "PagePool_pageCount");
+
+    safeMutexLock(&pool->mutex, "PagePool_pageCount");
+    size_t const pageCount = pool->pageCount;
+    safeMutexUnlock(&pool->mutex, "PagePool_pageCount");
+    return pageCount;
+}
+
+/**
+ * Get the total number of page faults serviced by the pool since it was created.
+ *
+ * @param pool The PagePool instance.
+ *
+ * @returns The fault count.
+ */
+size_t PagePool_faultCount(PagePool const pool) {
+    guardNotNull(pool, "pool", "PagePool_faultCount");
+
+    safeMutexLock(&pool->mutex, "PagePool_faultCount");
+    size_t const faultCount = pool->faultCount;
+    safeMutexUnlock(&pool->mutex, "PagePool_faultCount");
+    return faultCount;
+}
+
+/**
+ * Get the number of page frames in the pool which have no owner.
+ *
+ * @param pool The PagePool instance.
+ *
+ * @returns The unowned page count.
+ */
+size_t PagePool_unownedPageCount(PagePool const pool) {
+    guardNotNull(pool, "pool", "PagePool_unownedPageCount");
+
+    safeMutexLock(&pool->mutex, "PagePool_unownedPageCount");
+    size_t ownedPageCount = 0;
+    for (size_t i = 0; i < PagePoolOwnerList_count(pool->owners); i += 1) {
+        ownedPageCount += PageNodeList_count(PagePoolOwnerList_get(pool->owners, i)->ownedPageNodes);
+    }
+    size_t const unownedPageCount = pool->pageCount - ownedPageCount;
+    safeMutexUnlock(&pool->mutex, "PagePool_unownedPageCount");
+    return unownedPageCount;
+}
+
+/**
+ * Get the number of page frames in the pool owned by the given owner.
+ *
+ * @param pool The PagePool instance.
+ * @param ownerIndex The index of the owner, as returned by PagePool_addOwner.
+ *
+ * @returns The owned page count.
+ */
+size_t PagePool_ownedPageCount(PagePool const pool, size_t const ownerIndex) {
+    guardNotNull(pool, "pool", "PagePool_ownedPageCount");
+
+    safeMutexLock(&pool->mutex, "PagePool_ownedPageCount");
+    guardFmt(
+        ownerIndex < PagePoolOwnerList_count(pool->owners),
+        "PagePool_ownedPageCount: ownerIndex (%zu) is out of range",
+        ownerIndex
+    );
+    size_t const ownedPageCount = PageNodeList_count(PagePoolOwnerList_get(pool->owners, ownerIndex)->ownedPageNodes);
+    safeMutexUnlock(&pool->mutex, "PagePool_ownedPageCount");
+    return ownedPageCount;
+}
+
+/**
+ * Add unowned page frames to the pool, without exceeding the pool's maximum page count.
+ *
+ * @param pool The PagePool instance.
+ * @param count The number of frames to add.
+ *
+ * @returns The number of frames actually added.
+ */
+size_t PagePool_grow(PagePool const pool, size_t const count) {
+    guardNotNull(pool, "pool", "PagePool_grow");
+
+    safeMutexLock(&pool->mutex, "PagePool_grow");
+    size_t const addedCount = PagePool_growLocked(pool, count);
+    safeMutexUnlock(&pool->mutex, "PagePool_grow");
+
+    return addedCount;
+}
+
+/**
+ * Remove page frames from the pool, without going below the pool's minimum page count. Victims are chosen the same way
+ * as for a page fault (unowned pages first, then the lowest non-empty NRU class), and are taken away from their owners,
+ * who will fault on their next access if they are left with no pages.
+ *
+ * @param pool The PagePool instance.
+ * @param count The number of frames to remove.
+ *
+ * @returns The number of frames actually removed.
+ */
+size_t PagePool_shrink(PagePool const pool, size_t const count) {
+    guardNotNull(pool, "pool", "PagePool_shrink");
+
+    safeMutexLock(&pool->mutex, "PagePool_shrink");
+    size_t const removedCount = PagePool_shrinkLocked(pool, count);
+    safeMutexUnlock(&pool->mutex, "PagePool_shrink");
+
+    return removedCount;
+}
+
+/**
+ * Remove unowned page frames from the pool, without going below the pool's minimum page count. Unlike PagePool_shrink,
+ * this never takes a page away from its owner.
+ *
+ * @param pool The PagePool instance.
+ * @param count The maximum number of frames to remove.
+ *
+ * @returns The number of frames actually removed.
+ */
+size_t PagePool_shrinkUnowned(PagePool const pool, size_t const count) {
+    guardNotNull(pool, "pool", "PagePool_shrinkUnowned");
+
+    safeMutexLock(&pool->mutex, "PagePool_shrinkUnowned");
+
+    size_t const availableCount = pool->pageCount > pool->minPageCount ? pool->pageCount - pool->minPageCount : 0;
+    size_t const maxRemovedCount = count < availableCount ? count : availableCount;
+
+    size_t removedCount = 0;
+    PagesNode currentPageNode = Pages_head(pool->pages);
+    size_t remainingPageCount = pool->pageCount;
+    while (removedCount < maxRemovedCount && remainingPageCount > 0) {
+        remainingPageCount -= 1;
+        if (Pages_constItemPtr(pool->pages, currentPageNode)->ownerIndex != PAGE_UNOWNED) {
+            currentPageNode = Pages_next(pool->pages, currentPageNode);
+            continue;
+        }
+
+        currentPageNode = Pages_remove(pool->pages, currentPageNode);
+        removedCount += 1;
+    }
+
+    if (removedCount > 0) {
+        printf("Page pool shrinking from %zu to %zu pages\n", pool->pageCount, pool->pageCount - removedCount);
+        pool->pageCount -= removedCount;
+    }
+
+    safeMutexUnlock(&pool->mutex, "PagePool_shrinkUnowned");
+
+    return removedCount;
+}
+
+/**
+ * Grow or shrink the pool towards the given page count, within the pool's minimum and maximum page counts.
+ *
+ * @param pool The PagePool instance.
+ * @param targetPageCount The desired page count.
+ *
+ * @returns The resulting page count.
+ */
+size_t PagePool_resize(PagePool const pool, size_t const targetPageCount) {
+    guardNotNull(pool, "pool", "PagePool_resize");
+
+    // The delta is applied under the same hold of the mutex it was computed under, so a concurrent resize cannot skew it
+    safeMutexLock(&pool->mutex, "PagePool_resize");
+    if (targetPageCount > pool->pageCount) {
+        PagePool_growLocked(pool, targetPageCount - pool->pageCount);
+    } else if (targetPageCount < pool->pageCount) {
+        PagePool_shrinkLocked(pool, pool->pageCount - targetPageCount);
+    }
+    size_t const pageCount = pool->pageCount;
+    safeMutexUnlock(&pool->mutex, "PagePool_resize");
+
+    return pageCount;
+}
+
+/**
+ * Get the state of every page frame in the pool, in ring order starting from the head, which is where the victim scan
+ * starts.
+ *
+ * @param pool The PagePool instance.
+ * @param pageStatesOut The array to write the page states to.
+ * @param capacity The length of the array. Only the first capacity page states are written.
+ *
+ * @returns The page count, which may be more than capacity.
+ */
+size_t PagePool_pageStates(PagePool const pool, struct PageState * const pageStatesOut, size_t const capacity) {
+    guardNotNull(pool, "pool", "PagePool_pageStates");
+    guard(capacity == 0 || pageStatesOut != NULL, "PagePool_pageStates: pageStatesOut is null");
+
+    safeMutexLock(&pool->mutex, "PagePool_pageStates");
+
+    size_t pageIndex = 0;
+    PagesNode const headPageNode = Pages_head(pool->pages);
+    if (headPageNode != NULL) {
+        PagesNode currentPageNode = headPageNode;
+        while (true) {
+            if (pageIndex < capacity) {
+                struct Page const * const pagePtr = Pages_constItemPtr(pool->pages, currentPageNode);
+                pageStatesOut[pageIndex] = (struct PageState){
+                    .ownerIndex = pagePtr->ownerIndex,
+                    .referenced = pagePtr->referenced,
+                    .modified = pagePtr->modified
+                };
+            }
+            pageIndex += 1;
+
+            PagesNode const nextPageNode = Pages_next(pool->pages, currentPageNode);
+            if (nextPageNode == headPageNode) {
+                break;
+            }
+            currentPageNode = nextPageNode;
+        }
+    }
+    size_t const pageCount = pool->pageCount;
+
+    safeMutexUnlock(&pool->mutex, "PagePool_pageStates");
+
+    return pageCount;
+}
+
+/**
+ * Replace every page frame in the pool with the given page states, as previously returned by PagePool_pageStates. The
+ * pool's minimum and maximum page counts are not enforced, and no page fault is counted.
+ *
+ * @param pool The PagePool instance. Every owner named by the page states must already have been added.
+ * @param pageStates The page states, in ring order starting from the head.
+ * @param pageCount The number of page states. Must be at least 1.
+ */
+void PagePool_restorePageStates(
+    PagePool const pool,
+    struct PageState const * const pageStates,
+    size_t const pageCount
+) {
+    guardNotNull(pool, "pool", "PagePool_restorePageStates");
+    guardNotNull(pageStates, "pageStates", "PagePool_restorePageStates");
+    guard(pageCount >= 1, "PagePool_restorePageStates: pageCount must be at least 1");
+
+    safeMutexLock(&pool->mutex, "PagePool_restorePageStates");
+
+    size_t const ownerCount = PagePoolOwnerList_count(pool->owners);
+    for (size_t i = 0; i < pageCount; i += 1) {
+        size_t const ownerIndex = pageStates[i].ownerIndex;
+        guardFmt(
+            ownerIndex == PAGE_UNOWNED || ownerIndex < ownerCount,
+            "PagePool_restorePageStates: ownerIndex (%zu) is out of range",
+            ownerIndex
+        );
+    }
+
+    for (size_t i = 0; i < ownerCount; i += 1) {
+        PageNodeList_clear(PagePoolOwnerList_get(pool->owners, i)->ownedPageNodes);
+    }
+    Pages_clear(pool->pages);
+
+    for (size_t i = 0; i < pageCount; i += 1) {
+        struct PageState const pageState = pageStates[i];
+        PagesNode const pageNode = Pages_add(pool->pages, (struct Page){
+            .ownerIndex = pageState.ownerIndex,
+            .referenced = pageState.referenced,
+            .modified = pageState.modified
+        });
+        if (pageState.ownerIndex != PAGE_UNOWNED) {
+            PageNodeList_add(PagePoolOwnerList_get(pool->owners, pageState.ownerIndex)->ownedPageNodes, pageNode);
+        }
+    }
+    pool->pageCount = pageCount;
+
+    safeMutexUnlock(&pool->mutex, "PagePool_restorePageStates");
+}
+
+/**
+ * Choose the page to be replaced using ESC-C. The whole ring is inspected: the first unowned page is chosen if there is
+ * one; otherwise, a page from the lowest non-empty NRU class is chosen. The pool's mutex must be held.
+ *
+ * @param pool The PagePool instance.
+ *
+ * @returns The victim page node.
+ */
+static PagesNode PagePool_findVictim(PagePool const pool, size_t * const scanLengthOutPtr) {
+    PagesNode unownedPageNode = NULL;
+    PagesNode class0PageNode = NULL;
+    PagesNode class1PageNode = NULL;
+    PagesNode class2PageNode = NULL;
+    PagesNode class3PageNode = NULL;
+
+    size_t scanLength = 0;
+    PagesNode const headPageNode = Pages_head(pool->pages);
+    PagesNode currentPageNode = headPageNode;
+    while (true) {
+        struct Page const * const currentPagePtr = Pages_constItemPtr(pool->pages, currentPageNode);
+        scanLength += 1;
+
+        if (currentPagePtr->ownerIndex == PAGE_UNOWNED) {
+            unownedPageNode = currentPageNode;
+            break;
+        }
+
+        bool const currentPageReferenced = currentPagePtr->referenced;
+        bool const currentPageModified = currentPagePtr->modified;
+        if (!currentPageReferenced && !currentPageModified) {
+            class0PageNode = currentPageNode;
+        } else if (!currentPageReferenced && currentPageModified) {
+            class1PageNode = currentPageNode;
+        } else if (currentPageReferenced && !currentPageModified) {
+            class2PageNode = currentPageNode;
+        } else { // currentPageReferenced && currentPageModified
+            class3PageNode = currentPageNode;
+        }
+
+        PagesNode const nextPageNode = Pages_next(pool->pages, currentPageNode);
+        if (nextPageNode == headPageNode) {
+            break;
+        }
+        currentPageNode = nextPageNode;
+    }
+
+    *scanLengthOutPtr = scanLength;
+    return (
+        unownedPageNode != NULL ? (
+            unownedPageNode
+        ) : class0PageNode != NULL ? (
+            class0PageNode
+        ) : class1PageNode != NULL ? (
+            class1PageNode
+        ) : class2PageNode != NULL ? (
+            class2PageNode
+        ) : ( // class3PageNode != NULL
+            class3PageNode
+        )
+    );
+}
+
+static void PagePool_printPage(ConstPagePool const pool, struct Page const * const pagePtr) {
+    printf(
+        "{owner=%s, referenced=%s, modified=%s}\n",
+        pagePtr->ownerIndex == PAGE_UNOWNED ? "[UNOWNED]" : PagePoolOwnerList_get(pool->owners, pagePtr->ownerIndex)->name,
+        pagePtr->referenced ? "yes" : "no",
+        pagePtr->modified ? "yes" : "no"
+    );
+}
+
+/**
+ * Remove the given page from its current owner's owned pages, if it has an owner. The pool's mutex must be held.
+ *
+ * @param pool The PagePool instance.
+ * @param pageNode The page node.
+ */
+static void PagePool_disown(PagePool const pool, PagesNode const pageNode) {
+    struct Page * const pagePtr = Pages_itemPtr(pool->pages, pageNode);
+    if (pagePtr->ownerIndex == PAGE_UNOWNED) {
+        return;
+    }
+
+    PageNodeList const ownedPageNodes = PagePoolOwnerList_get(pool->owners, pagePtr->ownerIndex)->ownedPageNodes;
+    size_t const ownedPageNodeIndex = PageNodeList_indexOf(ownedPageNodes, pageNode);
+    if (ownedPageNodeIndex != (size_t)-1) {
+        PageNodeList_removeAt(ownedPageNodes, ownedPageNodeIndex);
+    }
+    pagePtr->ownerIndex = PAGE_UNOWNED;
+}
+
+static size_t PagePool_growLocked(PagePool const pool, size_t const count) {
+    size_t addedCount = count;
+    if (pool->maxPageCount != 0) {
+        size_t const availableCount = pool->maxPageCount > pool->pageCount ? pool->maxPageCount - pool->pageCount : 0;
+        if (addedCount > availableCount) {
+            addedCount = availableCount;
+        }
+    }
+
+    if (addedCount > 0) {
+        printf("Page pool growing from %zu to %zu pages\n", pool->pageCount, pool->pageCount + addedCount);
+        for (size_t i = 0; i < addedCount; i += 1) {
+            Pages_add(pool->pages, (struct Page){
+                .ownerIndex = PAGE_UNOWNED,
+                .referenced = false,
+                .modified = false
+            });
+        }
+        pool->pageCount += addedCount;
+    }
+
+    return addedCount;
+}
+
+static size_t PagePool_shrinkLocked(PagePool const pool, size_t const count) {
+    size_t const availableCount = pool->pageCount > pool->minPageCount ? pool->pageCount - pool->minPageCount : 0;
+    size_t const removedCount = count < availableCount ? count : availableCount;
+
+    if (removedCount > 0) {
+        printf("Page pool shrinking from %zu to %zu pages\n", pool->pageCount, pool->pageCount - removedCount);
+        for (size_t i = 0; i < removedCount; i += 1) {
+            size_t victimScanLength;
+            PagesNode const victimPageNode = PagePool_findVictim(pool, &victimScanLength);
+            printf("Page being removed: ");
+            PagePool_printPage(pool, Pages_constItemPtr(pool->pages, victimPageNode));
+
+            PagePool_disown(pool, victimPageNode);
+            Pages_remove(pool->pages, victimPageNode);
+        }
+        pool->pageCount -= removedCount;
+    }
+
+    return removedCount;
+}
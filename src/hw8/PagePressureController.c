@@ -0,0 +1,284 @@
+#include "../../include/hw8/PagePressureController.h"
+
+#include "../../include/hw8/PagePool.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#define CONTROL_LINE_CAPACITY 128
+// A control command may grow the pool to at most this many times its current page count, so that a mistyped count
+// cannot allocate frames under the pool's mutex until memory runs out
+#define CONTROL_MAX_GROWTH_FACTOR 16
+
+/**
+ * Represents a background thread which grows and shrinks a PagePool while it is in use. The pool is grown when the
+ * number of page faults in an interval reaches a high watermark and shrunk when it falls to a low watermark. Resize
+ * commands may also be written to a control FIFO, one per line: "grow N", "shrink N", or "resize N".
+ */
+struct PagePressureController {
+    PagePool pool;
+    struct PagePressureControllerOptions options;
+
+    int stopPipeFds[2];
+    int controlFifoFd;
+    int controlFifoWriterFd;
+    char controlLine[CONTROL_LINE_CAPACITY];
+    size_t controlLineLength;
+
+    pthread_t threadId;
+};
+
+static void *PagePressureController_threadStart(void *argAsVoidPtr);
+static void PagePressureController_adjustForFaultRate(PagePressureController controller, size_t intervalFaultCount);
+static void PagePressureController_readControlFifo(PagePressureController controller);
+static void PagePressureController_runControlCommand(PagePressureController controller, char const *command);
+
+/**
+ * Start a PagePressureController thread for the given pool.
+ *
+ * @param pool The PagePool to resize. The pool must outlive the controller.
+ * @param optionsPtr The controller options. A high watermark of 0 disables resizing based on the fault rate, and a null
+ *                   control FIFO path disables the control FIFO. If the FIFO does not exist, it is created.
+ *
+ * @returns The newly started PagePressureController. The caller is responsible for stopping it, which frees its memory.
+ */
+PagePressureController PagePressureController_start(
+    PagePool const pool,
+    struct PagePressureControllerOptions const * const optionsPtr
+) {
+    guardNotNull(pool, "pool", "PagePressureController_start");
+    guardNotNull(optionsPtr, "optionsPtr", "PagePressureController_start");
+    guard(optionsPtr->intervalMs > 0, "PagePressureController_start: intervalMs must be greater than 0");
+
+    PagePressureController const controller = safeMalloc(sizeof *controller, "PagePressureController_start");
+    controller->pool = pool;
+    controller->options = *optionsPtr;
+    controller->controlFifoFd = -1;
+    controller->controlFifoWriterFd = -1;
+    controller->controlLineLength = 0;
+
+    if (pipe(controller->stopPipeFds) == -1) {
+        int const pipeErrorCode = errno;
+        abortWithErrorFmt(
+            "PagePressureController_start: Failed to create stop pipe using pipe (error code: %d; error message: \"%s\")",
+            pipeErrorCode,
+            strerror(pipeErrorCode)
+        );
+    }
+
+    char const * const controlFifoPath = optionsPtr->controlFifoPath;
+    if (controlFifoPath != NULL) {
+        if (mkfifo(controlFifoPath, 0600) == -1 && errno != EEXIST) {
+            int const mkfifoErrorCode = errno;
+            abortWithErrorFmt(
+                "PagePressureController_start: Failed to create control FIFO \"%s\" using mkfifo (error code: %d; error message: \"%s\")",
+                controlFifoPath,
+                mkfifoErrorCode,
+                strerror(mkfifoErrorCode)
+            );
+        }
+
+        controller->controlFifoFd = open(controlFifoPath, O_RDONLY | O_NONBLOCK);
+        // Hold a writer open ourselves so that poll does not report a hangup every time an external writer closes
+        controller->controlFifoWriterFd = open(controlFifoPath, O_WRONLY | O_NONBLOCK);
+        if (controller->controlFifoFd == -1 || controller->controlFifoWriterFd == -1) {
+            int const openErrorCode = errno;
+            abortWithErrorFmt(
+                "PagePressureController_start: Failed to open control FIFO \"%s\" using open (error code: %d; error message: \"%s\")",
+                controlFifoPath,
+                openErrorCode,
+                strerror(openErrorCode)
+            );
+        }
+    }
+
+    controller->threadId = safePthreadCreate(
+        NULL,
+        PagePressureController_threadStart,
+        controller,
+        "PagePressureController_start"
+    );
+
+    return controller;
+}
+
+/**
+ * Stop the PagePressureController thread, wait for it to exit, and free the controller's memory.
+ *
+ * @param controller The PagePressureController instance.
+ */
+void PagePressureController_stop(PagePressureController const controller) {
+    guardNotNull(controller, "controller", "PagePressureController_stop");
+
+    while (write(controller->stopPipeFds[1], "", 1) == -1 && errno == EINTR) {
+        // Retry
+    }
+    safePthreadJoin(controller->threadId, "PagePressureController_stop");
+
+    close(controller->stopPipeFds[0]);
+    close(controller->stopPipeFds[1]);
+    if (controller->controlFifoFd != -1) {
+        close(controller->controlFifoFd);
+        close(controller->controlFifoWriterFd);
+    }
+    free(controller);
+}
+
+static void *PagePressureController_threadStart(void * const argAsVoidPtr) {
+    guardNotNull(argAsVoidPtr, "argAsVoidPtr", "PagePressureController_threadStart");
+    PagePressureController const controller = argAsVoidPtr;
+
+    struct pollfd pollFds[2] = {
+        {.fd = controller->stopPipeFds[0], .events = POLLIN, .revents = 0},
+        {.fd = controller->controlFifoFd, .events = POLLIN, .revents = 0}
+    };
+    nfds_t const pollFdCount = controller->controlFifoFd != -1 ? 2 : 1;
+
+    // Control commands wake the poll early, so the interval is timed against an absolute deadline rather than restarted
+    uint64_t const intervalNs = (uint64_t)controller->options.intervalMs * 1000000;
+    uint64_t intervalDeadlineNs = safeMonotonicTimeNs("PagePressureController_threadStart") + intervalNs;
+    size_t previousFaultCount = PagePool_faultCount(controller->pool);
+    while (true) {
+        uint64_t const nowNs = safeMonotonicTimeNs("PagePressureController_threadStart");
+        if (nowNs >= intervalDeadlineNs) {
+            size_t const faultCount = PagePool_faultCount(controller->pool);
+            PagePressureController_adjustForFaultRate(controller, faultCount - previousFaultCount);
+            previousFaultCount = faultCount;
+            intervalDeadlineNs = nowNs + intervalNs;
+        }
+
+        // Round up, so that the poll does not return just before the deadline and spin
+        uint64_t const remainingMs = (intervalDeadlineNs - nowNs + 999999) / 1000000;
+        int const readyCount = poll(pollFds, pollFdCount, (int)remainingMs);
+        if (readyCount == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            int const pollErrorCode = errno;
+            abortWithErrorFmt(
+                "PagePressureController_threadStart: Failed to wait for events using poll (error code: %d; error message: \"%s\")",
+                pollErrorCode,
+                strerror(pollErrorCode)
+            );
+        }
+
+        if (pollFds[0].revents != 0) {
+            break;
+        }
+
+        if (readyCount > 0) {
+            PagePressureController_readControlFifo(controller);
+        }
+    }
+
+    return NULL;
+}
+
+static void PagePressureController_adjustForFaultRate(
+    PagePressureController const controller,
+    size_t const intervalFaultCount
+) {
+    struct PagePressureControllerOptions const * const optionsPtr = &controller->options;
+    if (optionsPtr->faultsPerIntervalHigh == 0) {
+        return;
+    }
+
+    if (intervalFaultCount >= optionsPtr->faultsPerIntervalHigh) {
+        PagePool_grow(controller->pool, optionsPtr->step);
+    } else if (intervalFaultCount <= optionsPtr->faultsPerIntervalLow) {
+        PagePool_shrink(controller->pool, optionsPtr->step);
+    }
+}
+
+static void PagePressureController_readControlFifo(PagePressureController const controller) {
+    while (true) {
+        char readChar;
+        ssize_t const readCount = read(controller->controlFifoFd, &readChar, 1);
+        if (readCount == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return;
+            }
+
+            int const readErrorCode = errno;
+            abortWithErrorFmt(
+                "PagePressureController_readControlFifo: Failed to read control FIFO using read (error code: %d; error message: \"%s\")",
+                readErrorCode,
+                strerror(readErrorCode)
+            );
+        }
+        if (readCount == 0) {
+            return;
+        }
+
+        if (readChar == '\n') {
+            controller->controlLine[controller->controlLineLength] = '\0';
+            PagePressureController_runControlCommand(controller, controller->controlLine);
+            controller->controlLineLength = 0;
+        } else if (controller->controlLineLength < CONTROL_LINE_CAPACITY - 1) {
+            controller->controlLine[controller->controlLineLength] = readChar;
+            controller->controlLineLength += 1;
+        }
+    }
+}
+
+static void PagePressureController_runControlCommand(
+    PagePressureController const controller,
+    char const * const command
+) {
+    char verb[16];
+    int countOffset;
+    if (sscanf(command, "%15s %n", verb, &countOffset) != 1) {
+        fprintf(stderr, "PagePressureController: Ignoring malformed control command \"%s\"\n", command);
+        return;
+    }
+
+    // strtoull would accept a sign and wrap a negative count around to a huge one, so the count must start with a digit
+    char const * const countChars = command + countOffset;
+    char *countEnd;
+    errno = 0;
+    unsigned long long const count = strtoull(countChars, &countEnd, 10);
+    if (errno != 0 || countChars[0] < '0' || countChars[0] > '9' || *countEnd != '\0' || count > SIZE_MAX) {
+        fprintf(stderr, "PagePressureController: Ignoring malformed control command \"%s\"\n", command);
+        return;
+    }
+
+    size_t const pageCount = PagePool_pageCount(controller->pool);
+    size_t const maxPageCount = (
+        pageCount <= SIZE_MAX / CONTROL_MAX_GROWTH_FACTOR ? pageCount * CONTROL_MAX_GROWTH_FACTOR : SIZE_MAX
+    );
+    if (strcmp(verb, "grow") == 0) {
+        if (count > maxPageCount - pageCount) {
+            fprintf(stderr, "PagePressureController: Ignoring control command \"%s\" beyond the growth limit\n", command);
+            return;
+        }
+        PagePool_grow(controller->pool, (size_t)count);
+    } else if (strcmp(verb, "shrink") == 0) {
+        PagePool_shrink(controller->pool, (size_t)count);
+    } else if (strcmp(verb, "resize") == 0) {
+        if (count > maxPageCount) {
+            fprintf(stderr, "PagePressureController: Ignoring control command \"%s\" beyond the growth limit\n", command);
+            return;
+        }
+        PagePool_resize(controller->pool, (size_t)count);
+    } else {
+        fprintf(stderr, "PagePressureController: Ignoring unknown control command \"%s\"\n", command);
+    }
+}
@@ -0,0 +1,142 @@
+#include "../../include/hw8/PageStats.h"
+
+#include "../../include/util/Histogram.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+#include "../../include/util/macro.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct PageStatInfo {
+    char const *key;
+    char const *description;
+};
+
+static struct PageStatInfo const pageStatInfos[] = {
+    [PageStat_faultServiceNs] = {.key = "faultServiceNs", .description = "Page fault service time (ns)"},
+    [PageStat_pagesMutexWaitNs] = {.key = "pagesMutexWaitNs", .description = "Page pool mutex wait time (ns)"},
+    [PageStat_balanceMutexWaitNs] = {.key = "balanceMutexWaitNs", .description = "Balance mutex wait time (ns)"},
+    [PageStat_balanceMutexHoldNs] = {.key = "balanceMutexHoldNs", .description = "Balance mutex hold time (ns)"},
+    [PageStat_victimScanLength] = {.key = "victimScanLength", .description = "Victim scan length (pages)"}
+};
+
+#define PAGE_STAT_COUNT ARRAY_LENGTH(pageStatInfos)
+
+/**
+ * Represents a histogram for each page subsystem statistic. A PageStats is not synchronized: each thread records into
+ * its own, and they are merged once the threads are done.
+ */
+struct PageStats {
+    Histogram histograms[PAGE_STAT_COUNT];
+};
+
+static void PageStats_guardStat(enum PageStat stat, char const *callerDescription);
+
+/**
+ * Create an empty PageStats.
+ *
+ * @returns The newly allocated PageStats. The caller is responsible for freeing this memory.
+ */
+PageStats PageStats_create(void) {
+    PageStats const stats = safeMalloc(sizeof *stats, "PageStats_create");
+    for (size_t i = 0; i < PAGE_STAT_COUNT; i += 1) {
+        stats->histograms[i] = Histogram_create();
+    }
+    return stats;
+}
+
+/**
+ * Free the memory associated with the PageStats.
+ *
+ * @param stats The PageStats instance.
+ */
+void PageStats_destroy(PageStats const stats) {
+    guardNotNull(stats, "stats", "PageStats_destroy");
+
+    for (size_t i = 0; i < PAGE_STAT_COUNT; i += 1) {
+        Histogram_destroy(stats->histograms[i]);
+    }
+    free(stats);
+}
+
+/**
+ * Record a value of the given statistic.
+ *
+ * @param stats The PageStats instance.
+ * @param stat The statistic.
+ * @param value The value.
+ */
+void PageStats_record(PageStats const stats, enum PageStat const stat, uint64_t const value) {
+    guardNotNull(stats, "stats", "PageStats_record");
+    PageStats_guardStat(stat, "PageStats_record");
+
+    Histogram_record(stats->histograms[stat], value);
+}
+
+/**
+ * Add every value recorded in another PageStats to this one.
+ *
+ * @param stats The PageStats instance.
+ * @param otherStats The PageStats whose values to add. It is left unchanged.
+ */
+void PageStats_merge(PageStats const stats, ConstPageStats const otherStats) {
+    guardNotNull(stats, "stats", "PageStats_merge");
+    guardNotNull(otherStats, "otherStats", "PageStats_merge");
+
+    for (size_t i = 0; i < PAGE_STAT_COUNT; i += 1) {
+        Histogram_merge(stats->histograms[i], otherStats->histograms[i]);
+    }
+}
+
+/**
+ * Print the count, p50, p99, p999 and max of each statistic, one per line.
+ *
+ * @param stats The PageStats instance.
+ * @param file The file to print to.
+ */
+void PageStats_print(ConstPageStats const stats, FILE * const file) {
+    guardNotNull(stats, "stats", "PageStats_print");
+    guardNotNull(file, "file", "PageStats_print");
+
+    for (size_t i = 0; i < PAGE_STAT_COUNT; i += 1) {
+        ConstHistogram const histogram = stats->histograms[i];
+        fprintf(
+            file,
+            "%s: count=%llu, p50=%llu, p99=%llu, p999=%llu, max=%llu\n",
+            pageStatInfos[i].description,
+            (unsigned long long)Histogram_count(histogram),
+            (unsigned long long)Histogram_valueAtPermille(histogram, 500),
+            (unsigned long long)Histogram_valueAtPermille(histogram, 990),
+            (unsigned long long)Histogram_valueAtPermille(histogram, 999),
+            (unsigned long long)Histogram_max(histogram)
+        );
+    }
+}
+
+/**
+ * Write the statistics as a JSON object with a histogram object (see Histogram_writeJson) for each statistic.
+ *
+ * @param stats The PageStats instance.
+ * @param file The file to write to.
+ */
+void PageStats_writeJson(ConstPageStats const stats, FILE * const file) {
+    guardNotNull(stats, "stats", "PageStats_writeJson");
+    guardNotNull(file, "file", "PageStats_writeJson");
+
+    fprintf(file, "{\n");
+    for (size_t i = 0; i < PAGE_STAT_COUNT; i += 1) {
+        fprintf(file, "    \"%s\": ", pageStatInfos[i].key);
+        Histogram_writeJson(stats->histograms[i], file);
+        fprintf(file, "%s\n", i + 1 < PAGE_STAT_COUNT ? "," : "");
+    }
+    fprintf(file, "}\n");
+}
+
+static void PageStats_guardStat(enum PageStat const stat, char const * const callerDescription) {
+    if ((size_t)stat >= PAGE_STAT_COUNT) {
+        abortWithErrorFmt("%s: Invalid stat (%d)", callerDescription, (int)stat);
+    }
+}
@@ -0,0 +1,248 @@
+#include "../../include/hw8/SectionCache.h"
+
+#include "../../include/hw8/TransactionReader.h"
+#include "../../include/util/lists.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/hash.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * The header at the start of a section cache file, which sits next to the transaction record file it caches. It
+ * records the size and modification time the record file had when the cache was written, and the hash of the part of
+ * it that the cached sections cover. It is followed by sectionCount entries. All integers are in host byte order.
+ */
+struct SectionCacheHeader {
+    char magic[SECTION_CACHE_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;
+    int64_t modifiedSeconds;
+    int64_t modifiedNanoseconds;
+    uint64_t coveredLength;
+    uint64_t coveredHash;
+    uint64_t sectionCount;
+};
+
+/**
+ * A cached section: the offset in the record file just past the section, and the sum of its amounts.
+ */
+struct SectionCacheEntry {
+    uint64_t endOffset;
+    int64_t deltaCents;
+};
+
+static bool loadSectionCache(
+    char const *cachePath,
+    struct SectionCacheHeader *headerOutPtr,
+    struct SectionCacheEntry **entriesOutPtr
+);
+static void writeSectionCache(
+    char const *cachePath,
+    struct SectionCacheHeader const *headerPtr,
+    SizeList sectionEndOffsets,
+    Int64List sectionDeltasCents
+);
+
+/**
+ * Read the delta of every section of a transaction record file, reusing the deltas cached next to the file (at the
+ * file path plus SECTION_CACHE_FILE_SUFFIX) by an earlier run where possible:
+ *
+ * - If the file has the same size and modification time as when the cache was written, it is assumed to be unchanged,
+ *   and the cached deltas are used without reading the file at all.
+ * - Otherwise, if the file still starts with the bytes the cached sections were read from, which is checked by hashing
+ *   them, only the rest of the file, such as sections appended since, is read.
+ * - Otherwise, the whole file is read.
+ *
+ * The cache is then rewritten if anything was read. Streamed readers are read without a cache. If the cache cannot be
+ * written, a warning is printed and the deltas are still returned.
+ *
+ * @param reader The TransactionReader instance of the file. It must not have read any section and must not be indexed
+ *               or prefetching.
+ * @param filePath The path of the transaction record file.
+ * @param sectionDeltasCents The list to append the delta of each section to, in cents.
+ *
+ * @returns How the cache was used.
+ */
+enum SectionCacheResult readSectionDeltasCached(
+    TransactionReader const reader,
+    char const * const filePath,
+    Int64List const sectionDeltasCents
+) {
+    guardNotNull(reader, "reader", "readSectionDeltasCached");
+    guardNotNull(filePath, "filePath", "readSectionDeltasCached");
+    guardNotNull(sectionDeltasCents, "sectionDeltasCents", "readSectionDeltasCached");
+
+    int64_t sectionDeltaCents;
+    size_t contentLength;
+    char const * const contents = TransactionReader_contents(reader, &contentLength);
+    if (contents == NULL) {
+        while (TransactionReader_readSection(reader, &sectionDeltaCents)) {
+            Int64List_add(sectionDeltasCents, sectionDeltaCents);
+        }
+        return SectionCacheResult_uncached;
+    }
+
+    struct stat fileStat;
+    if (stat(filePath, &fileStat) == -1) {
+        int const statErrorCode = errno;
+        abortWithErrorFmt(
+            "readSectionDeltasCached: Failed to get the status of file \"%s\" using stat (error code: %d; error message: \"%s\")",
+            filePath,
+            statErrorCode,
+            strerror(statErrorCode)
+        );
+    }
+
+    char * const cachePath = formatString("%s%s", filePath, SECTION_CACHE_FILE_SUFFIX);
+    struct SectionCacheHeader cachedHeader;
+    struct SectionCacheEntry *cachedEntries = NULL;
+    enum SectionCacheResult result = SectionCacheResult_miss;
+    if (loadSectionCache(cachePath, &cachedHeader, &cachedEntries) && cachedHeader.coveredLength <= contentLength) {
+        bool const unmodified = (
+            cachedHeader.fileSize == (uint64_t)fileStat.st_size
+            && cachedHeader.modifiedSeconds == (int64_t)fileStat.st_mtim.tv_sec
+            && cachedHeader.modifiedNanoseconds == (int64_t)fileStat.st_mtim.tv_nsec
+        );
+        if (unmodified) {
+            result = SectionCacheResult_hit;
+        } else if (
+            cachedHeader.sectionCount > 0
+            && hashBytes(contents, (size_t)cachedHeader.coveredLength) == cachedHeader.coveredHash
+        ) {
+            result = SectionCacheResult_appended;
+        }
+    }
+
+    SizeList const sectionEndOffsets = SizeList_create();
+    if (result != SectionCacheResult_miss) {
+        for (size_t i = 0; i < cachedHeader.sectionCount; i += 1) {
+            SizeList_add(sectionEndOffsets, (size_t)cachedEntries[i].endOffset);
+            Int64List_add(sectionDeltasCents, cachedEntries[i].deltaCents);
+        }
+    }
+
+    if (result != SectionCacheResult_hit) {
+        if (result == SectionCacheResult_appended) {
+            TransactionReader_skipTo(reader, (size_t)cachedHeader.coveredLength, (size_t)cachedHeader.sectionCount);
+        }
+        while (TransactionReader_readSection(reader, &sectionDeltaCents)) {
+            SizeList_add(sectionEndOffsets, TransactionReader_offset(reader));
+            Int64List_add(sectionDeltasCents, sectionDeltaCents);
+        }
+
+        size_t const sectionCount = SizeList_count(sectionEndOffsets);
+        size_t const coveredLength = sectionCount == 0 ? 0 : SizeList_get(sectionEndOffsets, sectionCount - 1);
+        struct SectionCacheHeader header = {
+            .version = SECTION_CACHE_VERSION,
+            .reserved = 0,
+            .fileSize = (uint64_t)fileStat.st_size,
+            .modifiedSeconds = (int64_t)fileStat.st_mtim.tv_sec,
+            .modifiedNanoseconds = (int64_t)fileStat.st_mtim.tv_nsec,
+            .coveredLength = (uint64_t)coveredLength,
+            .coveredHash = hashBytes(contents, coveredLength),
+            .sectionCount = (uint64_t)sectionCount
+        };
+        memcpy(header.magic, SECTION_CACHE_MAGIC, SECTION_CACHE_MAGIC_LENGTH);
+        writeSectionCache(cachePath, &header, sectionEndOffsets, sectionDeltasCents);
+    }
+
+    SizeList_destroy(sectionEndOffsets);
+    free(cachedEntries);
+    free(cachePath);
+    return result;
+}
+
+static bool loadSectionCache(
+    char const * const cachePath,
+    struct SectionCacheHeader * const headerOutPtr,
+    struct SectionCacheEntry ** const entriesOutPtr
+) {
+    // A missing, unreadable or malformed cache is simply not used
+    FILE * const cacheFile = fopen(cachePath, "rb");
+    if (cacheFile == NULL) {
+        return false;
+    }
+
+    struct stat cacheStat;
+    bool valid = (
+        fstat(fileno(cacheFile), &cacheStat) != -1
+        && fread(headerOutPtr, sizeof *headerOutPtr, 1, cacheFile) == 1
+        && memcmp(headerOutPtr->magic, SECTION_CACHE_MAGIC, SECTION_CACHE_MAGIC_LENGTH) == 0
+        && headerOutPtr->version == SECTION_CACHE_VERSION
+        && (uint64_t)cacheStat.st_size - sizeof *headerOutPtr == headerOutPtr->sectionCount * sizeof **entriesOutPtr
+    );
+
+    struct SectionCacheEntry *entries = NULL;
+    if (valid && headerOutPtr->sectionCount > 0) {
+        size_t const sectionCount = (size_t)headerOutPtr->sectionCount;
+        entries = safeMalloc(sizeof *entries * sectionCount, "loadSectionCache");
+        valid = (
+            fread(entries, sizeof *entries, sectionCount, cacheFile) == sectionCount
+            && entries[sectionCount - 1].endOffset == headerOutPtr->coveredLength
+        );
+    }
+    fclose(cacheFile);
+
+    if (!valid) {
+        free(entries);
+        return false;
+    }
+    *entriesOutPtr = entries;
+    return true;
+}
+
+static void writeSectionCache(
+    char const * const cachePath,
+    struct SectionCacheHeader const * const headerPtr,
+    SizeList const sectionEndOffsets,
+    Int64List const sectionDeltasCents
+) {
+    // Written to a temporary file first, so that a concurrent or interrupted run never sees half a cache
+    char * const temporaryPath = formatString("%s.%ld.tmp", cachePath, (long)getpid());
+    FILE * const cacheFile = fopen(temporaryPath, "wb");
+    if (cacheFile == NULL) {
+        int const fopenErrorCode = errno;
+        fprintf(
+            stderr,
+            "writeSectionCache: Not caching sections in \"%s\" (error code: %d; error message: \"%s\")\n",
+            cachePath,
+            fopenErrorCode,
+            strerror(fopenErrorCode)
+        );
+        free(temporaryPath);
+        return;
+    }
+
+    bool written = fwrite(headerPtr, sizeof *headerPtr, 1, cacheFile) == 1;
+    size_t const * const endOffsets = SizeList_items(sectionEndOffsets);
+    int64_t const * const deltasCents = Int64List_items(sectionDeltasCents);
+    for (size_t i = 0; written && i < (size_t)headerPtr->sectionCount; i += 1) {
+        struct SectionCacheEntry const entry = {.endOffset = (uint64_t)endOffsets[i], .deltaCents = deltasCents[i]};
+        written = fwrite(&entry, sizeof entry, 1, cacheFile) == 1;
+    }
+    written = fclose(cacheFile) == 0 && written;
+
+    if (!written || rename(temporaryPath, cachePath) == -1) {
+        int const writeErrorCode = errno;
+        fprintf(
+            stderr,
+            "writeSectionCache: Failed to write \"%s\" (error code: %d; error message: \"%s\")\n",
+            cachePath,
+            writeErrorCode,
+            strerror(writeErrorCode)
+        );
+        unlink(temporaryPath);
+    }
+    free(temporaryPath);
+}
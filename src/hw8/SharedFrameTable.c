@@ -0,0 +1,316 @@
+#include "../../include/hw8/SharedFrameTable.h"
+
+#include "../../include/hw8/PagePool.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#define FRAME_UNOWNED UINT64_MAX
+#define BITMAP_WORD_BITS 64
+
+/**
+ * Represents a page frame table which lives in shared memory, so that it can be used by processes forked after it is
+ * created. Each frame has an owner index; the R and M bits of all frames are stored in two bitmaps. Victims are chosen
+ * using ESC-C exactly as PagePool chooses them, scanning the frames in order: the first unowned frame is chosen if
+ * there is one; otherwise, the last frame in the lowest non-empty NRU class is chosen.
+ *
+ * Every operation holds a process-shared robust mutex. If a process dies while holding it, the next process to lock it
+ * carries on with the table as it was left; at worst a single fault is only partially recorded.
+ *
+ * The table is followed in the same shared memory by its variable-length arrays, each made up of 64-bit words:
+ * ownerNames[ownerCapacity], frameOwners[frameCount], referencedBits[bitmapWordCount], and
+ * modifiedBits[bitmapWordCount]. Owner names are stored as addresses, which are only valid in the creating process and
+ * its forked descendants.
+ */
+struct SharedFrameTable {
+    pthread_mutex_t mutex;
+
+    size_t memorySize;
+    size_t frameCount;
+    size_t ownerCapacity;
+    size_t ownerCount;
+    size_t bitmapWordCount;
+    size_t faultCount;
+
+    uint64_t words[];
+};
+
+static uint64_t *SharedFrameTable_ownerNames(SharedFrameTable table);
+static uint64_t *SharedFrameTable_frameOwners(SharedFrameTable table);
+static uint64_t *SharedFrameTable_referencedBits(SharedFrameTable table);
+static uint64_t *SharedFrameTable_modifiedBits(SharedFrameTable table);
+static bool bitmapGet(uint64_t const *bitmap, size_t index);
+static void bitmapSet(uint64_t *bitmap, size_t index, bool value);
+static void SharedFrameTable_lock(SharedFrameTable table, char const *callerDescription);
+static size_t SharedFrameTable_findVictim(SharedFrameTable table);
+static void SharedFrameTable_printFrame(SharedFrameTable table, size_t frameIndex);
+
+/**
+ * Create a SharedFrameTable. One additional frame is reserved for each owner added later.
+ *
+ * @param unownedFrameCount The number of initially unowned frames.
+ * @param ownerCapacity The maximum number of owners.
+ *
+ * @returns The newly allocated SharedFrameTable, in shared memory. The caller is responsible for freeing this memory.
+ */
+SharedFrameTable SharedFrameTable_create(size_t const unownedFrameCount, size_t const ownerCapacity) {
+    size_t const frameCount = unownedFrameCount + ownerCapacity;
+    guard(frameCount > 0, "SharedFrameTable_create: The table must have at least one frame");
+
+    size_t const bitmapWordCount = (frameCount + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+    size_t const wordCount = ownerCapacity + frameCount + 2 * bitmapWordCount;
+    size_t const memorySize = sizeof (struct SharedFrameTable) + wordCount * sizeof (uint64_t);
+
+    SharedFrameTable const table = safeSharedMalloc(memorySize, "SharedFrameTable_create");
+    safeProcessSharedMutexInit(&table->mutex, "SharedFrameTable_create");
+    table->memorySize = memorySize;
+    table->frameCount = frameCount;
+    table->ownerCapacity = ownerCapacity;
+    table->ownerCount = 0;
+    table->bitmapWordCount = bitmapWordCount;
+    table->faultCount = 0;
+
+    uint64_t * const frameOwners = SharedFrameTable_frameOwners(table);
+    for (size_t i = 0; i < frameCount; i += 1) {
+        frameOwners[i] = FRAME_UNOWNED;
+    }
+
+    return table;
+}
+
+/**
+ * Free the shared memory associated with the SharedFrameTable. No other process may be using the table.
+ *
+ * @param table The SharedFrameTable instance.
+ */
+void SharedFrameTable_destroy(SharedFrameTable const table) {
+    guardNotNull(table, "table", "SharedFrameTable_destroy");
+
+    safeMutexDestroy(&table->mutex, "SharedFrameTable_destroy");
+    safeSharedFree(table, table->memorySize, "SharedFrameTable_destroy");
+}
+
+/**
+ * Register a new frame owner and load its initial page into one of the frames reserved for owners.
+ *
+ * @param table The SharedFrameTable instance.
+ * @param ownerName The name of the owner, used when printing frame details. The string must outlive the table.
+ *
+ * @returns The index identifying the owner in subsequent calls.
+ */
+size_t SharedFrameTable_addOwner(SharedFrameTable const table, char const * const ownerName) {
+    guardNotNull(table, "table", "SharedFrameTable_addOwner");
+    guardNotNull(ownerName, "ownerName", "SharedFrameTable_addOwner");
+
+    SharedFrameTable_lock(table, "SharedFrameTable_addOwner");
+
+    guard(table->ownerCount < table->ownerCapacity, "SharedFrameTable_addOwner: The table is at owner capacity");
+    size_t const ownerIndex = table->ownerCount;
+    table->ownerCount += 1;
+    SharedFrameTable_ownerNames(table)[ownerIndex] = (uint64_t)(uintptr_t)ownerName;
+    SharedFrameTable_frameOwners(table)[table->frameCount - table->ownerCapacity + ownerIndex] = ownerIndex;
+
+    safeMutexUnlock(&table->mutex, "SharedFrameTable_addOwner");
+
+    return ownerIndex;
+}
+
+/**
+ * Access the pages of the given owner. This behaves like PagePool_access, but may be called from any process forked
+ * after the table was created.
+ *
+ * @param table The SharedFrameTable instance.
+ * @param ownerIndex The index of the owner, as returned by SharedFrameTable_addOwner.
+ * @param requireAdditionalPage Whether to load an additional page even if the owner already has pages in memory.
+ * @param access How the owner's pages are accessed. A read sets the R bit; a write sets both the R and M bits.
+ *
+ * @returns Whether a page fault occurred.
+ */
+bool SharedFrameTable_access(
+    SharedFrameTable const table,
+    size_t const ownerIndex,
+    bool const requireAdditionalPage,
+    enum PageAccess const access
+) {
+    guardNotNull(table, "table", "SharedFrameTable_access");
+
+    SharedFrameTable_lock(table, "SharedFrameTable_access");
+
+    guardFmt(ownerIndex < table->ownerCount, "SharedFrameTable_access: ownerIndex (%zu) is out of range", ownerIndex);
+
+    uint64_t * const frameOwners = SharedFrameTable_frameOwners(table);
+    uint64_t * const referencedBits = SharedFrameTable_referencedBits(table);
+    uint64_t * const modifiedBits = SharedFrameTable_modifiedBits(table);
+
+    bool ownsAnyFrame = false;
+    for (size_t i = 0; i < table->frameCount; i += 1) {
+        if (frameOwners[i] == ownerIndex) {
+            ownsAnyFrame = true;
+            break;
+        }
+    }
+
+    bool const pageFault = !ownsAnyFrame || requireAdditionalPage;
+    if (pageFault) {
+        printf("Page fault in thread %s\n", (char const *)(uintptr_t)SharedFrameTable_ownerNames(table)[ownerIndex]);
+        table->faultCount += 1;
+
+        size_t const victimFrameIndex = SharedFrameTable_findVictim(table);
+        printf("Page being removed: ");
+        SharedFrameTable_printFrame(table, victimFrameIndex);
+
+        frameOwners[victimFrameIndex] = ownerIndex;
+        bitmapSet(referencedBits, victimFrameIndex, false);
+        bitmapSet(modifiedBits, victimFrameIndex, false);
+    }
+
+    for (size_t i = 0; i < table->frameCount; i += 1) {
+        if (frameOwners[i] != ownerIndex) {
+            continue;
+        }
+
+        switch (access) {
+            case PageAccess_none: {
+                break;
+            }
+            case PageAccess_read: {
+                bitmapSet(referencedBits, i, true);
+                break;
+            }
+            case PageAccess_write: {
+                bitmapSet(referencedBits, i, true);
+                bitmapSet(modifiedBits, i, true);
+                break;
+            }
+            default: {
+                abortWithErrorFmt("SharedFrameTable_access: Invalid access (%d)", (int)access);
+                break;
+            }
+        }
+    }
+
+    safeMutexUnlock(&table->mutex, "SharedFrameTable_access");
+
+    return pageFault;
+}
+
+/**
+ * Reset the R bit of every frame in the table.
+ *
+ * @param table The SharedFrameTable instance.
+ */
+void SharedFrameTable_resetReferenced(SharedFrameTable const table) {
+    guardNotNull(table, "table", "SharedFrameTable_resetReferenced");
+
+    SharedFrameTable_lock(table, "SharedFrameTable_resetReferenced");
+
+    uint64_t * const referencedBits = SharedFrameTable_referencedBits(table);
+    for (size_t i = 0; i < table->bitmapWordCount; i += 1) {
+        referencedBits[i] = 0;
+    }
+
+    safeMutexUnlock(&table->mutex, "SharedFrameTable_resetReferenced");
+}
+
+/**
+ * Get the total number of page faults serviced by the table since it was created, across all processes.
+ *
+ * @param table The SharedFrameTable instance.
+ *
+ * @returns The fault count.
+ */
+size_t SharedFrameTable_faultCount(SharedFrameTable const table) {
+    guardNotNull(table, "table", "SharedFrameTable_faultCount");
+
+    SharedFrameTable_lock(table, "SharedFrameTable_faultCount");
+    size_t const faultCount = table->faultCount;
+    safeMutexUnlock(&table->mutex, "SharedFrameTable_faultCount");
+    return faultCount;
+}
+
+static uint64_t *SharedFrameTable_ownerNames(SharedFrameTable const table) {
+    return &table->words[0];
+}
+
+static uint64_t *SharedFrameTable_frameOwners(SharedFrameTable const table) {
+    return &table->words[table->ownerCapacity];
+}
+
+static uint64_t *SharedFrameTable_referencedBits(SharedFrameTable const table) {
+    return &table->words[table->ownerCapacity + table->frameCount];
+}
+
+static uint64_t *SharedFrameTable_modifiedBits(SharedFrameTable const table) {
+    return &table->words[table->ownerCapacity + table->frameCount + table->bitmapWordCount];
+}
+
+static bool bitmapGet(uint64_t const * const bitmap, size_t const index) {
+    return (bitmap[index / BITMAP_WORD_BITS] >> (index % BITMAP_WORD_BITS) & 1) != 0;
+}
+
+static void bitmapSet(uint64_t * const bitmap, size_t const index, bool const value) {
+    uint64_t const mask = (uint64_t)1 << (index % BITMAP_WORD_BITS);
+    if (value) {
+        bitmap[index / BITMAP_WORD_BITS] |= mask;
+    } else {
+        bitmap[index / BITMAP_WORD_BITS] &= ~mask;
+    }
+}
+
+static void SharedFrameTable_lock(SharedFrameTable const table, char const * const callerDescription) {
+    if (safeRobustMutexLock(&table->mutex, callerDescription)) {
+        fprintf(stderr, "%s: A process died while holding the frame table lock; continuing\n", callerDescription);
+    }
+}
+
+/**
+ * Choose the frame to be replaced using ESC-C, with the same tie-break as PagePool_findVictim, so that the processes
+ * evict the same frames as threads sharing a PagePool would. The table's mutex must be held.
+ *
+ * @param table The SharedFrameTable instance.
+ *
+ * @returns The victim frame index.
+ */
+static size_t SharedFrameTable_findVictim(SharedFrameTable const table) {
+    uint64_t const * const frameOwners = SharedFrameTable_frameOwners(table);
+    uint64_t const * const referencedBits = SharedFrameTable_referencedBits(table);
+    uint64_t const * const modifiedBits = SharedFrameTable_modifiedBits(table);
+
+    size_t classFrameIndexes[4] = {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+    size_t victimFrameIndex = SIZE_MAX;
+    for (size_t frameIndex = 0; frameIndex < table->frameCount; frameIndex += 1) {
+        if (frameOwners[frameIndex] == FRAME_UNOWNED) {
+            victimFrameIndex = frameIndex;
+            break;
+        }
+
+        // A later frame of the same class replaces an earlier one, as in PagePool_findVictim
+        size_t const frameClass = (
+            (bitmapGet(referencedBits, frameIndex) ? 2u : 0u) + (bitmapGet(modifiedBits, frameIndex) ? 1u : 0u)
+        );
+        classFrameIndexes[frameClass] = frameIndex;
+    }
+
+    for (size_t frameClass = 0; victimFrameIndex == SIZE_MAX && frameClass < 4; frameClass += 1) {
+        victimFrameIndex = classFrameIndexes[frameClass];
+    }
+
+    return victimFrameIndex;
+}
+
+static void SharedFrameTable_printFrame(SharedFrameTable const table, size_t const frameIndex) {
+    uint64_t const ownerIndex = SharedFrameTable_frameOwners(table)[frameIndex];
+    printf(
+        "{owner=%s, referenced=%s, modified=%s}\n",
+        ownerIndex == FRAME_UNOWNED ? "[UNOWNED]" : (char const *)(uintptr_t)SharedFrameTable_ownerNames(table)[ownerIndex],
+        bitmapGet(SharedFrameTable_referencedBits(table), frameIndex) ? "yes" : "no",
+        bitmapGet(SharedFrameTable_modifiedBits(table), frameIndex) ? "yes" : "no"
+    );
+}
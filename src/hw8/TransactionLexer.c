@@ -0,0 +1,120 @@
+#include "../../include/hw8/TransactionLexer.h"
+
+#include "../../include/util/cents.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Classify a line of a transaction record file and, if it is a transaction, parse its amount in cents. The grammar is:
+ *
+ *     BeginTransactionSection: R
+ *     EndTransactionSection:   W
+ *     Transaction:             [+-][0-9]+(\.[0-9]*)? | [+-]?[0-9]*\.[0-9]+
+ *
+ * @param chars The characters of the line, excluding the newline. They do not need to be null-terminated.
+ * @param length The number of characters in the line.
+ * @param amountCentsOutPtr Where to store the amount in cents if the line is a transaction. It is left unchanged
+ *                          otherwise.
+ *
+ * @returns The kind of line, or TransactionToken_invalid if it does not match the grammar.
+ */
+enum TransactionToken lexTransactionLine(
+    char const * const chars,
+    size_t const length,
+    int64_t * const amountCentsOutPtr
+) {
+    guardNotNull(chars, "chars", "lexTransactionLine");
+    guardNotNull(amountCentsOutPtr, "amountCentsOutPtr", "lexTransactionLine");
+
+    if (length == 0) {
+        return TransactionToken_invalid;
+    }
+    if (length == 1) {
+        if (chars[0] == 'R') {
+            return TransactionToken_beginSection;
+        }
+        if (chars[0] == 'W') {
+            return TransactionToken_endSection;
+        }
+    }
+
+    // parseCents accepts any [+-]?[0-9]*(\.[0-9]*)? with a digit; an unsigned amount must also end in a fraction
+    bool const hasSign = chars[0] == '+' || chars[0] == '-';
+    if (!hasSign) {
+        size_t decimalPointIndex = 0;
+        while (decimalPointIndex < length && chars[decimalPointIndex] != '.') {
+            decimalPointIndex += 1;
+        }
+        if (decimalPointIndex + 1 >= length) {
+            return TransactionToken_invalid;
+        }
+    }
+
+    int64_t amountCents;
+    if (!parseCents(chars, length, &amountCents)) {
+        return TransactionToken_invalid;
+    }
+
+    *amountCentsOutPtr = amountCents;
+    return TransactionToken_transaction;
+}
+
+/**
+ * Classify a line of a transaction record file like lexTransactionLine, except that a transaction may be prefixed with
+ * the ID of the account it applies to:
+ *
+ *     Transaction:             ([0-9]+:)?<a transaction as above>
+ *
+ * A transaction without an account ID applies to DEFAULT_ACCOUNT_ID. Account IDs go up to MAX_ACCOUNT_ID.
+ *
+ * @param chars The characters of the line, excluding the newline. They do not need to be null-terminated.
+ * @param length The number of characters in the line.
+ * @param accountIdOutPtr Where to store the account ID if the line is a transaction. It is left unchanged otherwise.
+ * @param amountCentsOutPtr Where to store the amount in cents if the line is a transaction. It is left unchanged
+ *                          otherwise.
+ *
+ * @returns The kind of line, or TransactionToken_invalid if it does not match the grammar.
+ */
+enum TransactionToken lexAccountTransactionLine(
+    char const * const chars,
+    size_t const length,
+    uint64_t * const accountIdOutPtr,
+    int64_t * const amountCentsOutPtr
+) {
+    guardNotNull(chars, "chars", "lexAccountTransactionLine");
+    guardNotNull(accountIdOutPtr, "accountIdOutPtr", "lexAccountTransactionLine");
+    guardNotNull(amountCentsOutPtr, "amountCentsOutPtr", "lexAccountTransactionLine");
+
+    // An account ID is the leading digits up to a colon; an unsigned amount also starts with digits, but has no colon
+    uint64_t accountId = 0;
+    size_t digitCount = 0;
+    while (digitCount < length && chars[digitCount] >= '0' && chars[digitCount] <= '9') {
+        uint64_t const digit = (uint64_t)(chars[digitCount] - '0');
+        if (accountId > (MAX_ACCOUNT_ID - digit) / 10) {
+            return TransactionToken_invalid;
+        }
+        accountId = accountId * 10 + digit;
+        digitCount += 1;
+    }
+
+    if (digitCount == 0 || digitCount == length || chars[digitCount] != ':') {
+        enum TransactionToken const token = lexTransactionLine(chars, length, amountCentsOutPtr);
+        if (token == TransactionToken_transaction) {
+            *accountIdOutPtr = DEFAULT_ACCOUNT_ID;
+        }
+        return token;
+    }
+
+    size_t const amountStart = digitCount + 1;
+    int64_t amountCents;
+    if (lexTransactionLine(chars + amountStart, length - amountStart, &amountCents) != TransactionToken_transaction) {
+        return TransactionToken_invalid;
+    }
+
+    *accountIdOutPtr = accountId;
+    *amountCentsOutPtr = amountCents;
+    return TransactionToken_transaction;
+}
@@ -0,0 +1,1179 @@
+#include "../../include/hw8/TransactionReader.h"
+
+#include "../../include/hw8/BinaryTransactionFile.h"
+#include "../../include/hw8/TransactionLexer.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/lists.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/file.h"
+#include "../../include/util/InputStream.h"
+#include "../../include/util/cents.h"
+#include "../../include/util/sum.h"
+#include "../../include/util/scan.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+enum TransactionFileFormat {
+    TransactionFileFormat_text,
+    TransactionFileFormat_binary,
+    TransactionFileFormat_textStream,
+    TransactionFileFormat_columns
+};
+
+// Two slots: the consumer applies one section while the helper thread reads the next
+#define PREFETCH_SLOT_COUNT 2
+
+/**
+ * The byte range of a section's amounts within the file: its transaction lines, or its packed amounts.
+ */
+struct TransactionSectionSpan {
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * Reads the transaction sections of a transaction record file, summing each section into the change it makes to the
+ * balance. Both the text format and the binary format (see BinaryTransactionFile.h) are read from a mapping of the file;
+ * the format is detected from the start of the file. Text files are validated line by line as they are read, while
+ * binary files, which were validated when they were converted, are only checked for structural consistency; the
+ * amounts of a varint-encoded binary file are decoded as they are summed. Once a reader has been indexed, its sections
+ * are read from the index and summed without any checks.
+ *
+ * Text streams, such as standard input, pipes and files which are followed while they are appended to, are read through
+ * an InputStream instead of a mapping, and a section is only returned once its EndTransactionSection line has arrived.
+ * Streamed readers are not indexed and cannot be split.
+ *
+ * A reader can also read sections which have already been parsed into columns, such as by a TransactionStore.
+ *
+ * A text reader can instead sum each section per account, for transaction lines which carry account IDs.
+ *
+ * A reader can also prefetch: a helper thread then reads and sums the following sections into a double buffer while
+ * the owner of the reader is busy with the current one.
+ */
+struct TransactionReader {
+    char const *name;
+    char const *filePath;
+
+    struct MappedFile file;
+    char *ownedChars;
+    enum TransactionFileFormat format;
+    enum BinaryTransactionEncoding binaryEncoding;
+    size_t dataOffset;
+
+    uint64_t sectionCount;
+    uint64_t readSectionCount;
+
+    bool indexed;
+    struct TransactionSectionSpan *sectionSpans;
+    size_t sectionSpanCount;
+
+    InputStream stream;
+    size_t streamLexedLength;
+    int64_t streamSectionDeltaCents;
+
+    int64_t const *columnAmountsCents;
+    size_t const *columnSectionOffsets;
+
+    Int64List collectedAmountsCents;
+    Uint64List collectedAccountIds;
+    Int64List collectedAccountDeltasCents;
+
+    bool prefetching;
+    pthread_t prefetchThreadId;
+    pthread_mutex_t prefetchMutex;
+    pthread_cond_t prefetchCondition;
+    int64_t prefetchedSectionDeltasCents[PREFETCH_SLOT_COUNT];
+    size_t prefetchedSectionStart;
+    size_t prefetchedSectionCount;
+    bool prefetchEnded;
+    bool prefetchStopping;
+};
+
+static TransactionReader TransactionReader_create(char const *name, char const *filePath);
+static bool TransactionReader_openStream(TransactionReader reader);
+static void TransactionReader_detectFormat(TransactionReader reader);
+static TransactionReader TransactionReader_createChunk(
+    TransactionReader reader,
+    size_t begin,
+    size_t end,
+    uint64_t sectionCount
+);
+static size_t TransactionReader_findSectionStart(TransactionReader reader, size_t position);
+static void TransactionReader_rewind(TransactionReader reader);
+static void TransactionReader_guardSeekable(TransactionReader reader, char const *callerDescription);
+static bool TransactionReader_readIndexedSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+static bool TransactionReader_readTextSection(
+    TransactionReader reader,
+    int64_t *sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan *sectionSpanOutPtr
+);
+static bool TransactionReader_readBinarySection(
+    TransactionReader reader,
+    int64_t *sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan *sectionSpanOutPtr
+);
+static uint64_t TransactionReader_readBinaryWord(TransactionReader reader);
+static bool TransactionReader_readVarintSection(
+    TransactionReader reader,
+    int64_t *sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan *sectionSpanOutPtr
+);
+static bool TransactionReader_readStreamSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+static bool TransactionReader_readColumnSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+static bool TransactionReader_readNextSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+static bool TransactionReader_readPrefetchedSection(TransactionReader reader, int64_t *sectionDeltaCentsOutPtr);
+static void *TransactionReader_prefetchThreadStart(void *readerAsVoidPtr);
+static enum TransactionToken TransactionReader_lexLine(
+    TransactionReader reader,
+    char const *chars,
+    size_t length,
+    int64_t *amountCentsOutPtr
+);
+
+/**
+ * Open the given transaction record file for reading. Besides a regular file, the path may be "-" for standard input,
+ * "fd:N" for file descriptor N inherited from the parent process, or a FIFO or other file which cannot be mapped; these
+ * are read as a text stream.
+ *
+ * @param name The name of the transaction record, used in error messages.
+ * @param filePath The path to the transaction record file.
+ *
+ * @returns The newly allocated TransactionReader. The caller is responsible for closing it.
+ */
+TransactionReader TransactionReader_open(char const * const name, char const * const filePath) {
+    guardNotNull(name, "name", "TransactionReader_open");
+    guardNotNull(filePath, "filePath", "TransactionReader_open");
+
+    TransactionReader const reader = TransactionReader_create(name, filePath);
+    if (TransactionReader_openStream(reader)) {
+        return reader;
+    }
+    safeMapFile(&reader->file, filePath, "TransactionReader_open");
+    TransactionReader_detectFormat(reader);
+
+    return reader;
+}
+
+/**
+ * Open the given text transaction record file for reading while it is still being appended to. At the end of the
+ * file, reading a section waits for more to be appended, and only returns once a whole section has arrived. Streams
+ * such as standard input or a FIFO (see TransactionReader_open) are read as usual, since they end when the writer does.
+ *
+ * @param name The name of the transaction record, used in error messages.
+ * @param filePath The path to the transaction record file.
+ * @param idleTimeoutMs How long to wait for the file to grow before treating it as ended, or 0 to wait forever.
+ *
+ * @returns The newly allocated TransactionReader. The caller is responsible for closing it.
+ */
+TransactionReader TransactionReader_openFollowing(
+    char const * const name,
+    char const * const filePath,
+    unsigned int const idleTimeoutMs
+) {
+    guardNotNull(name, "name", "TransactionReader_openFollowing");
+    guardNotNull(filePath, "filePath", "TransactionReader_openFollowing");
+
+    TransactionReader const reader = TransactionReader_create(name, filePath);
+    if (!TransactionReader_openStream(reader)) {
+        reader->format = TransactionFileFormat_textStream;
+        reader->stream = InputStream_openFile(filePath, true, idleTimeoutMs);
+    }
+    return reader;
+}
+
+static bool TransactionReader_openStream(TransactionReader const reader) {
+    char const * const filePath = reader->filePath;
+
+    int fd = -1;
+    if (strcmp(filePath, "-") == 0) {
+        fd = STDIN_FILENO;
+    } else if (strncmp(filePath, "fd:", 3) == 0) {
+        char *fdEnd;
+        errno = 0;
+        long const parsedFd = strtol(filePath + 3, &fdEnd, 10);
+        if (errno != 0 || fdEnd == filePath + 3 || *fdEnd != '\0' || parsedFd < 0 || parsedFd > INT_MAX) {
+            abortWithErrorFmt(
+                "TransactionReader_open: %s has an invalid inherited file descriptor \"%s\"",
+                reader->name,
+                filePath
+            );
+        }
+        fd = (int)parsedFd;
+    }
+
+    if (fd != -1) {
+        reader->stream = InputStream_openFd(fd, filePath);
+    } else if (TransactionReader_isStreamPath(filePath)) {
+        reader->stream = InputStream_openFile(filePath, false, 0);
+    } else {
+        return false;
+    }
+    reader->format = TransactionFileFormat_textStream;
+    return true;
+}
+
+/**
+ * Read a transaction record file which has already been read into memory, such as by readFilesBatched.
+ *
+ * @param name The name of the transaction record, used in error messages.
+ * @param filePath The path the file was read from, used in error messages.
+ * @param chars The contents of the file. The reader takes ownership of them and frees them when it is closed.
+ * @param length The length of the contents.
+ *
+ * @returns The newly allocated TransactionReader. The caller is responsible for closing it.
+ */
+TransactionReader TransactionReader_openContents(
+    char const * const name,
+    char const * const filePath,
+    char * const chars,
+    size_t const length
+) {
+    guardNotNull(name, "name", "TransactionReader_openContents");
+    guardNotNull(filePath, "filePath", "TransactionReader_openContents");
+    guard(chars != NULL || length == 0, "TransactionReader_openContents: chars must not be null");
+
+    TransactionReader const reader = TransactionReader_create(name, filePath);
+    reader->ownedChars = chars;
+    // A null mapping makes closing the reader leave the contents to be freed separately
+    reader->file = (struct MappedFile){.mapping = NULL, .chars = chars, .length = length, .position = 0};
+    TransactionReader_detectFormat(reader);
+    return reader;
+}
+
+/**
+ * Read transaction sections which have already been parsed into columns: every amount of the record in one array, and
+ * where each section starts in it.
+ *
+ * @param name The name of the transaction record, used in error messages.
+ * @param filePath The path the sections were read from, used in error messages.
+ * @param amountsCents The amounts of every section, in order. They must outlive the reader.
+ * @param sectionOffsets The index in amountsCents of the first amount of each section, followed by the total number of
+ *                       amounts. It must hold sectionCount + 1 offsets and outlive the reader.
+ * @param sectionCount The number of sections.
+ *
+ * @returns The newly allocated TransactionReader. The caller is responsible for closing it.
+ */
+TransactionReader TransactionReader_openColumns(
+    char const * const name,
+    char const * const filePath,
+    int64_t const * const amountsCents,
+    size_t const * const sectionOffsets,
+    size_t const sectionCount
+) {
+    guardNotNull(name, "name", "TransactionReader_openColumns");
+    guardNotNull(filePath, "filePath", "TransactionReader_openColumns");
+    guardNotNull(sectionOffsets, "sectionOffsets", "TransactionReader_openColumns");
+    guard(
+        amountsCents != NULL || sectionOffsets[sectionCount] == 0,
+        "TransactionReader_openColumns: amountsCents must not be null"
+    );
+
+    TransactionReader const reader = TransactionReader_create(name, filePath);
+    reader->format = TransactionFileFormat_columns;
+    reader->columnAmountsCents = amountsCents;
+    reader->columnSectionOffsets = sectionOffsets;
+    reader->sectionCount = sectionCount;
+    return reader;
+}
+
+/**
+ * Check whether a transaction record file path names a stream rather than a regular file: "-", "fd:N", or a FIFO or
+ * other file which is not regular. See TransactionReader_open.
+ *
+ * @param filePath The path to the transaction record file.
+ *
+ * @returns Whether the path names a stream. A path which does not exist is not a stream.
+ */
+bool TransactionReader_isStreamPath(char const * const filePath) {
+    guardNotNull(filePath, "filePath", "TransactionReader_isStreamPath");
+
+    if (strcmp(filePath, "-") == 0 || strncmp(filePath, "fd:", 3) == 0) {
+        return true;
+    }
+    struct stat fileStat;
+    return stat(filePath, &fileStat) != -1 && !S_ISREG(fileStat.st_mode);
+}
+
+static void TransactionReader_detectFormat(TransactionReader const reader) {
+    struct BinaryTransactionFileHeader header;
+    if (
+        reader->file.length >= sizeof header
+        && memcmp(reader->file.chars, BINARY_TRANSACTION_FILE_MAGIC, BINARY_TRANSACTION_FILE_MAGIC_LENGTH) == 0
+    ) {
+        memcpy(&header, reader->file.chars, sizeof header);
+        bool const supported = (
+            header.version == BINARY_TRANSACTION_FILE_VERSION
+            && (
+                header.encoding == BinaryTransactionEncoding_int64
+                || header.encoding == BinaryTransactionEncoding_varint
+            )
+        );
+        if (!supported) {
+            abortWithErrorFmt(
+                "TransactionReader_open: %s binary transaction file \"%s\" has an unsupported version or encoding (version: %u; encoding: %u)",
+                reader->name,
+                reader->filePath,
+                (unsigned int)header.version,
+                (unsigned int)header.encoding
+            );
+        }
+
+        reader->format = TransactionFileFormat_binary;
+        reader->binaryEncoding = (enum BinaryTransactionEncoding)header.encoding;
+        reader->dataOffset = sizeof header;
+        reader->sectionCount = header.sectionCount;
+    }
+    TransactionReader_rewind(reader);
+}
+
+static TransactionReader TransactionReader_create(char const * const name, char const * const filePath) {
+    TransactionReader const reader = safeMalloc(sizeof *reader, "TransactionReader_open");
+    reader->name = name;
+    reader->filePath = filePath;
+    reader->file = (struct MappedFile){.mapping = NULL, .chars = NULL, .length = 0, .position = 0};
+    reader->ownedChars = NULL;
+    reader->format = TransactionFileFormat_text;
+    reader->binaryEncoding = BinaryTransactionEncoding_int64;
+    reader->dataOffset = 0;
+    reader->sectionCount = 0;
+    reader->readSectionCount = 0;
+    reader->indexed = false;
+    reader->sectionSpans = NULL;
+    reader->sectionSpanCount = 0;
+    reader->stream = NULL;
+    reader->streamLexedLength = 0;
+    reader->streamSectionDeltaCents = 0;
+    reader->columnAmountsCents = NULL;
+    reader->columnSectionOffsets = NULL;
+    reader->collectedAmountsCents = NULL;
+    reader->collectedAccountIds = NULL;
+    reader->collectedAccountDeltasCents = NULL;
+    reader->prefetching = false;
+    return reader;
+}
+
+/**
+ * Unmap the transaction record file and free the memory associated with the TransactionReader.
+ *
+ * @param reader The TransactionReader instance.
+ */
+void TransactionReader_close(TransactionReader const reader) {
+    guardNotNull(reader, "reader", "TransactionReader_close");
+
+    if (reader->prefetching) {
+        safeMutexLock(&reader->prefetchMutex, "TransactionReader_close");
+        reader->prefetchStopping = true;
+        safeConditionBroadcast(&reader->prefetchCondition, "TransactionReader_close");
+        safeMutexUnlock(&reader->prefetchMutex, "TransactionReader_close");
+
+        safePthreadJoin(reader->prefetchThreadId, "TransactionReader_close");
+        safeConditionDestroy(&reader->prefetchCondition, "TransactionReader_close");
+        safeMutexDestroy(&reader->prefetchMutex, "TransactionReader_close");
+    }
+    safeUnmapFile(&reader->file, "TransactionReader_close");
+    if (reader->stream != NULL) {
+        InputStream_close(reader->stream);
+    }
+    free(reader->ownedChars);
+    free(reader->sectionSpans);
+    free(reader);
+}
+
+/**
+ * Read the next transaction section. If the file is malformed, abort the program with an error message.
+ *
+ * @param reader The TransactionReader instance.
+ * @param sectionDeltaCentsOutPtr The location to store the sum of the section's amounts, in cents.
+ *
+ * @returns Whether a section was read. If false, the end of the file was reached.
+ */
+bool TransactionReader_readSection(TransactionReader const reader, int64_t * const sectionDeltaCentsOutPtr) {
+    guardNotNull(reader, "reader", "TransactionReader_readSection");
+    guardNotNull(sectionDeltaCentsOutPtr, "sectionDeltaCentsOutPtr", "TransactionReader_readSection");
+
+    if (reader->prefetching) {
+        return TransactionReader_readPrefetchedSection(reader, sectionDeltaCentsOutPtr);
+    }
+    return TransactionReader_readNextSection(reader, sectionDeltaCentsOutPtr);
+}
+
+/**
+ * Get the contents of the transaction record file, as mapped or read into memory.
+ *
+ * @param reader The TransactionReader instance.
+ * @param lengthOutPtr The location to store the number of characters.
+ *
+ * @returns The characters, or null if the reader is streamed or reads columns.
+ */
+char const *TransactionReader_contents(TransactionReader const reader, size_t * const lengthOutPtr) {
+    guardNotNull(reader, "reader", "TransactionReader_contents");
+    guardNotNull(lengthOutPtr, "lengthOutPtr", "TransactionReader_contents");
+
+    if (reader->format == TransactionFileFormat_textStream || reader->format == TransactionFileFormat_columns) {
+        *lengthOutPtr = 0;
+        return NULL;
+    }
+    *lengthOutPtr = reader->file.length;
+    return reader->file.chars;
+}
+
+/**
+ * Get the offset in the file just past the last section read, where the next section is read from.
+ *
+ * @param reader The TransactionReader instance. It must have contents (see TransactionReader_contents) and must not be
+ *               indexed or prefetching.
+ *
+ * @returns The offset.
+ */
+size_t TransactionReader_offset(TransactionReader const reader) {
+    guardNotNull(reader, "reader", "TransactionReader_offset");
+    TransactionReader_guardSeekable(reader, "TransactionReader_offset");
+    return reader->file.position;
+}
+
+/**
+ * Continue reading from an offset previously returned by TransactionReader_offset for a file with the same contents up
+ * to that offset, as though the sections before it had already been read.
+ *
+ * @param reader The TransactionReader instance. It must have contents (see TransactionReader_contents), must not be
+ *               indexed or prefetching and must not have read any section yet.
+ * @param offset The offset of the next section to read.
+ * @param sectionCount The number of sections before the offset.
+ */
+void TransactionReader_skipTo(TransactionReader const reader, size_t const offset, size_t const sectionCount) {
+    guardNotNull(reader, "reader", "TransactionReader_skipTo");
+    TransactionReader_guardSeekable(reader, "TransactionReader_skipTo");
+    guard(reader->readSectionCount == 0, "TransactionReader_skipTo: A section has already been read");
+    if (offset < reader->dataOffset || offset > reader->file.length) {
+        abortWithErrorFmt(
+            "TransactionReader_skipTo: Offset out of range for \"%s\" (offset: %zu; length: %zu)",
+            reader->filePath,
+            offset,
+            reader->file.length
+        );
+    }
+    if (reader->format == TransactionFileFormat_binary && sectionCount > reader->sectionCount) {
+        abortWithErrorFmt(
+            "TransactionReader_skipTo: Section count out of range for \"%s\" (%zu > %llu)",
+            reader->filePath,
+            sectionCount,
+            (unsigned long long)reader->sectionCount
+        );
+    }
+
+    reader->file.position = offset;
+    reader->readSectionCount = sectionCount;
+}
+
+/**
+ * Start a helper thread which reads ahead of TransactionReader_readSection, keeping up to two summed sections ready.
+ * Sections are still returned in file order, and a malformed section is still reported, only earlier. The reader must
+ * then only be used by one thread besides the helper, and be closed only once it has been read to the end, since the
+ * helper cannot be interrupted while it waits for a followed file to grow.
+ *
+ * @param reader The TransactionReader instance. It must not already be prefetching.
+ */
+void TransactionReader_startPrefetch(TransactionReader const reader) {
+    guardNotNull(reader, "reader", "TransactionReader_startPrefetch");
+    guard(!reader->prefetching, "TransactionReader_startPrefetch: The reader is already prefetching");
+
+    safeMutexInit(&reader->prefetchMutex, NULL, "TransactionReader_startPrefetch");
+    safeConditionInit(&reader->prefetchCondition, NULL, "TransactionReader_startPrefetch");
+    reader->prefetchedSectionStart = 0;
+    reader->prefetchedSectionCount = 0;
+    reader->prefetchEnded = false;
+    reader->prefetchStopping = false;
+    reader->prefetching = true;
+    reader->prefetchThreadId = safePthreadCreate(
+        NULL,
+        TransactionReader_prefetchThreadStart,
+        reader,
+        "TransactionReader_startPrefetch"
+    );
+}
+
+static bool TransactionReader_readPrefetchedSection(
+    TransactionReader const reader,
+    int64_t * const sectionDeltaCentsOutPtr
+) {
+    safeMutexLock(&reader->prefetchMutex, "TransactionReader_readSection");
+    while (reader->prefetchedSectionCount == 0 && !reader->prefetchEnded) {
+        safeConditionWait(&reader->prefetchCondition, &reader->prefetchMutex, "TransactionReader_readSection");
+    }
+
+    bool const sectionRead = reader->prefetchedSectionCount > 0;
+    if (sectionRead) {
+        *sectionDeltaCentsOutPtr = reader->prefetchedSectionDeltasCents[reader->prefetchedSectionStart];
+        reader->prefetchedSectionStart = (reader->prefetchedSectionStart + 1) % PREFETCH_SLOT_COUNT;
+        reader->prefetchedSectionCount -= 1;
+        safeConditionBroadcast(&reader->prefetchCondition, "TransactionReader_readSection");
+    }
+    safeMutexUnlock(&reader->prefetchMutex, "TransactionReader_readSection");
+
+    return sectionRead;
+}
+
+static void *TransactionReader_prefetchThreadStart(void * const readerAsVoidPtr) {
+    TransactionReader const reader = readerAsVoidPtr;
+
+    while (true) {
+        int64_t sectionDeltaCents;
+        bool const sectionRead = TransactionReader_readNextSection(reader, &sectionDeltaCents);
+
+        safeMutexLock(&reader->prefetchMutex, "TransactionReader prefetch");
+        while (reader->prefetchedSectionCount == PREFETCH_SLOT_COUNT && !reader->prefetchStopping) {
+            safeConditionWait(&reader->prefetchCondition, &reader->prefetchMutex, "TransactionReader prefetch");
+        }
+        bool const stop = !sectionRead || reader->prefetchStopping;
+        if (!sectionRead) {
+            reader->prefetchEnded = true;
+        } else if (!reader->prefetchStopping) {
+            size_t const slotIndex = (reader->prefetchedSectionStart + reader->prefetchedSectionCount) % PREFETCH_SLOT_COUNT;
+            reader->prefetchedSectionDeltasCents[slotIndex] = sectionDeltaCents;
+            reader->prefetchedSectionCount += 1;
+        }
+        safeConditionBroadcast(&reader->prefetchCondition, "TransactionReader prefetch");
+        safeMutexUnlock(&reader->prefetchMutex, "TransactionReader prefetch");
+
+        if (stop) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Read the next transaction section, like TransactionReader_readSection, and also append each of its amounts to the
+ * given list.
+ *
+ * @param reader The TransactionReader instance. It must not be indexed, prefetching or reading columns.
+ * @param amountsCents The list to append the amounts of the section to, in cents.
+ * @param sectionDeltaCentsOutPtr The location to store the sum of the section's amounts, in cents.
+ *
+ * @returns Whether a section was read. If false, the end of the file was reached.
+ */
+bool TransactionReader_readSectionAmounts(
+    TransactionReader const reader,
+    Int64List const amountsCents,
+    int64_t * const sectionDeltaCentsOutPtr
+) {
+    guardNotNull(reader, "reader", "TransactionReader_readSectionAmounts");
+    guardNotNull(amountsCents, "amountsCents", "TransactionReader_readSectionAmounts");
+    guardNotNull(sectionDeltaCentsOutPtr, "sectionDeltaCentsOutPtr", "TransactionReader_readSectionAmounts");
+    guard(
+        !reader->indexed && !reader->prefetching && reader->format != TransactionFileFormat_columns,
+        "TransactionReader_readSectionAmounts: Amounts cannot be read from an indexed, prefetching or column reader"
+    );
+
+    reader->collectedAmountsCents = amountsCents;
+    bool const sectionRead = TransactionReader_readNextSection(reader, sectionDeltaCentsOutPtr);
+    reader->collectedAmountsCents = NULL;
+    return sectionRead;
+}
+
+/**
+ * Read the next transaction section of a text file whose transactions may carry account IDs (see
+ * lexAccountTransactionLine), summing the section into the change it makes to each account it touches. The accounts are
+ * listed in the order the section first touches them; a section usually touches only a few, so each amount is matched
+ * to its account by searching the accounts listed so far from the most recent.
+ *
+ * @param reader The TransactionReader instance. It must be reading a text file or stream, and must not be indexed or
+ *               prefetching.
+ * @param accountIds The list to append the ID of each account the section touches to. It must be empty.
+ * @param accountDeltasCents The list to append the sum of the section's amounts for each of those accounts to, in
+ *                           cents. It must be empty.
+ *
+ * @returns Whether a section was read. If false, the end of the file was reached.
+ */
+bool TransactionReader_readAccountSection(
+    TransactionReader const reader,
+    Uint64List const accountIds,
+    Int64List const accountDeltasCents
+) {
+    guardNotNull(reader, "reader", "TransactionReader_readAccountSection");
+    guardNotNull(accountIds, "accountIds", "TransactionReader_readAccountSection");
+    guardNotNull(accountDeltasCents, "accountDeltasCents", "TransactionReader_readAccountSection");
+    guard(
+        (reader->format == TransactionFileFormat_text || reader->format == TransactionFileFormat_textStream)
+            && !reader->indexed
+            && !reader->prefetching,
+        "TransactionReader_readAccountSection: Account sections can only be read from an unindexed text reader"
+    );
+    guard(
+        Uint64List_empty(accountIds) && Int64List_empty(accountDeltasCents),
+        "TransactionReader_readAccountSection: The account lists must be empty"
+    );
+
+    reader->collectedAccountIds = accountIds;
+    reader->collectedAccountDeltasCents = accountDeltasCents;
+    int64_t unusedSectionDeltaCents;
+    bool const sectionRead = TransactionReader_readNextSection(reader, &unusedSectionDeltaCents);
+    reader->collectedAccountIds = NULL;
+    reader->collectedAccountDeltasCents = NULL;
+    return sectionRead;
+}
+
+static bool TransactionReader_readNextSection(TransactionReader const reader, int64_t * const sectionDeltaCentsOutPtr) {
+    if (reader->indexed) {
+        return TransactionReader_readIndexedSection(reader, sectionDeltaCentsOutPtr);
+    }
+
+    struct TransactionSectionSpan unusedSectionSpan;
+    switch (reader->format) {
+        case TransactionFileFormat_text: {
+            return TransactionReader_readTextSection(reader, sectionDeltaCentsOutPtr, &unusedSectionSpan);
+        }
+        case TransactionFileFormat_binary: {
+            return TransactionReader_readBinarySection(reader, sectionDeltaCentsOutPtr, &unusedSectionSpan);
+        }
+        case TransactionFileFormat_textStream: {
+            return TransactionReader_readStreamSection(reader, sectionDeltaCentsOutPtr);
+        }
+        case TransactionFileFormat_columns: {
+            return TransactionReader_readColumnSection(reader, sectionDeltaCentsOutPtr);
+        }
+        default: {
+            abortWithErrorFmt("TransactionReader_readSection: Invalid format (%d)", (int)reader->format);
+            return false;
+        }
+    }
+}
+
+/**
+ * Validate the whole transaction record file and index where each of its sections is, then rewind the reader. Later
+ * sections are read from the index without validating them again. If the file is malformed, abort the program with an
+ * error message. Readers are independent, so different readers may be indexed on different threads at the same time.
+ * A streamed reader cannot be read ahead, so it is left unindexed and validates its sections as they are read.
+ *
+ * @param reader The TransactionReader instance. No sections may have been read from it yet.
+ */
+void TransactionReader_index(TransactionReader const reader) {
+    guardNotNull(reader, "reader", "TransactionReader_index");
+    guard(
+        !reader->indexed && reader->readSectionCount == 0,
+        "TransactionReader_index: The reader has already been indexed or read from"
+    );
+    if (reader->format == TransactionFileFormat_textStream || reader->format == TransactionFileFormat_columns) {
+        return;
+    }
+
+    size_t sectionSpanCapacity = 0;
+    while (true) {
+        struct TransactionSectionSpan sectionSpan;
+        int64_t unusedSectionDeltaCents;
+        bool const sectionRead = reader->format == TransactionFileFormat_text
+            ? TransactionReader_readTextSection(reader, &unusedSectionDeltaCents, &sectionSpan)
+            : TransactionReader_readBinarySection(reader, &unusedSectionDeltaCents, &sectionSpan);
+        if (!sectionRead) {
+            break;
+        }
+
+        if (reader->sectionSpanCount == sectionSpanCapacity) {
+            sectionSpanCapacity = sectionSpanCapacity == 0 ? 16 : sectionSpanCapacity * 2;
+            reader->sectionSpans = safeRealloc(
+                reader->sectionSpans,
+                sizeof *reader->sectionSpans * sectionSpanCapacity,
+                "TransactionReader_index"
+            );
+        }
+        reader->sectionSpans[reader->sectionSpanCount] = sectionSpan;
+        reader->sectionSpanCount += 1;
+    }
+
+    TransactionReader_rewind(reader);
+    reader->indexed = true;
+}
+
+/**
+ * Split the transaction record file into chunks of whole sections, each read by its own TransactionReader, so that the
+ * chunks can be summed on different threads. The chunks cover the file in order and are about equal in size. Text
+ * files are only cut just before a BeginTransactionSection line; binary files are cut by walking the section headers.
+ * The chunks are not indexed, so they validate their sections as they are read.
+ *
+ * @param reader The TransactionReader instance. No sections may have been read from it yet. It must not be closed
+ *               before the chunks, which read from its mapping.
+ * @param maxChunkCount The maximum number of chunks to split the file into.
+ * @param chunksOut The array to store the chunks in. It must hold at least maxChunkCount readers. The caller is
+ *                  responsible for closing each chunk.
+ *
+ * @returns The number of chunks, which is at least 1 and at most maxChunkCount.
+ */
+size_t TransactionReader_split(
+    TransactionReader const reader,
+    size_t const maxChunkCount,
+    TransactionReader * const chunksOut
+) {
+    guardNotNull(reader, "reader", "TransactionReader_split");
+    guardNotNull(chunksOut, "chunksOut", "TransactionReader_split");
+    guard(maxChunkCount > 0, "TransactionReader_split: maxChunkCount must be greater than 0");
+    guard(reader->readSectionCount == 0, "TransactionReader_split: The reader has already been read from");
+    guard(
+        reader->format != TransactionFileFormat_textStream && reader->format != TransactionFileFormat_columns,
+        "TransactionReader_split: A streamed or column reader cannot be split"
+    );
+
+    size_t const dataLength = reader->file.length - reader->dataOffset;
+    size_t chunkCount = 0;
+    size_t chunkBegin = reader->dataOffset;
+
+    if (reader->format == TransactionFileFormat_text) {
+        for (size_t i = 1; i < maxChunkCount && chunkBegin < reader->file.length; i += 1) {
+            size_t const targetPosition = reader->dataOffset + dataLength / maxChunkCount * i;
+            if (targetPosition <= chunkBegin) {
+                continue;
+            }
+            size_t const chunkEnd = TransactionReader_findSectionStart(reader, targetPosition);
+            if (chunkEnd == reader->file.length) {
+                break;
+            }
+            chunksOut[chunkCount] = TransactionReader_createChunk(reader, chunkBegin, chunkEnd, 0);
+            chunkCount += 1;
+            chunkBegin = chunkEnd;
+        }
+        chunksOut[chunkCount] = TransactionReader_createChunk(reader, chunkBegin, reader->file.length, 0);
+        return chunkCount + 1;
+    }
+
+    // Walk the amount counts; a malformed file stops the walk, and the last chunk then reports the error when read
+    size_t position = reader->dataOffset;
+    uint64_t chunkSectionCount = 0;
+    uint64_t remainingSectionCount = reader->sectionCount;
+    while (remainingSectionCount > 0 && chunkCount + 1 < maxChunkCount) {
+        if (reader->binaryEncoding == BinaryTransactionEncoding_varint) {
+            struct VarintSection section;
+            if (!readVarintSectionHeader(reader->file.chars, reader->file.length, position, &section)) {
+                break;
+            }
+            position = section.end;
+        } else {
+            if (reader->file.length - position < sizeof (uint64_t)) {
+                break;
+            }
+            uint64_t amountCount;
+            memcpy(&amountCount, reader->file.chars + position, sizeof amountCount);
+            if (amountCount > (reader->file.length - position - sizeof amountCount) / sizeof (int64_t)) {
+                break;
+            }
+            position += sizeof amountCount + (size_t)amountCount * sizeof (int64_t);
+        }
+        chunkSectionCount += 1;
+        remainingSectionCount -= 1;
+
+        size_t const targetPosition = reader->dataOffset + dataLength / maxChunkCount * (chunkCount + 1);
+        if (position >= targetPosition && remainingSectionCount > 0) {
+            chunksOut[chunkCount] = TransactionReader_createChunk(reader, chunkBegin, position, chunkSectionCount);
+            chunkCount += 1;
+            chunkBegin = position;
+            chunkSectionCount = 0;
+        }
+    }
+    chunksOut[chunkCount] = TransactionReader_createChunk(
+        reader,
+        chunkBegin,
+        reader->file.length,
+        chunkSectionCount + remainingSectionCount
+    );
+    return chunkCount + 1;
+}
+
+static TransactionReader TransactionReader_createChunk(
+    TransactionReader const reader,
+    size_t const begin,
+    size_t const end,
+    uint64_t const sectionCount
+) {
+    TransactionReader const chunk = safeMalloc(sizeof *chunk, "TransactionReader_split");
+    chunk->name = reader->name;
+    chunk->filePath = reader->filePath;
+    // A null mapping makes closing the chunk leave the parent's mapping alone
+    chunk->file = (struct MappedFile){
+        .mapping = NULL,
+        .chars = reader->file.chars + begin,
+        .length = end - begin,
+        .position = 0
+    };
+    chunk->ownedChars = NULL;
+    chunk->format = reader->format;
+    chunk->binaryEncoding = reader->binaryEncoding;
+    chunk->dataOffset = 0;
+    chunk->sectionCount = sectionCount;
+    chunk->readSectionCount = 0;
+    chunk->indexed = false;
+    chunk->sectionSpans = NULL;
+    chunk->sectionSpanCount = 0;
+    chunk->stream = NULL;
+    chunk->streamLexedLength = 0;
+    chunk->streamSectionDeltaCents = 0;
+    chunk->columnAmountsCents = NULL;
+    chunk->columnSectionOffsets = NULL;
+    chunk->collectedAmountsCents = NULL;
+    chunk->collectedAccountIds = NULL;
+    chunk->collectedAccountDeltasCents = NULL;
+    chunk->prefetching = false;
+    return chunk;
+}
+
+static size_t TransactionReader_findSectionStart(TransactionReader const reader, size_t position) {
+    char const * const chars = reader->file.chars;
+    size_t const length = reader->file.length;
+
+    // Move to the start of the next line, unless already at one
+    if (position > 0 && chars[position - 1] != '\n') {
+        char const * const newline = findNewline(chars + position, length - position);
+        if (newline == NULL) {
+            return length;
+        }
+        position = (size_t)(newline - chars) + 1;
+    }
+
+    while (position < length) {
+        if (chars[position] == 'R' && (position + 1 == length || chars[position + 1] == '\n')) {
+            return position;
+        }
+        char const * const newline = findNewline(chars + position, length - position);
+        if (newline == NULL) {
+            return length;
+        }
+        position = (size_t)(newline - chars) + 1;
+    }
+    return length;
+}
+
+static void TransactionReader_guardSeekable(TransactionReader const reader, char const * const callerDescription) {
+    bool const seekable = (
+        (reader->format == TransactionFileFormat_text || reader->format == TransactionFileFormat_binary)
+        && !reader->indexed
+        && !reader->prefetching
+    );
+    if (!seekable) {
+        abortWithErrorFmt(
+            "%s: \"%s\" is streamed, reads columns, or is indexed or prefetching",
+            callerDescription,
+            reader->filePath
+        );
+    }
+}
+
+static void TransactionReader_rewind(TransactionReader const reader) {
+    reader->file.position = reader->dataOffset;
+    reader->readSectionCount = 0;
+}
+
+static bool TransactionReader_readIndexedSection(
+    TransactionReader const reader,
+    int64_t * const sectionDeltaCentsOutPtr
+) {
+    if (reader->readSectionCount == reader->sectionSpanCount) {
+        return false;
+    }
+    struct TransactionSectionSpan const sectionSpan = reader->sectionSpans[reader->readSectionCount];
+    reader->readSectionCount += 1;
+
+    char const * const sectionChars = reader->file.chars + sectionSpan.begin;
+    size_t const sectionLength = sectionSpan.end - sectionSpan.begin;
+    if (reader->format == TransactionFileFormat_text) {
+        *sectionDeltaCentsOutPtr = sumValidCentsLines(sectionChars, sectionLength);
+        return true;
+    }
+    if (reader->binaryEncoding == BinaryTransactionEncoding_varint) {
+        // The span is the whole block, which was checked when the reader was indexed
+        struct VarintSection section;
+        readVarintSectionHeader(reader->file.chars, sectionSpan.end, sectionSpan.begin, &section);
+        decodeVarintSection(reader->file.chars, &section, NULL, sectionDeltaCentsOutPtr);
+        return true;
+    }
+
+    // The header and every amount count are whole words, so the amounts of a mapped or read file are word-aligned
+    *sectionDeltaCentsOutPtr = sumInt64s(
+        (int64_t const *)(void const *)sectionChars,
+        sectionLength / sizeof (int64_t)
+    );
+    return true;
+}
+
+static bool TransactionReader_readTextSection(
+    TransactionReader const reader,
+    int64_t * const sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan * const sectionSpanOutPtr
+) {
+    // Lines are lexed in place in the mapping, without copying
+    struct FileLine line;
+    if (!readMappedFileLine(&reader->file, &line)) {
+        return false;
+    }
+    int64_t amountCents;
+    if (lexTransactionLine(line.chars, line.length, &amountCents) != TransactionToken_beginSection) {
+        abortWithErrorFmt(
+            "TransactionReader_readSection: %s thread failed to parse BeginTransactionSection symbol from \"%s\" (line: \"%.*s\")",
+            reader->name,
+            reader->filePath,
+            (int)line.length,
+            line.chars
+        );
+        return false;
+    }
+
+    sectionSpanOutPtr->begin = reader->file.position;
+
+    // Cents add exactly, so summing the section up front gives the same balance as adding each amount under the lock
+    int64_t deltaCents = 0;
+    while (true) {
+        if (!readMappedFileLine(&reader->file, &line)) {
+            abortWithErrorFmt(
+                "TransactionReader_readSection: %s thread reached EOF before EndTransactionSection symbol was parsed from \"%s\"",
+                reader->name,
+                reader->filePath
+            );
+            break;
+        }
+        enum TransactionToken const token = TransactionReader_lexLine(reader, line.chars, line.length, &amountCents);
+        if (token == TransactionToken_endSection) {
+            sectionSpanOutPtr->end = (size_t)(line.chars - reader->file.chars);
+            break;
+        }
+        if (token != TransactionToken_transaction) {
+            abortWithErrorFmt(
+                "TransactionReader_readSection: %s thread failed to parse Deposit, Withdraw, or EndTransactionSection symbol from \"%s\" (line: \"%.*s\")",
+                reader->name,
+                reader->filePath,
+                (int)line.length,
+                line.chars
+            );
+            break;
+        }
+
+        deltaCents = ADD_CENTS(deltaCents, amountCents);
+        if (reader->collectedAmountsCents != NULL) {
+            Int64List_add(reader->collectedAmountsCents, amountCents);
+        }
+    }
+
+    *sectionDeltaCentsOutPtr = deltaCents;
+    reader->readSectionCount += 1;
+    return true;
+}
+
+static bool TransactionReader_readBinarySection(
+    TransactionReader const reader,
+    int64_t * const sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan * const sectionSpanOutPtr
+) {
+    if (reader->readSectionCount == reader->sectionCount) {
+        if (reader->file.position != reader->file.length) {
+            abortWithErrorFmt(
+                "TransactionReader_readSection: %s binary transaction file \"%s\" has %zu bytes of trailing data after its last section",
+                reader->name,
+                reader->filePath,
+                reader->file.length - reader->file.position
+            );
+        }
+        return false;
+    }
+    if (reader->binaryEncoding == BinaryTransactionEncoding_varint) {
+        return TransactionReader_readVarintSection(reader, sectionDeltaCentsOutPtr, sectionSpanOutPtr);
+    }
+
+    uint64_t const amountCount = TransactionReader_readBinaryWord(reader);
+    if (amountCount > (reader->file.length - reader->file.position) / sizeof (int64_t)) {
+        abortWithErrorFmt(
+            "TransactionReader_readSection: %s binary transaction file \"%s\" is truncated (section %llu has %llu amounts)",
+            reader->name,
+            reader->filePath,
+            (unsigned long long)reader->readSectionCount,
+            (unsigned long long)amountCount
+        );
+    }
+
+    sectionSpanOutPtr->begin = reader->file.position;
+    sectionSpanOutPtr->end = reader->file.position + (size_t)amountCount * sizeof (int64_t);
+
+    // The amounts were validated by the converter, so they are only summed here
+    int64_t deltaCents = 0;
+    for (uint64_t i = 0; i < amountCount; i += 1) {
+        int64_t const amountCents = (int64_t)TransactionReader_readBinaryWord(reader);
+        deltaCents = ADD_CENTS(deltaCents, amountCents);
+        if (reader->collectedAmountsCents != NULL) {
+            Int64List_add(reader->collectedAmountsCents, amountCents);
+        }
+    }
+
+    reader->readSectionCount += 1;
+    *sectionDeltaCentsOutPtr = deltaCents;
+    return true;
+}
+
+static uint64_t TransactionReader_readBinaryWord(TransactionReader const reader) {
+    if (reader->file.length - reader->file.position < sizeof (uint64_t)) {
+        abortWithErrorFmt(
+            "TransactionReader_readSection: %s binary transaction file \"%s\" is truncated (section %llu)",
+            reader->name,
+            reader->filePath,
+            (unsigned long long)reader->readSectionCount
+        );
+    }
+
+    uint64_t word;
+    memcpy(&word, reader->file.chars + reader->file.position, sizeof word);
+    reader->file.position += sizeof word;
+    return word;
+}
+
+static bool TransactionReader_readVarintSection(
+    TransactionReader const reader,
+    int64_t * const sectionDeltaCentsOutPtr,
+    struct TransactionSectionSpan * const sectionSpanOutPtr
+) {
+    struct VarintSection section;
+    bool const valid = (
+        readVarintSectionHeader(reader->file.chars, reader->file.length, reader->file.position, &section)
+        && decodeVarintSection(reader->file.chars, &section, reader->collectedAmountsCents, sectionDeltaCentsOutPtr)
+    );
+    if (!valid) {
+        abortWithErrorFmt(
+            "TransactionReader_readSection: %s binary transaction file \"%s\" is truncated or malformed (section %llu)",
+            reader->name,
+            reader->filePath,
+            (unsigned long long)reader->readSectionCount
+        );
+    }
+
+    sectionSpanOutPtr->begin = reader->file.position;
+    sectionSpanOutPtr->end = section.end;
+    reader->file.position = section.end;
+    reader->readSectionCount += 1;
+    return true;
+}
+
+static bool TransactionReader_readStreamSection(TransactionReader const reader, int64_t * const sectionDeltaCentsOutPtr) {
+    // Lines of the current section are lexed as they arrive and stay buffered until the whole section has been read, so
+    // a section cut off part way is never applied
+    while (true) {
+        char const *chars = InputStream_chars(reader->stream);
+        size_t const length = InputStream_length(reader->stream);
+        size_t const lineStart = reader->streamLexedLength;
+
+        if (lineStart == length) {
+            if (InputStream_fill(reader->stream)) {
+                continue;
+            }
+            if (lineStart == 0) {
+                return false;
+            }
+            abortWithErrorFmt(
+                "TransactionReader_readSection: %s thread reached EOF before EndTransactionSection symbol was parsed from \"%s\"",
+                reader->name,
+                reader->filePath
+            );
+            return false;
+        }
+
+        char const * const newline = findNewline(chars + lineStart, length - lineStart);
+        size_t lineLength;
+        size_t nextLineStart;
+        if (newline != NULL) {
+            lineLength = (size_t)(newline - (chars + lineStart));
+            nextLineStart = lineStart + lineLength + 1;
+        } else if (InputStream_fill(reader->stream)) {
+            // The line may not have been completely written yet
+            continue;
+        } else {
+            // The stream ended without a final newline; filling may have moved the buffered data
+            chars = InputStream_chars(reader->stream);
+            lineLength = length - lineStart;
+            nextLineStart = length;
+        }
+
+        char const * const lineChars = chars + lineStart;
+        int64_t amountCents;
+        enum TransactionToken const token = TransactionReader_lexLine(reader, lineChars, lineLength, &amountCents);
+        if (lineStart == 0) {
+            if (token != TransactionToken_beginSection) {
+                abortWithErrorFmt(
+                    "TransactionReader_readSection: %s thread failed to parse BeginTransactionSection symbol from \"%s\" (line: \"%.*s\")",
+                    reader->name,
+                    reader->filePath,
+                    (int)lineLength,
+                    lineChars
+                );
+                return false;
+            }
+        } else if (token == TransactionToken_endSection) {
+            *sectionDeltaCentsOutPtr = reader->streamSectionDeltaCents;
+            InputStream_consume(reader->stream, nextLineStart);
+            reader->streamLexedLength = 0;
+            reader->streamSectionDeltaCents = 0;
+            reader->readSectionCount += 1;
+            return true;
+        } else if (token == TransactionToken_transaction) {
+            reader->streamSectionDeltaCents = ADD_CENTS(reader->streamSectionDeltaCents, amountCents);
+            if (reader->collectedAmountsCents != NULL) {
+                Int64List_add(reader->collectedAmountsCents, amountCents);
+            }
+        } else {
+            abortWithErrorFmt(
+                "TransactionReader_readSection: %s thread failed to parse Deposit, Withdraw, or EndTransactionSection symbol from \"%s\" (line: \"%.*s\")",
+                reader->name,
+                reader->filePath,
+                (int)lineLength,
+                lineChars
+            );
+            return false;
+        }
+
+        reader->streamLexedLength = nextLineStart;
+    }
+}
+
+static enum TransactionToken TransactionReader_lexLine(
+    TransactionReader const reader,
+    char const * const chars,
+    size_t const length,
+    int64_t * const amountCentsOutPtr
+) {
+    if (reader->collectedAccountIds == NULL) {
+        return lexTransactionLine(chars, length, amountCentsOutPtr);
+    }
+
+    uint64_t accountId;
+    enum TransactionToken const token = lexAccountTransactionLine(chars, length, &accountId, amountCentsOutPtr);
+    if (token != TransactionToken_transaction) {
+        return token;
+    }
+
+    size_t accountIndex = Uint64List_count(reader->collectedAccountIds);
+    while (accountIndex > 0 && Uint64List_get(reader->collectedAccountIds, accountIndex - 1) != accountId) {
+        accountIndex -= 1;
+    }
+    if (accountIndex == 0) {
+        Uint64List_add(reader->collectedAccountIds, accountId);
+        Int64List_add(reader->collectedAccountDeltasCents, *amountCentsOutPtr);
+    } else {
+        int64_t * const accountDeltaCentsPtr = Int64List_getPtr(reader->collectedAccountDeltasCents, accountIndex - 1);
+        *accountDeltaCentsPtr = ADD_CENTS(*accountDeltaCentsPtr, *amountCentsOutPtr);
+    }
+    return token;
+}
+
+static bool TransactionReader_readColumnSection(TransactionReader const reader, int64_t * const sectionDeltaCentsOutPtr) {
+    if (reader->readSectionCount == reader->sectionCount) {
+        return false;
+    }
+    size_t const sectionIndex = (size_t)reader->readSectionCount;
+    reader->readSectionCount += 1;
+
+    size_t const amountsBegin = reader->columnSectionOffsets[sectionIndex];
+    size_t const amountsEnd = reader->columnSectionOffsets[sectionIndex + 1];
+    *sectionDeltaCentsOutPtr = sumInt64s(reader->columnAmountsCents + amountsBegin, amountsEnd - amountsBegin);
+    return true;
+}
@@ -0,0 +1,274 @@
+#include "../../include/hw8/TransactionStore.h"
+
+#include "../../include/hw8/TransactionReader.h"
+#include "../../include/hw8/SectionCache.h"
+#include "../../include/util/ThreadPool.h"
+#include "../../include/util/lists.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * The parsed amounts of one transaction record: every amount of every section in one contiguous array, and the index
+ * in it where each section starts, followed by the total number of amounts.
+ */
+struct TransactionStoreRecord {
+    Int64List amountsCents;
+    SizeList sectionOffsets;
+};
+
+/**
+ * Represents the transaction records parsed once into columns, so they can be processed any number of times without
+ * reading or parsing the files again. Each section's delta is then a reduction over contiguous memory. A store built
+ * from the section cache holds each section's delta as its only amount.
+ */
+struct TransactionStore {
+    struct TransactionStoreRecord *records;
+    size_t recordCount;
+};
+
+struct TransactionStoreBuildArg {
+    TransactionReader const *readers;
+    char const * const *filePaths;
+    struct TransactionStoreRecord *records;
+    enum SectionCacheResult *cacheResults;
+};
+
+static TransactionStore TransactionStore_buildWith(
+    struct TransactionStoreBuildArg *argPtr,
+    size_t recordCount,
+    size_t threadCount,
+    ThreadPoolTask buildRecord
+);
+static void TransactionStore_buildRecord(void *argAsVoidPtr, size_t recordIndex);
+static void TransactionStore_buildCachedRecord(void *argAsVoidPtr, size_t recordIndex);
+static void TransactionStore_guardRecordIndex(
+    TransactionStore store,
+    size_t recordIndex,
+    char const *callerDescription
+);
+
+/**
+ * Build a TransactionStore by reading every section of the given transaction readers, each of which is validated as
+ * it is read. The readers are read to their end in parallel and are not closed.
+ *
+ * @param readers The transaction readers, which must not be indexed or prefetching.
+ * @param recordCount The number of transaction readers.
+ * @param threadCount The number of threads to read the readers on, or 0 for one per online processor.
+ *
+ * @returns The newly allocated TransactionStore. The caller is responsible for freeing this memory.
+ */
+TransactionStore TransactionStore_build(
+    TransactionReader const * const readers,
+    size_t const recordCount,
+    size_t const threadCount
+) {
+    guardNotNull(readers, "readers", "TransactionStore_build");
+
+    return TransactionStore_buildWith(
+        &(struct TransactionStoreBuildArg){.readers = readers, .filePaths = NULL, .cacheResults = NULL},
+        recordCount,
+        threadCount,
+        TransactionStore_buildRecord
+    );
+}
+
+/**
+ * Build a TransactionStore holding only the delta of each section, rather than every amount, using the section cache
+ * next to each transaction record file (see readSectionDeltasCached). Unchanged files are then not read at all. The
+ * readers are read in parallel and are not closed.
+ *
+ * @param readers The transaction readers, which must not be indexed or prefetching.
+ * @param filePaths The path of each transaction reader's file.
+ * @param recordCount The number of transaction readers.
+ * @param threadCount The number of threads to read the readers on, or 0 for one per online processor.
+ * @param cacheResultsOutPtr The location to store how the cache was used for each transaction record.
+ *
+ * @returns The newly allocated TransactionStore. The caller is responsible for freeing this memory.
+ */
+TransactionStore TransactionStore_buildCached(
+    TransactionReader const * const readers,
+    char const * const * const filePaths,
+    size_t const recordCount,
+    size_t const threadCount,
+    enum SectionCacheResult * const cacheResultsOutPtr
+) {
+    guardNotNull(readers, "readers", "TransactionStore_buildCached");
+    guardNotNull(filePaths, "filePaths", "TransactionStore_buildCached");
+    guardNotNull(cacheResultsOutPtr, "cacheResultsOutPtr", "TransactionStore_buildCached");
+
+    return TransactionStore_buildWith(
+        &(struct TransactionStoreBuildArg){.readers = readers, .filePaths = filePaths, .cacheResults = cacheResultsOutPtr},
+        recordCount,
+        threadCount,
+        TransactionStore_buildCachedRecord
+    );
+}
+
+/**
+ * Free the memory associated with the TransactionStore. Any reader opened from it must have been closed.
+ *
+ * @param store The TransactionStore instance.
+ */
+void TransactionStore_destroy(TransactionStore const store) {
+    guardNotNull(store, "store", "TransactionStore_destroy");
+
+    for (size_t i = 0; i < store->recordCount; i += 1) {
+        Int64List_destroy(store->records[i].amountsCents);
+        SizeList_destroy(store->records[i].sectionOffsets);
+    }
+    free(store->records);
+    free(store);
+}
+
+/**
+ * Get the number of transaction records in the TransactionStore.
+ *
+ * @param store The TransactionStore instance.
+ *
+ * @returns The number of transaction records.
+ */
+size_t TransactionStore_recordCount(TransactionStore const store) {
+    guardNotNull(store, "store", "TransactionStore_recordCount");
+    return store->recordCount;
+}
+
+/**
+ * Get the number of sections in a transaction record.
+ *
+ * @param store The TransactionStore instance.
+ * @param recordIndex The index of the transaction record.
+ *
+ * @returns The number of sections.
+ */
+size_t TransactionStore_sectionCount(TransactionStore const store, size_t const recordIndex) {
+    guardNotNull(store, "store", "TransactionStore_sectionCount");
+    TransactionStore_guardRecordIndex(store, recordIndex, "TransactionStore_sectionCount");
+    return SizeList_count(store->records[recordIndex].sectionOffsets) - 1;
+}
+
+/**
+ * Get every amount of a transaction record, in cents and in file order.
+ *
+ * @param store The TransactionStore instance.
+ * @param recordIndex The index of the transaction record.
+ *
+ * @returns The amounts. They live as long as the store.
+ */
+int64_t const *TransactionStore_amountsCents(TransactionStore const store, size_t const recordIndex) {
+    guardNotNull(store, "store", "TransactionStore_amountsCents");
+    TransactionStore_guardRecordIndex(store, recordIndex, "TransactionStore_amountsCents");
+    return Int64List_items(store->records[recordIndex].amountsCents);
+}
+
+/**
+ * Get the index of the first amount of each section of a transaction record, followed by the total number of amounts.
+ *
+ * @param store The TransactionStore instance.
+ * @param recordIndex The index of the transaction record.
+ *
+ * @returns The section count + 1 offsets. They live as long as the store.
+ */
+size_t const *TransactionStore_sectionOffsets(TransactionStore const store, size_t const recordIndex) {
+    guardNotNull(store, "store", "TransactionStore_sectionOffsets");
+    TransactionStore_guardRecordIndex(store, recordIndex, "TransactionStore_sectionOffsets");
+    return SizeList_items(store->records[recordIndex].sectionOffsets);
+}
+
+/**
+ * Open a reader over the sections of a transaction record in the TransactionStore.
+ *
+ * @param store The TransactionStore instance. It must outlive the reader.
+ * @param recordIndex The index of the transaction record.
+ * @param name The name of the transaction record, used in error messages.
+ * @param filePath The path the transaction record was read from, used in error messages.
+ *
+ * @returns The newly allocated TransactionReader. The caller is responsible for closing it.
+ */
+TransactionReader TransactionStore_openReader(
+    TransactionStore const store,
+    size_t const recordIndex,
+    char const * const name,
+    char const * const filePath
+) {
+    guardNotNull(store, "store", "TransactionStore_openReader");
+    TransactionStore_guardRecordIndex(store, recordIndex, "TransactionStore_openReader");
+
+    return TransactionReader_openColumns(
+        name,
+        filePath,
+        TransactionStore_amountsCents(store, recordIndex),
+        TransactionStore_sectionOffsets(store, recordIndex),
+        TransactionStore_sectionCount(store, recordIndex)
+    );
+}
+
+static TransactionStore TransactionStore_buildWith(
+    struct TransactionStoreBuildArg * const argPtr,
+    size_t const recordCount,
+    size_t const threadCount,
+    ThreadPoolTask const buildRecord
+) {
+    TransactionStore const store = safeMalloc(sizeof *store, "TransactionStore_build");
+    store->records = safeMalloc(sizeof *store->records * recordCount, "TransactionStore_build");
+    store->recordCount = recordCount;
+
+    argPtr->records = store->records;
+    ThreadPool const threadPool = ThreadPool_create(threadCount);
+    ThreadPool_run(threadPool, recordCount, buildRecord, argPtr);
+    ThreadPool_destroy(threadPool);
+
+    return store;
+}
+
+static void TransactionStore_buildRecord(void * const argAsVoidPtr, size_t const recordIndex) {
+    struct TransactionStoreBuildArg const * const argPtr = argAsVoidPtr;
+    TransactionReader const reader = argPtr->readers[recordIndex];
+    struct TransactionStoreRecord * const recordPtr = &argPtr->records[recordIndex];
+
+    recordPtr->amountsCents = Int64List_create();
+    recordPtr->sectionOffsets = SizeList_create();
+    SizeList_add(recordPtr->sectionOffsets, 0);
+
+    int64_t sectionDeltaCents;
+    while (TransactionReader_readSectionAmounts(reader, recordPtr->amountsCents, &sectionDeltaCents)) {
+        SizeList_add(recordPtr->sectionOffsets, Int64List_count(recordPtr->amountsCents));
+    }
+}
+
+static void TransactionStore_buildCachedRecord(void * const argAsVoidPtr, size_t const recordIndex) {
+    struct TransactionStoreBuildArg const * const argPtr = argAsVoidPtr;
+    struct TransactionStoreRecord * const recordPtr = &argPtr->records[recordIndex];
+
+    // Each section is stored as a single amount: its delta
+    recordPtr->amountsCents = Int64List_create();
+    argPtr->cacheResults[recordIndex] = readSectionDeltasCached(
+        argPtr->readers[recordIndex],
+        argPtr->filePaths[recordIndex],
+        recordPtr->amountsCents
+    );
+
+    size_t const sectionCount = Int64List_count(recordPtr->amountsCents);
+    recordPtr->sectionOffsets = SizeList_create();
+    for (size_t i = 0; i <= sectionCount; i += 1) {
+        SizeList_add(recordPtr->sectionOffsets, i);
+    }
+}
+
+static void TransactionStore_guardRecordIndex(
+    TransactionStore const store,
+    size_t const recordIndex,
+    char const * const callerDescription
+) {
+    if (recordIndex >= store->recordCount) {
+        abortWithErrorFmt(
+            "%s: Record index out of range (%zu >= %zu)",
+            callerDescription,
+            recordIndex,
+            store->recordCount
+        );
+    }
+}
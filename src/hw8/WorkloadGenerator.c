@@ -0,0 +1,344 @@
+#include "../../include/hw8/WorkloadGenerator.h"
+
+#include "../../include/hw8/BinaryTransactionFile.h"
+#include "../../include/hw8/WorkloadProfile.h"
+#include "../../include/util/ThreadPool.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/string.h"
+#include "../../include/util/random.h"
+#include "../../include/util/cents.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Each file is written through its own buffer, flushed in writes of this size
+#define WORKLOAD_WRITE_BUFFER_SIZE ((size_t)4 << 20)
+
+/**
+ * A file being written by one generator thread through a large buffer.
+ */
+struct WorkloadFile {
+    char *path;
+    int fd;
+    char *buffer;
+    size_t bufferedLength;
+};
+
+static size_t workloadFormatCount(struct WorkloadOptions const *optionsPtr);
+static void generateWorkloadFile(void *optionsAsVoidPtr, size_t fileIndex);
+static int64_t nextWorkloadAmountCents(struct WorkloadOptions const *optionsPtr, struct RandomStream *randomStreamPtr);
+static void openWorkloadFile(struct WorkloadFile *filePtr, char *path);
+static void writeWorkloadFile(struct WorkloadFile *filePtr, void const *data, size_t length);
+static void flushWorkloadFile(struct WorkloadFile *filePtr);
+static void closeWorkloadFile(struct WorkloadFile *filePtr);
+
+/**
+ * Get the default workload options. These generate five records shaped like the assignment's input files: a handful of
+ * sections of a few transactions each, with amounts uniformly distributed within $500 of zero, in the text format.
+ *
+ * @returns The default options.
+ */
+struct WorkloadOptions defaultWorkloadOptions(void) {
+    return (struct WorkloadOptions){
+        .seed = 0,
+        .recordCount = 5,
+        .sectionsPerRecord = 8,
+        .transactionsPerSection = 4,
+        .amountDistribution = AmountDistribution_uniform,
+        .maxAmountCents = 50000,
+        .volumeProfile = WorkloadProfile_uniform,
+        .profilePeriodLength = 0,
+        .accountCount = 0,
+        .directoryPath = ".",
+        .writeText = true,
+        .writeBinary = false,
+        .threadCount = 0
+    };
+}
+
+/**
+ * Parse the name of an amount distribution: "uniform", "normal" or "exponential".
+ *
+ * @param name The name.
+ * @param distributionOutPtr The location to store the distribution.
+ *
+ * @returns Whether the name was recognized.
+ */
+bool parseAmountDistribution(char const * const name, enum AmountDistribution * const distributionOutPtr) {
+    guardNotNull(name, "name", "parseAmountDistribution");
+    guardNotNull(distributionOutPtr, "distributionOutPtr", "parseAmountDistribution");
+
+    if (strcmp(name, "uniform") == 0) {
+        *distributionOutPtr = AmountDistribution_uniform;
+    } else if (strcmp(name, "normal") == 0) {
+        *distributionOutPtr = AmountDistribution_normal;
+    } else if (strcmp(name, "exponential") == 0) {
+        *distributionOutPtr = AmountDistribution_exponential;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Generate transaction record files, replacing generateTransactionRecordText.js for inputs too large to build as one
+ * string. Record i (from 1) is written to DIRECTORY/recordi.in in the text format and/or DIRECTORY/recordi.bin in the
+ * binary format (see BinaryTransactionFile.h). Each file is generated by one thread of a pool and written through its
+ * own large buffer. Each record's amounts are drawn from a random stream derived from the seed and the record's index,
+ * so the same options always generate the same files, and a record's text and binary files hold the same amounts. If a
+ * file cannot be written, abort the program with an error message.
+ *
+ * @param optionsPtr The options. Amounts are nonzero whole cents within maxAmountCents of zero. A uniform distribution
+ *                   draws them evenly from that range; a normal distribution centers them on zero with a standard
+ *                   deviation of a third of it; an exponential distribution gives them a random sign and a magnitude
+ *                   with a mean of a tenth of it. Each section has transactionsPerSection transactions scaled by
+ *                   the weight of its record in volumeProfile at that section (see nextWorkloadProfileWeight), but
+ *                   never scaled down to none, where a profile period is profilePeriodLength sections (a quarter of
+ *                   sectionsPerRecord if 0). If accountCount is not 0, each section's transaction lines carry the ID
+ *                   of an account drawn evenly from 1 to accountCount for that section (see lexAccountTransactionLine);
+ *                   only text files can be written then. Files are generated on threadCount threads (one per online
+ *                   processor if 0).
+ */
+void generateWorkload(struct WorkloadOptions const * const optionsPtr) {
+    guardNotNull(optionsPtr, "optionsPtr", "generateWorkload");
+    guardNotNull(optionsPtr->directoryPath, "optionsPtr->directoryPath", "generateWorkload");
+    guard(optionsPtr->maxAmountCents > 0, "generateWorkload: maxAmountCents must be greater than 0");
+    guard(optionsPtr->writeText || optionsPtr->writeBinary, "generateWorkload: No format to write");
+    guard(
+        optionsPtr->accountCount == 0 || !optionsPtr->writeBinary,
+        "generateWorkload: Account IDs can only be written to text files"
+    );
+
+    size_t const formatCount = workloadFormatCount(optionsPtr);
+    ThreadPool const threadPool = ThreadPool_create(optionsPtr->threadCount);
+    // ThreadPool tasks take a mutable argument, but the options are only read
+    struct WorkloadOptions options = *optionsPtr;
+    ThreadPool_run(threadPool, optionsPtr->recordCount * formatCount, generateWorkloadFile, &options);
+    ThreadPool_destroy(threadPool);
+}
+
+static size_t workloadFormatCount(struct WorkloadOptions const * const optionsPtr) {
+    return (size_t)(optionsPtr->writeText ? 1 : 0) + (size_t)(optionsPtr->writeBinary ? 1 : 0);
+}
+
+static void generateWorkloadFile(void * const optionsAsVoidPtr, size_t const fileIndex) {
+    struct WorkloadOptions const * const optionsPtr = optionsAsVoidPtr;
+
+    // With both formats, each record's text file comes first
+    size_t const formatCount = workloadFormatCount(optionsPtr);
+    size_t const recordIndex = fileIndex / formatCount;
+    bool const binary = !optionsPtr->writeText || (formatCount == 2 && fileIndex % 2 == 1);
+
+    struct RandomStream randomStream;
+    initializeRandomStream(&randomStream, optionsPtr->seed, recordIndex + 1);
+
+    size_t periodLength = optionsPtr->profilePeriodLength;
+    if (periodLength == 0) {
+        periodLength = optionsPtr->sectionsPerRecord >= 4 ? optionsPtr->sectionsPerRecord / 4 : 1;
+    }
+    struct WorkloadProfileCursor volumeCursor;
+    initializeWorkloadProfileCursor(
+        &volumeCursor,
+        optionsPtr->volumeProfile,
+        recordIndex,
+        optionsPtr->recordCount,
+        periodLength,
+        optionsPtr->seed
+    );
+
+    struct WorkloadFile file;
+    openWorkloadFile(
+        &file,
+        formatString("%s/record%zu.%s", optionsPtr->directoryPath, recordIndex + 1, binary ? "bin" : "in")
+    );
+
+    if (binary) {
+        struct BinaryTransactionFileHeader header = {
+            .version = BINARY_TRANSACTION_FILE_VERSION,
+            .encoding = BinaryTransactionEncoding_int64,
+            .sectionCount = (uint64_t)optionsPtr->sectionsPerRecord
+        };
+        memcpy(header.magic, BINARY_TRANSACTION_FILE_MAGIC, BINARY_TRANSACTION_FILE_MAGIC_LENGTH);
+        writeWorkloadFile(&file, &header, sizeof header);
+    }
+
+    for (size_t i = 0; i < optionsPtr->sectionsPerRecord; i += 1) {
+        double const volumeWeight = nextWorkloadProfileWeight(&volumeCursor);
+        long long const weightedTransactionCount = llround((double)optionsPtr->transactionsPerSection * volumeWeight);
+        size_t const transactionCount = (
+            weightedTransactionCount < 1 && optionsPtr->transactionsPerSection > 0 ? 1 : (size_t)weightedTransactionCount
+        );
+
+        if (binary) {
+            uint64_t const amountCount = (uint64_t)transactionCount;
+            writeWorkloadFile(&file, &amountCount, sizeof amountCount);
+        } else {
+            writeWorkloadFile(&file, "R\n", 2);
+        }
+
+        // An account ID and its colon, the same for every line of the section
+        char accountPrefix[24];
+        size_t accountPrefixLength = 0;
+        if (optionsPtr->accountCount > 0) {
+            uint64_t const accountId = 1 + randomStreamNext(&randomStream) % (uint64_t)optionsPtr->accountCount;
+            accountPrefixLength = (size_t)snprintf(
+                accountPrefix,
+                sizeof accountPrefix,
+                "%llu:",
+                (unsigned long long)accountId
+            );
+        }
+
+        for (size_t j = 0; j < transactionCount; j += 1) {
+            int64_t const amountCents = nextWorkloadAmountCents(optionsPtr, &randomStream);
+            if (binary) {
+                writeWorkloadFile(&file, &amountCents, sizeof amountCents);
+            } else {
+                // The account prefix, a sign, the amount and a newline
+                char line[sizeof accountPrefix + CENTS_STRING_CAPACITY + 2];
+                memcpy(line, accountPrefix, accountPrefixLength);
+                size_t lineLength = accountPrefixLength;
+                if (amountCents > 0) {
+                    line[lineLength] = '+';
+                    lineLength += 1;
+                }
+                lineLength += formatCents(amountCents, line + lineLength);
+                line[lineLength] = '\n';
+                lineLength += 1;
+                writeWorkloadFile(&file, line, lineLength);
+            }
+        }
+
+        if (!binary) {
+            writeWorkloadFile(&file, "W\n", 2);
+        }
+    }
+
+    closeWorkloadFile(&file);
+}
+
+static int64_t nextWorkloadAmountCents(
+    struct WorkloadOptions const * const optionsPtr,
+    struct RandomStream * const randomStreamPtr
+) {
+    double const maxAmountCents = (double)optionsPtr->maxAmountCents;
+    double amountCents;
+    switch (optionsPtr->amountDistribution) {
+        case AmountDistribution_uniform: {
+            amountCents = (2 * randomStreamDouble(randomStreamPtr) - 1) * maxAmountCents;
+            break;
+        }
+        case AmountDistribution_normal: {
+            // Marsaglia's polar method
+            double x;
+            double y;
+            double radiusSquared;
+            do {
+                x = 2 * randomStreamDouble(randomStreamPtr) - 1;
+                y = 2 * randomStreamDouble(randomStreamPtr) - 1;
+                radiusSquared = x * x + y * y;
+            } while (radiusSquared >= 1 || radiusSquared <= 0);
+            amountCents = x * sqrt(-2 * log(radiusSquared) / radiusSquared) * maxAmountCents / 3;
+            break;
+        }
+        case AmountDistribution_exponential: {
+            double const magnitudeCents = -log(1 - randomStreamDouble(randomStreamPtr)) * maxAmountCents / 10;
+            amountCents = (randomStreamNext(randomStreamPtr) & 1) == 0 ? magnitudeCents : -magnitudeCents;
+            break;
+        }
+        default: {
+            abortWithErrorFmt(
+                "nextWorkloadAmountCents: Invalid amount distribution (%d)",
+                (int)optionsPtr->amountDistribution
+            );
+            return 0;
+        }
+    }
+
+    // Clamp into range, and round zero away so every transaction changes the balance
+    if (amountCents > maxAmountCents) {
+        amountCents = maxAmountCents;
+    } else if (amountCents < -maxAmountCents) {
+        amountCents = -maxAmountCents;
+    }
+    int64_t const roundedAmountCents = (int64_t)llround(amountCents);
+    if (roundedAmountCents == 0) {
+        return amountCents < 0 ? -1 : 1;
+    }
+    return roundedAmountCents;
+}
+
+static void openWorkloadFile(struct WorkloadFile * const filePtr, char * const path) {
+    int const fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        int const openErrorCode = errno;
+        abortWithErrorFmt(
+            "generateWorkload: Failed to open \"%s\" using open (error code: %d; error message: \"%s\")",
+            path,
+            openErrorCode,
+            strerror(openErrorCode)
+        );
+    }
+
+    filePtr->path = path;
+    filePtr->fd = fd;
+    filePtr->buffer = safeMalloc(WORKLOAD_WRITE_BUFFER_SIZE, "generateWorkload");
+    filePtr->bufferedLength = 0;
+}
+
+static void writeWorkloadFile(struct WorkloadFile * const filePtr, void const * const data, size_t const length) {
+    if (WORKLOAD_WRITE_BUFFER_SIZE - filePtr->bufferedLength < length) {
+        flushWorkloadFile(filePtr);
+    }
+    memcpy(filePtr->buffer + filePtr->bufferedLength, data, length);
+    filePtr->bufferedLength += length;
+}
+
+static void flushWorkloadFile(struct WorkloadFile * const filePtr) {
+    size_t writtenLength = 0;
+    while (writtenLength < filePtr->bufferedLength) {
+        ssize_t const result = write(
+            filePtr->fd,
+            filePtr->buffer + writtenLength,
+            filePtr->bufferedLength - writtenLength
+        );
+        if (result == -1) {
+            int const writeErrorCode = errno;
+            if (writeErrorCode == EINTR) {
+                continue;
+            }
+            abortWithErrorFmt(
+                "generateWorkload: Failed to write \"%s\" using write (error code: %d; error message: \"%s\")",
+                filePtr->path,
+                writeErrorCode,
+                strerror(writeErrorCode)
+            );
+        }
+        writtenLength += (size_t)result;
+    }
+    filePtr->bufferedLength = 0;
+}
+
+static void closeWorkloadFile(struct WorkloadFile * const filePtr) {
+    flushWorkloadFile(filePtr);
+    if (close(filePtr->fd) == -1) {
+        int const closeErrorCode = errno;
+        abortWithErrorFmt(
+            "generateWorkload: Failed to close \"%s\" using close (error code: %d; error message: \"%s\")",
+            filePtr->path,
+            closeErrorCode,
+            strerror(closeErrorCode)
+        );
+    }
+    free(filePtr->buffer);
+    free(filePtr->path);
+}
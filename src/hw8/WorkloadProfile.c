@@ -0,0 +1,161 @@
+#include "../../include/hw8/WorkloadProfile.h"
+
+#include "../../include/util/random.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+#include "../../include/util/macro.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// While bursting, an entity is this many times as busy as on average; while idle, this many times less
+#define WORKLOAD_BURST_WEIGHT ((double)1.75F)
+#define WORKLOAD_IDLE_WEIGHT ((double)0.25F)
+// The busiest time of day is this much busier than average, and the quietest this much quieter
+#define WORKLOAD_DIURNAL_AMPLITUDE ((double)0.75F)
+
+static char const * const workloadProfileNames[] = {
+    [WorkloadProfile_uniform] = "uniform",
+    [WorkloadProfile_zipfian] = "zipfian",
+    [WorkloadProfile_bursty] = "bursty",
+    [WorkloadProfile_diurnal] = "diurnal",
+    [WorkloadProfile_phaseChange] = "phase-change"
+};
+
+static double zipfianWeight(size_t rank, size_t entityCount, double harmonicNumber);
+
+/**
+ * Parse the name of a workload profile: "uniform", "zipfian", "bursty", "diurnal" or "phase-change".
+ *
+ * @param name The name.
+ * @param profileOutPtr The location to store the profile.
+ *
+ * @returns Whether the name was recognized.
+ */
+bool parseWorkloadProfile(char const * const name, enum WorkloadProfile * const profileOutPtr) {
+    guardNotNull(name, "name", "parseWorkloadProfile");
+    guardNotNull(profileOutPtr, "profileOutPtr", "parseWorkloadProfile");
+
+    for (size_t i = 0; i < ARRAY_LENGTH(workloadProfileNames); i += 1) {
+        if (strcmp(name, workloadProfileNames[i]) == 0) {
+            *profileOutPtr = (enum WorkloadProfile)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the name of a workload profile, as accepted by parseWorkloadProfile.
+ *
+ * @param profile The profile.
+ *
+ * @returns The name.
+ */
+char const *workloadProfileName(enum WorkloadProfile const profile) {
+    if ((size_t)profile >= ARRAY_LENGTH(workloadProfileNames)) {
+        abortWithErrorFmt("workloadProfileName: Invalid profile (%d)", (int)profile);
+    }
+    return workloadProfileNames[profile];
+}
+
+/**
+ * Initialize a cursor for one of a group of entities following a workload profile.
+ *
+ * @param cursorPtr The cursor to initialize.
+ * @param profile The profile.
+ * @param entityIndex The index of the entity within its group.
+ * @param entityCount The number of entities in the group.
+ * @param periodLength The number of steps in one day of the diurnal profile, one phase of the phase-change profile, or
+ *                     an average burst or idle spell of the bursty profile.
+ * @param seed The seed of the random stream the bursty profile draws from, shared by the group. The cursor draws from
+ *             stream entityCount + 1 + entityIndex, leaving streams 1..entityCount to the entities themselves.
+ */
+void initializeWorkloadProfileCursor(
+    struct WorkloadProfileCursor * const cursorPtr,
+    enum WorkloadProfile const profile,
+    size_t const entityIndex,
+    size_t const entityCount,
+    size_t const periodLength,
+    uint64_t const seed
+) {
+    guardNotNull(cursorPtr, "cursorPtr", "initializeWorkloadProfileCursor");
+    guard(entityIndex < entityCount, "initializeWorkloadProfileCursor: entityIndex must be less than entityCount");
+    guard(periodLength > 0, "initializeWorkloadProfileCursor: periodLength must be greater than 0");
+
+    cursorPtr->profile = profile;
+    cursorPtr->entityIndex = entityIndex;
+    cursorPtr->entityCount = entityCount;
+    cursorPtr->periodLength = periodLength;
+    cursorPtr->step = 0;
+
+    // The zipfian weights are normalized by the harmonic number of the group, so that they add up to entityCount
+    double harmonicNumber = 0;
+    if (profile == WorkloadProfile_zipfian || profile == WorkloadProfile_phaseChange) {
+        for (size_t i = 1; i <= entityCount; i += 1) {
+            harmonicNumber += 1 / (double)i;
+        }
+    }
+    cursorPtr->harmonicNumber = harmonicNumber;
+
+    initializeRandomStream(&cursorPtr->randomStream, seed, (uint64_t)entityCount + 1 + entityIndex);
+    cursorPtr->bursting = profile == WorkloadProfile_bursty && (randomStreamNext(&cursorPtr->randomStream) & 1) == 1;
+}
+
+/**
+ * Get how busy the entity is at its current step, relative to the average, then advance to the next step. Averaged
+ * over the entities and over time, the weight is about 1:
+ *
+ * - uniform: always 1.
+ * - zipfian: entity i is the (i + 1)th most popular, with a weight proportional to 1 / (i + 1).
+ * - bursty: the entity alternates between bursts and idle spells, each periodLength steps long on average.
+ * - diurnal: every entity follows the same sine wave, periodLength steps long.
+ * - phase-change: zipfian, but the popularity ranking shifts by one entity every periodLength steps, so the hot entity
+ *   changes.
+ *
+ * @param cursorPtr The cursor.
+ *
+ * @returns The weight.
+ */
+double nextWorkloadProfileWeight(struct WorkloadProfileCursor * const cursorPtr) {
+    guardNotNull(cursorPtr, "cursorPtr", "nextWorkloadProfileWeight");
+
+    size_t const step = cursorPtr->step;
+    cursorPtr->step += 1;
+    switch (cursorPtr->profile) {
+        case WorkloadProfile_uniform: {
+            return 1;
+        }
+        case WorkloadProfile_zipfian: {
+            return zipfianWeight(cursorPtr->entityIndex + 1, cursorPtr->entityCount, cursorPtr->harmonicNumber);
+        }
+        case WorkloadProfile_bursty: {
+            double const weight = cursorPtr->bursting ? WORKLOAD_BURST_WEIGHT : WORKLOAD_IDLE_WEIGHT;
+            if (randomStreamNext(&cursorPtr->randomStream) % cursorPtr->periodLength == 0) {
+                cursorPtr->bursting = !cursorPtr->bursting;
+            }
+            return weight;
+        }
+        case WorkloadProfile_diurnal: {
+            double const pi = acos(-1);
+            double const timeOfDay = (double)(step % cursorPtr->periodLength) / (double)cursorPtr->periodLength;
+            return 1 + WORKLOAD_DIURNAL_AMPLITUDE * sin(2 * pi * timeOfDay);
+        }
+        case WorkloadProfile_phaseChange: {
+            size_t const phase = step / cursorPtr->periodLength;
+            size_t const rank = (cursorPtr->entityIndex + phase) % cursorPtr->entityCount + 1;
+            return zipfianWeight(rank, cursorPtr->entityCount, cursorPtr->harmonicNumber);
+        }
+        default: {
+            abortWithErrorFmt("nextWorkloadProfileWeight: Invalid profile (%d)", (int)cursorPtr->profile);
+            return 0;
+        }
+    }
+}
+
+static double zipfianWeight(size_t const rank, size_t const entityCount, double const harmonicNumber) {
+    return (double)entityCount / ((double)rank * harmonicNumber);
+}
@@ -0,0 +1,461 @@
+#include "../../include/hw8/benchmarks.h"
+
+#include "../../include/hw8/TransactionLexer.h"
+#include "../../include/hw8/BinaryTransactionFile.h"
+#include "../../include/util/StringBuilder.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/file.h"
+#include "../../include/util/random.h"
+#include "../../include/util/regex.h"
+#include "../../include/util/time.h"
+#include "../../include/util/cents.h"
+#include "../../include/util/sum.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <regex.h>
+
+#define BENCHMARK_SEED 451
+#define BENCHMARK_TRANSACTIONS_PER_SECTION 8
+// Each sum kernel reads about this many bytes in total, however large the section
+#define BENCHMARK_SUM_BYTES (UINT64_C(1) << 32)
+
+/**
+ * The result of lexing every line of a benchmark corpus: the number of lines of each kind and the sum of the amounts,
+ * which must agree between the lexers being compared.
+ */
+struct LexResult {
+    size_t beginSectionCount;
+    size_t endSectionCount;
+    size_t transactionCount;
+    size_t invalidCount;
+    int64_t amountCentsSum;
+};
+
+static char *generateTransactionText(size_t lineCount, size_t *lengthOutPtr);
+static struct LexResult lexWithLexer(char const *text, size_t length);
+static struct LexResult lexWithRegex(char const *text, size_t length);
+static int64_t floatToCents(float amount);
+static uint64_t timeSumKernel(
+    int64_t (*sumKernel)(int64_t const *values, size_t count),
+    int64_t const *amountsCents,
+    size_t amountCount,
+    size_t passCount,
+    int64_t *sumOutPtr
+);
+static void printBenchmarkResult(char const *name, size_t count, char const *unit, uint64_t elapsedNs);
+static void printBenchmarkBandwidth(char const *name, uint64_t byteCount, uint64_t elapsedNs);
+static unsigned char *encodeTransactionText(char const *text, size_t length, size_t *encodedLengthOutPtr);
+static int64_t decodeVarintSections(unsigned char const *encoded, size_t encodedLength, size_t *amountCountOutPtr);
+
+/**
+ * Measure how many lines per second the transaction lexer classifies and parses, compared to the POSIX regex path it
+ * replaced (three regexec calls per line, then strtof). Both run over the same generated, in-memory transaction text,
+ * and their results are checked against each other.
+ *
+ * @param lineCount The approximate number of lines to generate.
+ */
+void benchmarkTransactionLexer(size_t const lineCount) {
+    guard(lineCount > 0, "benchmarkTransactionLexer: lineCount must be greater than 0");
+
+    size_t textLength;
+    char * const text = generateTransactionText(lineCount, &textLength);
+
+    uint64_t const lexerStartTimeNs = safeMonotonicTimeNs("benchmarkTransactionLexer");
+    struct LexResult const lexerResult = lexWithLexer(text, textLength);
+    uint64_t const lexerElapsedNs = safeMonotonicTimeNs("benchmarkTransactionLexer") - lexerStartTimeNs;
+
+    uint64_t const regexStartTimeNs = safeMonotonicTimeNs("benchmarkTransactionLexer");
+    struct LexResult const regexResult = lexWithRegex(text, textLength);
+    uint64_t const regexElapsedNs = safeMonotonicTimeNs("benchmarkTransactionLexer") - regexStartTimeNs;
+
+    size_t const actualLineCount = (
+        lexerResult.beginSectionCount
+        + lexerResult.endSectionCount
+        + lexerResult.transactionCount
+        + lexerResult.invalidCount
+    );
+    printBenchmarkResult("lexer", actualLineCount, "lines", lexerElapsedNs);
+    printBenchmarkResult("regex", actualLineCount, "lines", regexElapsedNs);
+    printf("speedup: %.2fx\n", lexerElapsedNs == 0 ? 0 : (double)regexElapsedNs / (double)lexerElapsedNs);
+
+    bool const resultsAgree = (
+        lexerResult.beginSectionCount == regexResult.beginSectionCount
+        && lexerResult.endSectionCount == regexResult.endSectionCount
+        && lexerResult.transactionCount == regexResult.transactionCount
+        && lexerResult.invalidCount == regexResult.invalidCount
+        && lexerResult.amountCentsSum == regexResult.amountCentsSum
+    );
+    if (!resultsAgree) {
+        char lexerSumString[CENTS_STRING_CAPACITY];
+        char regexSumString[CENTS_STRING_CAPACITY];
+        formatCents(lexerResult.amountCentsSum, lexerSumString);
+        formatCents(regexResult.amountCentsSum, regexSumString);
+        fprintf(
+            stderr,
+            "benchmarkTransactionLexer: The lexer and regex results differ (sums: %s and %s)\n",
+            lexerSumString,
+            regexSumString
+        );
+    }
+
+    free(text);
+}
+
+static char *generateTransactionText(size_t const lineCount, size_t * const lengthOutPtr) {
+    struct RandomStream randomStream;
+    initializeRandomStream(&randomStream, BENCHMARK_SEED, 0);
+
+    StringBuilder const textBuilder = StringBuilder_create();
+    size_t generatedLineCount = 0;
+    while (generatedLineCount < lineCount) {
+        StringBuilder_appendLine(textBuilder, "R");
+        for (size_t i = 0; i < BENCHMARK_TRANSACTIONS_PER_SECTION; i += 1) {
+            StringBuilder_appendLineFmt(
+                textBuilder,
+                "%c%d.%02d",
+                randomStreamInt(&randomStream, 0, 2) == 0 ? '+' : '-',
+                randomStreamInt(&randomStream, 0, 10000),
+                randomStreamInt(&randomStream, 0, 100)
+            );
+        }
+        StringBuilder_appendLine(textBuilder, "W");
+        generatedLineCount += BENCHMARK_TRANSACTIONS_PER_SECTION + 2;
+    }
+
+    *lengthOutPtr = StringBuilder_length(textBuilder);
+    return StringBuilder_toStringAndDestroy(textBuilder);
+}
+
+static struct LexResult lexWithLexer(char const * const text, size_t const length) {
+    struct LexResult result = {0};
+    struct MappedFile textFile = {.mapping = NULL, .chars = text, .length = length, .position = 0};
+
+    struct FileLine line;
+    while (readMappedFileLine(&textFile, &line)) {
+        int64_t amountCents;
+        switch (lexTransactionLine(line.chars, line.length, &amountCents)) {
+            case TransactionToken_beginSection: result.beginSectionCount += 1; break;
+            case TransactionToken_endSection: result.endSectionCount += 1; break;
+            case TransactionToken_transaction: {
+                result.transactionCount += 1;
+                result.amountCentsSum = ADD_CENTS(result.amountCentsSum, amountCents);
+                break;
+            }
+            case TransactionToken_invalid:
+            default: result.invalidCount += 1; break;
+        }
+    }
+
+    return result;
+}
+
+static struct LexResult lexWithRegex(char const * const text, size_t const length) {
+    regex_t beginTransactionSectionRegex;
+    regex_t transactionRegex;
+    regex_t endTransactionSectionRegex;
+    safeRegcomp(&beginTransactionSectionRegex, "^R$", REG_EXTENDED | REG_NOSUB, "lexWithRegex");
+    safeRegcomp(&transactionRegex, "^[+-][0-9]+\\.?[0-9]*|[0-9]*\\.[0-9]+$", REG_EXTENDED | REG_NOSUB, "lexWithRegex");
+    safeRegcomp(&endTransactionSectionRegex, "^W$", REG_EXTENDED | REG_NOSUB, "lexWithRegex");
+
+    struct LexResult result = {0};
+    struct MappedFile textFile = {.mapping = NULL, .chars = text, .length = length, .position = 0};
+    char *lineBuffer = NULL;
+    size_t lineBufferCapacity = 0;
+
+    struct FileLine line;
+    while (readMappedFileLine(&textFile, &line)) {
+        if (line.length + 1 > lineBufferCapacity) {
+            lineBufferCapacity = line.length + 1;
+            lineBuffer = safeRealloc(lineBuffer, lineBufferCapacity, "lexWithRegex");
+        }
+        memcpy(lineBuffer, line.chars, line.length);
+        lineBuffer[line.length] = '\0';
+
+        if (regexec(&beginTransactionSectionRegex, lineBuffer, 0, NULL, 0) == 0) {
+            result.beginSectionCount += 1;
+        } else if (regexec(&endTransactionSectionRegex, lineBuffer, 0, NULL, 0) == 0) {
+            result.endSectionCount += 1;
+        } else if (regexec(&transactionRegex, lineBuffer, 0, NULL, 0) == 0) {
+            result.transactionCount += 1;
+            result.amountCentsSum = ADD_CENTS(result.amountCentsSum, floatToCents(strtof(lineBuffer, NULL)));
+        } else {
+            result.invalidCount += 1;
+        }
+    }
+
+    free(lineBuffer);
+    regfree(&endTransactionSectionRegex);
+    regfree(&transactionRegex);
+    regfree(&beginTransactionSectionRegex);
+    return result;
+}
+
+/**
+ * Measure how many amounts per second parseCents parses, compared to strtof on the same amounts. The amounts are
+ * checked to agree to the cent.
+ *
+ * @param amountCount The number of amounts to generate.
+ */
+void benchmarkCentsParser(size_t const amountCount) {
+    guard(amountCount > 0, "benchmarkCentsParser: amountCount must be greater than 0");
+
+    size_t textLength;
+    char * const text = generateTransactionText(amountCount, &textLength);
+
+    // Find the amount lines up front, so that only parsing is timed
+    struct FileLine * const amountLines = safeMalloc(sizeof *amountLines * amountCount, "benchmarkCentsParser");
+    size_t amountLineCount = 0;
+    struct MappedFile textFile = {.mapping = NULL, .chars = text, .length = textLength, .position = 0};
+    struct FileLine line;
+    while (amountLineCount < amountCount && readMappedFileLine(&textFile, &line)) {
+        if (line.length > 1) {
+            amountLines[amountLineCount] = line;
+            amountLineCount += 1;
+        }
+    }
+
+    uint64_t const centsStartTimeNs = safeMonotonicTimeNs("benchmarkCentsParser");
+    int64_t centsSum = 0;
+    for (size_t i = 0; i < amountLineCount; i += 1) {
+        int64_t amountCents = 0;
+        parseCents(amountLines[i].chars, amountLines[i].length, &amountCents);
+        centsSum += amountCents;
+    }
+    uint64_t const centsElapsedNs = safeMonotonicTimeNs("benchmarkCentsParser") - centsStartTimeNs;
+
+    // Every amount line ends in a newline, which stops strtof
+    uint64_t const strtofStartTimeNs = safeMonotonicTimeNs("benchmarkCentsParser");
+    int64_t strtofCentsSum = 0;
+    for (size_t i = 0; i < amountLineCount; i += 1) {
+        strtofCentsSum = ADD_CENTS(strtofCentsSum, floatToCents(strtof(amountLines[i].chars, NULL)));
+    }
+    uint64_t const strtofElapsedNs = safeMonotonicTimeNs("benchmarkCentsParser") - strtofStartTimeNs;
+
+    size_t const parsedCount = amountLineCount;
+    printBenchmarkResult("parseCents", parsedCount, "amounts", centsElapsedNs);
+    printBenchmarkResult("strtof", parsedCount, "amounts", strtofElapsedNs);
+    printf("speedup: %.2fx\n", centsElapsedNs == 0 ? 0 : (double)strtofElapsedNs / (double)centsElapsedNs);
+
+    if (centsSum != strtofCentsSum) {
+        char centsSumString[CENTS_STRING_CAPACITY];
+        char strtofSumString[CENTS_STRING_CAPACITY];
+        formatCents(centsSum, centsSumString);
+        formatCents(strtofCentsSum, strtofSumString);
+        fprintf(
+            stderr,
+            "benchmarkCentsParser: The parseCents and strtof sums differ (%s and %s)\n",
+            centsSumString,
+            strtofSumString
+        );
+    }
+
+    free(amountLines);
+    free(text);
+}
+
+/**
+ * Measure how fast sumInt64s sums a section of the given number of amounts in cents, compared to sumInt64sScalar. The
+ * section is summed repeatedly until a few gigabytes have been read, and the rate is reported both in amounts and in
+ * bytes per second, to compare against the memory bandwidth once the section no longer fits in cache. The sums are
+ * checked to agree.
+ *
+ * @param amountCount The number of amounts in the section.
+ */
+void benchmarkSectionSum(size_t const amountCount) {
+    guard(amountCount > 0, "benchmarkSectionSum: amountCount must be greater than 0");
+
+    struct RandomStream randomStream;
+    initializeRandomStream(&randomStream, BENCHMARK_SEED, 0);
+    int64_t * const amountsCents = safeMalloc(sizeof *amountsCents * amountCount, "benchmarkSectionSum");
+    for (size_t i = 0; i < amountCount; i += 1) {
+        amountsCents[i] = (int64_t)randomStreamInt(&randomStream, -1000000, 1000000);
+    }
+
+    uint64_t const sectionBytes = (uint64_t)(sizeof *amountsCents * amountCount);
+    size_t const passCount = sectionBytes >= BENCHMARK_SUM_BYTES ? 1 : (size_t)(BENCHMARK_SUM_BYTES / sectionBytes);
+
+    int64_t kernelSum;
+    uint64_t const kernelElapsedNs = timeSumKernel(sumInt64s, amountsCents, amountCount, passCount, &kernelSum);
+    int64_t scalarSum;
+    uint64_t const scalarElapsedNs = timeSumKernel(sumInt64sScalar, amountsCents, amountCount, passCount, &scalarSum);
+
+    char kernelName[32];
+    snprintf(kernelName, sizeof kernelName, "sumInt64s (%s)", sumInt64sKernelName());
+    printf("%zu passes over %zu amounts (%llu bytes)\n", passCount, amountCount, (unsigned long long)sectionBytes);
+    printBenchmarkResult(kernelName, amountCount * passCount, "amounts", kernelElapsedNs);
+    printBenchmarkBandwidth(kernelName, sectionBytes * passCount, kernelElapsedNs);
+    printBenchmarkResult("sumInt64sScalar", amountCount * passCount, "amounts", scalarElapsedNs);
+    printBenchmarkBandwidth("sumInt64sScalar", sectionBytes * passCount, scalarElapsedNs);
+    printf("speedup: %.2fx\n", kernelElapsedNs == 0 ? 0 : (double)scalarElapsedNs / (double)kernelElapsedNs);
+
+    if (kernelSum != scalarSum) {
+        fprintf(
+            stderr,
+            "benchmarkSectionSum: The kernel and scalar sums differ (%lld and %lld)\n",
+            (long long)kernelSum,
+            (long long)scalarSum
+        );
+    }
+
+    free(amountsCents);
+}
+
+/**
+ * Measure how fast the sections of a varint binary transaction file are decoded and summed, compared to lexing and
+ * summing the same sections from text. Both run over generated, in-memory data, so this compares decoding alone; the
+ * sizes of the two forms are also reported, since the compressed form also has that much less to read from disk. The
+ * sums are checked to agree.
+ *
+ * @param lineCount The approximate number of text lines to generate.
+ */
+void benchmarkVarintDecode(size_t const lineCount) {
+    guard(lineCount > 0, "benchmarkVarintDecode: lineCount must be greater than 0");
+
+    size_t textLength;
+    char * const text = generateTransactionText(lineCount, &textLength);
+    size_t encodedLength;
+    unsigned char * const encoded = encodeTransactionText(text, textLength, &encodedLength);
+
+    uint64_t const lexerStartTimeNs = safeMonotonicTimeNs("benchmarkVarintDecode");
+    struct LexResult const lexerResult = lexWithLexer(text, textLength);
+    uint64_t const lexerElapsedNs = safeMonotonicTimeNs("benchmarkVarintDecode") - lexerStartTimeNs;
+
+    uint64_t const decodeStartTimeNs = safeMonotonicTimeNs("benchmarkVarintDecode");
+    size_t amountCount;
+    int64_t const decodedSum = decodeVarintSections(encoded, encodedLength, &amountCount);
+    uint64_t const decodeElapsedNs = safeMonotonicTimeNs("benchmarkVarintDecode") - decodeStartTimeNs;
+
+    printf(
+        "text: %zu bytes; varint: %zu bytes (%.1f%% of text)\n",
+        textLength,
+        encodedLength,
+        textLength == 0 ? 0 : (double)encodedLength * 100 / (double)textLength
+    );
+    printBenchmarkResult("lexer", amountCount, "amounts", lexerElapsedNs);
+    printBenchmarkResult("varint", amountCount, "amounts", decodeElapsedNs);
+    printf("speedup: %.2fx\n", decodeElapsedNs == 0 ? 0 : (double)lexerElapsedNs / (double)decodeElapsedNs);
+
+    if (decodedSum != lexerResult.amountCentsSum) {
+        fprintf(
+            stderr,
+            "benchmarkVarintDecode: The lexer and varint sums differ (%lld and %lld)\n",
+            (long long)lexerResult.amountCentsSum,
+            (long long)decodedSum
+        );
+    }
+
+    free(encoded);
+    free(text);
+}
+
+static unsigned char *encodeTransactionText(
+    char const * const text,
+    size_t const length,
+    size_t * const encodedLengthOutPtr
+) {
+    int64_t sectionAmountsCents[BENCHMARK_TRANSACTIONS_PER_SECTION];
+    size_t const sectionMaxLength = varintSectionMaxLength(BENCHMARK_TRANSACTIONS_PER_SECTION);
+    size_t const lineCount = length / 2 + 1;
+    unsigned char * const encoded = safeMalloc(
+        sectionMaxLength * (lineCount / (BENCHMARK_TRANSACTIONS_PER_SECTION + 2) + 1),
+        "benchmarkVarintDecode"
+    );
+
+    // The generated text is well formed, with BENCHMARK_TRANSACTIONS_PER_SECTION amounts per section
+    size_t encodedLength = 0;
+    size_t sectionAmountCount = 0;
+    struct MappedFile textFile = {.mapping = NULL, .chars = text, .length = length, .position = 0};
+    struct FileLine line;
+    while (readMappedFileLine(&textFile, &line)) {
+        int64_t amountCents;
+        enum TransactionToken const token = lexTransactionLine(line.chars, line.length, &amountCents);
+        if (token == TransactionToken_transaction && sectionAmountCount < BENCHMARK_TRANSACTIONS_PER_SECTION) {
+            sectionAmountsCents[sectionAmountCount] = amountCents;
+            sectionAmountCount += 1;
+        } else if (token == TransactionToken_endSection) {
+            encodedLength += encodeVarintSection(sectionAmountsCents, sectionAmountCount, encoded + encodedLength);
+            sectionAmountCount = 0;
+        }
+    }
+
+    *encodedLengthOutPtr = encodedLength;
+    return encoded;
+}
+
+static int64_t decodeVarintSections(
+    unsigned char const * const encoded,
+    size_t const encodedLength,
+    size_t * const amountCountOutPtr
+) {
+    char const * const chars = (char const *)encoded;
+    int64_t sum = 0;
+    size_t amountCount = 0;
+    size_t position = 0;
+    while (position < encodedLength) {
+        struct VarintSection section;
+        int64_t sectionDeltaCents;
+        bool const decoded = (
+            readVarintSectionHeader(chars, encodedLength, position, &section)
+            && decodeVarintSection(chars, &section, NULL, &sectionDeltaCents)
+        );
+        guard(decoded, "benchmarkVarintDecode: Failed to decode a section");
+        sum += sectionDeltaCents;
+        amountCount += (size_t)section.amountCount;
+        position = section.end;
+    }
+
+    *amountCountOutPtr = amountCount;
+    return sum;
+}
+
+static uint64_t timeSumKernel(
+    int64_t (* const sumKernel)(int64_t const *values, size_t count),
+    int64_t const * const amountsCents,
+    size_t const amountCount,
+    size_t const passCount,
+    int64_t * const sumOutPtr
+) {
+    // Every pass's sum is folded into the result, so no pass can be optimized away
+    uint64_t const startTimeNs = safeMonotonicTimeNs("benchmarkSectionSum");
+    uint64_t sum = 0;
+    for (size_t i = 0; i < passCount; i += 1) {
+        sum = sum * 31 + (uint64_t)sumKernel(amountsCents, amountCount);
+    }
+    uint64_t const elapsedNs = safeMonotonicTimeNs("benchmarkSectionSum") - startTimeNs;
+
+    *sumOutPtr = (int64_t)sum;
+    return elapsedNs;
+}
+
+static int64_t floatToCents(float const amount) {
+    float const cents = amount * 100;
+    return (int64_t)(cents < 0 ? cents - 0.5F : cents + 0.5F);
+}
+
+static void printBenchmarkResult(
+    char const * const name,
+    size_t const count,
+    char const * const unit,
+    uint64_t const elapsedNs
+) {
+    double const elapsedSeconds = (double)elapsedNs / 1000 / 1000 / 1000;
+    printf(
+        "%s: %zu %s in %.3f s (%.0f %s/sec)\n",
+        name,
+        count,
+        unit,
+        elapsedSeconds,
+        elapsedNs == 0 ? 0 : (double)count / elapsedSeconds,
+        unit
+    );
+}
+
+static void printBenchmarkBandwidth(char const * const name, uint64_t const byteCount, uint64_t const elapsedNs) {
+    // Bytes per nanosecond are gigabytes per second
+    printf("%s: %.2f GB/s\n", name, elapsedNs == 0 ? 0 : (double)byteCount / (double)elapsedNs);
+}
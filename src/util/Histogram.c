@@ -0,0 +1,256 @@
+#include "../../include/util/Histogram.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HISTOGRAM_SUB_BUCKET_BITS 5
+#define HISTOGRAM_SUB_BUCKET_COUNT ((size_t)1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKET_COUNT (HISTOGRAM_SUB_BUCKET_COUNT * (64 - HISTOGRAM_SUB_BUCKET_BITS + 1))
+
+/**
+ * Represents an HDR-style histogram of non-negative integer values. Values below 32 are counted exactly. Larger values
+ * are counted in buckets which split each power of two into 32 equal sub-buckets, so any value reported by the
+ * histogram is within about 3% of a value that was recorded, over the whole 64-bit range. Recording a value is a few
+ * bit operations and an increment, with no allocation.
+ */
+struct Histogram {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    uint64_t bucketCounts[HISTOGRAM_BUCKET_COUNT];
+};
+
+static size_t Histogram_bucketIndex(uint64_t value);
+static uint64_t Histogram_bucketLowestValue(size_t bucketIndex);
+static uint64_t Histogram_bucketHighestValue(size_t bucketIndex);
+
+/**
+ * Create an empty Histogram.
+ *
+ * @returns The newly allocated Histogram. The caller is responsible for freeing this memory.
+ */
+Histogram Histogram_create(void) {
+    Histogram const histogram = safeMalloc(sizeof *histogram, "Histogram_create");
+    histogram->count = 0;
+    histogram->min = UINT64_MAX;
+    histogram->max = 0;
+    histogram->sum = 0;
+    memset(histogram->bucketCounts, 0, sizeof histogram->bucketCounts);
+    return histogram;
+}
+
+/**
+ * Free the memory associated with the Histogram.
+ *
+ * @param histogram The Histogram instance.
+ */
+void Histogram_destroy(Histogram const histogram) {
+    guardNotNull(histogram, "histogram", "Histogram_destroy");
+    free(histogram);
+}
+
+/**
+ * Record a value in the histogram. Histograms are not synchronized; each thread should record into its own histogram
+ * and merge it into a shared one once it is done.
+ *
+ * @param histogram The Histogram instance.
+ * @param value The value to record.
+ */
+void Histogram_record(Histogram const histogram, uint64_t const value) {
+    guardNotNull(histogram, "histogram", "Histogram_record");
+
+    histogram->count += 1;
+    if (value < histogram->min) {
+        histogram->min = value;
+    }
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+    histogram->sum += (double)value;
+    histogram->bucketCounts[Histogram_bucketIndex(value)] += 1;
+}
+
+/**
+ * Add every value recorded in another histogram to this histogram.
+ *
+ * @param histogram The Histogram instance.
+ * @param otherHistogram The histogram whose values to add. It is left unchanged.
+ */
+void Histogram_merge(Histogram const histogram, ConstHistogram const otherHistogram) {
+    guardNotNull(histogram, "histogram", "Histogram_merge");
+    guardNotNull(otherHistogram, "otherHistogram", "Histogram_merge");
+
+    histogram->count += otherHistogram->count;
+    if (otherHistogram->min < histogram->min) {
+        histogram->min = otherHistogram->min;
+    }
+    if (otherHistogram->max > histogram->max) {
+        histogram->max = otherHistogram->max;
+    }
+    histogram->sum += otherHistogram->sum;
+    for (size_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i += 1) {
+        histogram->bucketCounts[i] += otherHistogram->bucketCounts[i];
+    }
+}
+
+/**
+ * Get the number of values recorded in the histogram.
+ *
+ * @param histogram The Histogram instance.
+ *
+ * @returns The value count.
+ */
+uint64_t Histogram_count(ConstHistogram const histogram) {
+    guardNotNull(histogram, "histogram", "Histogram_count");
+    return histogram->count;
+}
+
+/**
+ * Get the smallest value recorded in the histogram.
+ *
+ * @param histogram The Histogram instance.
+ *
+ * @returns The exact smallest value, or 0 if the histogram is empty.
+ */
+uint64_t Histogram_min(ConstHistogram const histogram) {
+    guardNotNull(histogram, "histogram", "Histogram_min");
+    return histogram->count == 0 ? 0 : histogram->min;
+}
+
+/**
+ * Get the largest value recorded in the histogram.
+ *
+ * @param histogram The Histogram instance.
+ *
+ * @returns The exact largest value, or 0 if the histogram is empty.
+ */
+uint64_t Histogram_max(ConstHistogram const histogram) {
+    guardNotNull(histogram, "histogram", "Histogram_max");
+    return histogram->max;
+}
+
+/**
+ * Get the mean of the values recorded in the histogram.
+ *
+ * @param histogram The Histogram instance.
+ *
+ * @returns The mean, or 0 if the histogram is empty.
+ */
+double Histogram_mean(ConstHistogram const histogram) {
+    guardNotNull(histogram, "histogram", "Histogram_mean");
+    return histogram->count == 0 ? 0 : histogram->sum / (double)histogram->count;
+}
+
+/**
+ * Get the value at the given quantile, in thousandths: the highest value in the bucket containing the value below which
+ * the given fraction of recorded values fall. For example, 500 gives the median, and 999 gives the 99.9th percentile.
+ *
+ * @param histogram The Histogram instance.
+ * @param permille The quantile in thousandths, from 0 to 1000.
+ *
+ * @returns The value at the quantile, or 0 if the histogram is empty.
+ */
+uint64_t Histogram_valueAtPermille(ConstHistogram const histogram, unsigned int const permille) {
+    guardNotNull(histogram, "histogram", "Histogram_valueAtPermille");
+    guardFmt(permille <= 1000, "Histogram_valueAtPermille: permille (%u) must be from 0 to 1000", permille);
+
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    // Round up, so that the quantile of a single value is that value
+    uint64_t targetCount = (histogram->count * permille + 999) / 1000;
+    if (targetCount == 0) {
+        targetCount = 1;
+    }
+
+    uint64_t cumulativeCount = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i += 1) {
+        cumulativeCount += histogram->bucketCounts[i];
+        if (cumulativeCount >= targetCount) {
+            uint64_t const value = Histogram_bucketHighestValue(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/**
+ * Write the histogram as a JSON object: its count, min, max, mean, p50, p99 and p999, and every non-empty bucket as a
+ * [lowestValue, highestValue, count] triple.
+ *
+ * @param histogram The Histogram instance.
+ * @param file The file to write to.
+ */
+void Histogram_writeJson(ConstHistogram const histogram, FILE * const file) {
+    guardNotNull(histogram, "histogram", "Histogram_writeJson");
+    guardNotNull(file, "file", "Histogram_writeJson");
+
+    fprintf(
+        file,
+        "{\"count\": %llu, \"min\": %llu, \"max\": %llu, \"mean\": %.1f, "
+        "\"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"buckets\": [",
+        (unsigned long long)histogram->count,
+        (unsigned long long)Histogram_min(histogram),
+        (unsigned long long)Histogram_max(histogram),
+        Histogram_mean(histogram),
+        (unsigned long long)Histogram_valueAtPermille(histogram, 500),
+        (unsigned long long)Histogram_valueAtPermille(histogram, 990),
+        (unsigned long long)Histogram_valueAtPermille(histogram, 999)
+    );
+
+    char const *separator = "";
+    for (size_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i += 1) {
+        if (histogram->bucketCounts[i] == 0) {
+            continue;
+        }
+
+        fprintf(
+            file,
+            "%s[%llu, %llu, %llu]",
+            separator,
+            (unsigned long long)Histogram_bucketLowestValue(i),
+            (unsigned long long)Histogram_bucketHighestValue(i),
+            (unsigned long long)histogram->bucketCounts[i]
+        );
+        separator = ", ";
+    }
+    fprintf(file, "]}");
+}
+
+static size_t Histogram_bucketIndex(uint64_t const value) {
+    if (value < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (size_t)value;
+    }
+
+    // The highest set bit picks the power of two; the next HISTOGRAM_SUB_BUCKET_BITS bits pick the sub-bucket
+    unsigned int const highestBit = 63 - (unsigned int)__builtin_clzll(value);
+    unsigned int const shift = highestBit - HISTOGRAM_SUB_BUCKET_BITS;
+    size_t const subBucketIndex = (size_t)(value >> shift) - HISTOGRAM_SUB_BUCKET_COUNT;
+    return HISTOGRAM_SUB_BUCKET_COUNT * (shift + 1) + subBucketIndex;
+}
+
+static uint64_t Histogram_bucketLowestValue(size_t const bucketIndex) {
+    if (bucketIndex < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (uint64_t)bucketIndex;
+    }
+
+    unsigned int const shift = (unsigned int)(bucketIndex / HISTOGRAM_SUB_BUCKET_COUNT) - 1;
+    uint64_t const subBucketIndex = (uint64_t)(bucketIndex % HISTOGRAM_SUB_BUCKET_COUNT);
+    return (HISTOGRAM_SUB_BUCKET_COUNT + subBucketIndex) << shift;
+}
+
+static uint64_t Histogram_bucketHighestValue(size_t const bucketIndex) {
+    if (bucketIndex < HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (uint64_t)bucketIndex;
+    }
+
+    unsigned int const shift = (unsigned int)(bucketIndex / HISTOGRAM_SUB_BUCKET_COUNT) - 1;
+    return Histogram_bucketLowestValue(bucketIndex) + (((uint64_t)1 << shift) - 1);
+}
@@ -0,0 +1,313 @@
+#include "../../include/util/InputStream.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/time.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#define INPUT_STREAM_INITIAL_CAPACITY ((size_t)1 << 20)
+#define INPUT_STREAM_MAX_CAPACITY ((size_t)64 << 20)
+
+#define FOLLOW_MIN_BACKOFF_NS UINT64_C(100000)
+#define FOLLOW_MAX_BACKOFF_NS UINT64_C(50000000)
+
+/**
+ * Represents a file read sequentially through a large buffer, without seeking. Data stays in the buffer until it is
+ * consumed, so a reader can look at everything it has not yet consumed, such as a partly received transaction section.
+ * The buffer grows only as far as the unconsumed data requires, up to a fixed limit.
+ *
+ * Reads block until data arrives, so a producer writing into a pipe is held back by the pipe filling up rather than by
+ * this buffer growing.
+ *
+ * A followed stream does not end at the end of the file: it waits for the file to grow, using inotify if available and
+ * polling with exponential backoff otherwise, until no data has arrived for the idle timeout.
+ */
+struct InputStream {
+    char const *filePath;
+    int fd;
+    bool ownsFd;
+
+    char *buffer;
+    size_t capacity;
+    size_t start;
+    size_t end;
+
+    bool follow;
+    unsigned int followIdleTimeoutMs;
+    int inotifyFd;
+};
+
+static InputStream InputStream_create(
+    int fd,
+    bool ownsFd,
+    char const *filePath,
+    bool follow,
+    unsigned int followIdleTimeoutMs
+);
+static bool InputStream_waitForGrowth(InputStream stream, uint64_t deadlineNs);
+static void InputStream_drainInotify(InputStream stream);
+
+/**
+ * Open the given file for buffered sequential reading. If the operation fails, abort the program with an error
+ * message.
+ *
+ * @param filePath The path to the file.
+ * @param follow Whether to keep waiting for the file to grow once its end is reached.
+ * @param followIdleTimeoutMs If following, how long to wait for the file to grow before treating it as ended, or 0 to
+ *                            wait forever.
+ *
+ * @returns The newly opened InputStream. The caller is responsible for closing it.
+ */
+InputStream InputStream_openFile(
+    char const * const filePath,
+    bool const follow,
+    unsigned int const followIdleTimeoutMs
+) {
+    guardNotNull(filePath, "filePath", "InputStream_openFile");
+
+    int const fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        int const openErrorCode = errno;
+        abortWithErrorFmt(
+            "InputStream_openFile: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            filePath,
+            openErrorCode,
+            strerror(openErrorCode)
+        );
+    }
+
+    InputStream const stream = InputStream_create(fd, true, filePath, follow, followIdleTimeoutMs);
+
+    // The watch is added before anything is read, so no write after the first read can be missed. Without inotify,
+    // the stream falls back to polling
+    if (follow) {
+        stream->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (stream->inotifyFd != -1 && inotify_add_watch(stream->inotifyFd, filePath, IN_MODIFY) == -1) {
+            close(stream->inotifyFd);
+            stream->inotifyFd = -1;
+        }
+    }
+
+    return stream;
+}
+
+/**
+ * Read from an already open file descriptor, such as standard input or a pipe inherited from the parent process. The
+ * stream is not followed, and the descriptor is left open when the stream is closed.
+ *
+ * @param fd The file descriptor.
+ * @param description A description of the file descriptor to be included in error messages.
+ *
+ * @returns The newly created InputStream. The caller is responsible for closing it.
+ */
+InputStream InputStream_openFd(int const fd, char const * const description) {
+    guardFmt(fd >= 0, "InputStream_openFd: Invalid file descriptor (%d)", fd);
+    guardNotNull(description, "description", "InputStream_openFd");
+
+    return InputStream_create(fd, false, description, false, 0);
+}
+
+static InputStream InputStream_create(
+    int const fd,
+    bool const ownsFd,
+    char const * const filePath,
+    bool const follow,
+    unsigned int const followIdleTimeoutMs
+) {
+    InputStream const stream = safeMalloc(sizeof *stream, "InputStream_create");
+    stream->filePath = filePath;
+    stream->fd = fd;
+    stream->ownsFd = ownsFd;
+    stream->capacity = INPUT_STREAM_INITIAL_CAPACITY;
+    stream->buffer = safeMalloc(stream->capacity, "InputStream_create");
+    stream->start = 0;
+    stream->end = 0;
+    stream->follow = follow;
+    stream->followIdleTimeoutMs = followIdleTimeoutMs;
+    stream->inotifyFd = -1;
+    return stream;
+}
+
+/**
+ * Close the file, unless it was opened by the caller, and free the memory associated with the InputStream.
+ *
+ * @param stream The InputStream instance.
+ */
+void InputStream_close(InputStream const stream) {
+    guardNotNull(stream, "stream", "InputStream_close");
+
+    if (stream->inotifyFd != -1) {
+        close(stream->inotifyFd);
+    }
+    if (stream->ownsFd) {
+        close(stream->fd);
+    }
+    free(stream->buffer);
+    free(stream);
+}
+
+/**
+ * Get the buffered data which has not been consumed yet.
+ *
+ * @param stream The InputStream instance.
+ *
+ * @returns The unconsumed data. It is valid until the next fill or consume.
+ */
+char const *InputStream_chars(InputStream const stream) {
+    guardNotNull(stream, "stream", "InputStream_chars");
+    return stream->buffer + stream->start;
+}
+
+/**
+ * Get the length of the buffered data which has not been consumed yet.
+ *
+ * @param stream The InputStream instance.
+ *
+ * @returns The number of unconsumed characters.
+ */
+size_t InputStream_length(InputStream const stream) {
+    guardNotNull(stream, "stream", "InputStream_length");
+    return stream->end - stream->start;
+}
+
+/**
+ * Read more data into the buffer, after any unconsumed data. This blocks until some data arrives; if the stream is
+ * followed, that includes waiting for the file to grow. If the operation fails, or the unconsumed data would exceed
+ * the buffer limit, abort the program with an error message.
+ *
+ * @param stream The InputStream instance.
+ *
+ * @returns Whether data was read; false if the end of the stream was reached.
+ */
+bool InputStream_fill(InputStream const stream) {
+    guardNotNull(stream, "stream", "InputStream_fill");
+
+    // Move the unconsumed data to the front, and only grow once that is not enough
+    if (stream->start > 0) {
+        memmove(stream->buffer, stream->buffer + stream->start, stream->end - stream->start);
+        stream->end -= stream->start;
+        stream->start = 0;
+    }
+    if (stream->end == stream->capacity) {
+        if (stream->capacity == INPUT_STREAM_MAX_CAPACITY) {
+            abortWithErrorFmt(
+                "InputStream_fill: More than %zu unconsumed bytes from \"%s\"",
+                INPUT_STREAM_MAX_CAPACITY,
+                stream->filePath
+            );
+        }
+        stream->capacity *= 2;
+        stream->buffer = safeRealloc(stream->buffer, stream->capacity, "InputStream_fill");
+    }
+
+    uint64_t const deadlineNs = stream->follow && stream->followIdleTimeoutMs > 0
+        ? safeMonotonicTimeNs("InputStream_fill") + (uint64_t)stream->followIdleTimeoutMs * UINT64_C(1000000)
+        : 0;
+    while (true) {
+        ssize_t const readCount = read(stream->fd, stream->buffer + stream->end, stream->capacity - stream->end);
+        if (readCount > 0) {
+            stream->end += (size_t)readCount;
+            return true;
+        }
+        if (readCount == -1) {
+            int const readErrorCode = errno;
+            if (readErrorCode == EINTR) {
+                continue;
+            }
+            abortWithErrorFmt(
+                "InputStream_fill: Failed to read from \"%s\" using read (error code: %d; error message: \"%s\")",
+                stream->filePath,
+                readErrorCode,
+                strerror(readErrorCode)
+            );
+        }
+
+        if (!stream->follow || !InputStream_waitForGrowth(stream, deadlineNs)) {
+            return false;
+        }
+    }
+}
+
+/**
+ * Mark the given number of characters at the start of the unconsumed data as consumed.
+ *
+ * @param stream The InputStream instance.
+ * @param count The number of characters to consume.
+ */
+void InputStream_consume(InputStream const stream, size_t const count) {
+    guardNotNull(stream, "stream", "InputStream_consume");
+    guardFmt(
+        count <= stream->end - stream->start,
+        "InputStream_consume: Cannot consume %zu characters when only %zu are buffered",
+        count,
+        stream->end - stream->start
+    );
+
+    stream->start += count;
+    if (stream->start == stream->end) {
+        stream->start = 0;
+        stream->end = 0;
+    }
+}
+
+static bool InputStream_waitForGrowth(InputStream const stream, uint64_t const deadlineNs) {
+    uint64_t const nowNs = safeMonotonicTimeNs("InputStream_fill");
+    if (deadlineNs != 0 && nowNs >= deadlineNs) {
+        return false;
+    }
+
+    if (stream->inotifyFd != -1) {
+        int const timeoutMs = deadlineNs == 0 ? -1 : (int)((deadlineNs - nowNs + UINT64_C(999999)) / UINT64_C(1000000));
+        struct pollfd pollFd = {.fd = stream->inotifyFd, .events = POLLIN, .revents = 0};
+        int const pollResult = poll(&pollFd, 1, timeoutMs);
+        if (pollResult == -1 && errno != EINTR) {
+            int const pollErrorCode = errno;
+            abortWithErrorFmt(
+                "InputStream_fill: Failed to wait for \"%s\" to grow using poll (error code: %d; error message: \"%s\")",
+                stream->filePath,
+                pollErrorCode,
+                strerror(pollErrorCode)
+            );
+        }
+        InputStream_drainInotify(stream);
+        return true;
+    }
+
+    // Without inotify, poll with exponential backoff; the backoff resets every time data arrives
+    uint64_t backoffNs = FOLLOW_MIN_BACKOFF_NS;
+    while (true) {
+        nanosleep(&(struct timespec){
+            .tv_sec = (time_t)(backoffNs / UINT64_C(1000000000)),
+            .tv_nsec = (long)(backoffNs % UINT64_C(1000000000))
+        }, NULL);
+
+        off_t const position = lseek(stream->fd, 0, SEEK_CUR);
+        off_t const length = lseek(stream->fd, 0, SEEK_END);
+        lseek(stream->fd, position, SEEK_SET);
+        if (length > position) {
+            return true;
+        }
+        if (deadlineNs != 0 && safeMonotonicTimeNs("InputStream_fill") >= deadlineNs) {
+            return false;
+        }
+        backoffNs = backoffNs * 2 > FOLLOW_MAX_BACKOFF_NS ? FOLLOW_MAX_BACKOFF_NS : backoffNs * 2;
+    }
+}
+
+static void InputStream_drainInotify(InputStream const stream) {
+    // Watching a single file, the events carry no names; only that one arrived matters
+    char events[256] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (read(stream->inotifyFd, events, sizeof events) > 0) {
+    }
+}
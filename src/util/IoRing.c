@@ -0,0 +1,311 @@
+#include "../../include/util/IoRing.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+/**
+ * Represents an io_uring instance, driven directly through its system calls and shared rings. Only what batched file
+ * reads need is supported: registered files, registered buffers and fixed reads. An IoRing is not synchronized.
+ */
+struct IoRing {
+    int fd;
+
+    void *submissionRing;
+    size_t submissionRingSize;
+    void *completionRing;
+    size_t completionRingSize;
+    struct io_uring_sqe *submissionEntries;
+    size_t submissionEntriesSize;
+
+    unsigned int *submissionHead;
+    unsigned int *submissionTail;
+    unsigned int submissionMask;
+    unsigned int submissionEntryCount;
+    unsigned int *submissionArray;
+    unsigned int pendingSubmissionCount;
+
+    unsigned int *completionHead;
+    unsigned int *completionTail;
+    unsigned int completionMask;
+    struct io_uring_cqe *completionEntries;
+
+    uint64_t enterCount;
+};
+
+static void *IoRing_mapRing(int fd, size_t size, off_t offset);
+
+/**
+ * Create an IoRing.
+ *
+ * @param entryCount The number of submission queue entries. The kernel rounds it up to a power of two.
+ *
+ * @returns The newly created IoRing, or null if io_uring is not available, for example because the kernel is too old or
+ *          io_uring has been disabled. The caller is responsible for freeing it.
+ */
+IoRing IoRing_create(unsigned int const entryCount) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+    long const fd = syscall(__NR_io_uring_setup, entryCount, &params);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    IoRing const ring = safeMalloc(sizeof *ring, "IoRing_create");
+    ring->fd = (int)fd;
+    ring->enterCount = 0;
+    ring->pendingSubmissionCount = 0;
+
+    ring->submissionRingSize = params.sq_off.array + params.sq_entries * sizeof (unsigned int);
+    ring->completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+    bool const singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping && ring->completionRingSize > ring->submissionRingSize) {
+        ring->submissionRingSize = ring->completionRingSize;
+    }
+    ring->submissionRing = IoRing_mapRing(ring->fd, ring->submissionRingSize, IORING_OFF_SQ_RING);
+    ring->completionRing = singleMapping
+        ? ring->submissionRing
+        : IoRing_mapRing(ring->fd, ring->completionRingSize, IORING_OFF_CQ_RING);
+    ring->submissionEntriesSize = params.sq_entries * sizeof (struct io_uring_sqe);
+    ring->submissionEntries = IoRing_mapRing(ring->fd, ring->submissionEntriesSize, IORING_OFF_SQES);
+
+    char * const submissionRing = ring->submissionRing;
+    ring->submissionHead = (void *)(submissionRing + params.sq_off.head);
+    ring->submissionTail = (void *)(submissionRing + params.sq_off.tail);
+    ring->submissionMask = *(unsigned int *)(void *)(submissionRing + params.sq_off.ring_mask);
+    ring->submissionEntryCount = *(unsigned int *)(void *)(submissionRing + params.sq_off.ring_entries);
+    ring->submissionArray = (void *)(submissionRing + params.sq_off.array);
+
+    char * const completionRing = ring->completionRing;
+    ring->completionHead = (void *)(completionRing + params.cq_off.head);
+    ring->completionTail = (void *)(completionRing + params.cq_off.tail);
+    ring->completionMask = *(unsigned int *)(void *)(completionRing + params.cq_off.ring_mask);
+    ring->completionEntries = (void *)(completionRing + params.cq_off.cqes);
+
+    return ring;
+}
+
+/**
+ * Close the io_uring instance and free the memory associated with the IoRing. Registered files and buffers are
+ * unregistered.
+ *
+ * @param ring The IoRing instance.
+ */
+void IoRing_destroy(IoRing const ring) {
+    guardNotNull(ring, "ring", "IoRing_destroy");
+
+    munmap(ring->submissionEntries, ring->submissionEntriesSize);
+    if (ring->completionRing != ring->submissionRing) {
+        munmap(ring->completionRing, ring->completionRingSize);
+    }
+    munmap(ring->submissionRing, ring->submissionRingSize);
+    close(ring->fd);
+    free(ring);
+}
+
+/**
+ * Register files with the ring, so that requests can refer to them by index without the kernel looking up the file
+ * descriptor each time. Files already registered must first be unregistered with IoRing_unregisterFiles.
+ *
+ * @param ring The IoRing instance.
+ * @param fds The file descriptors. A request refers to fds[i] as file index i.
+ * @param fdCount The number of file descriptors.
+ *
+ * @returns Whether the files were registered. If false, for example because the process has too many files open
+ *          (EMFILE), errno is set and the files can still be read without the ring.
+ */
+bool IoRing_registerFiles(IoRing const ring, int const * const fds, unsigned int const fdCount) {
+    guardNotNull(ring, "ring", "IoRing_registerFiles");
+    guardNotNull(fds, "fds", "IoRing_registerFiles");
+
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, fds, fdCount) != -1;
+}
+
+/**
+ * Unregister the files registered with IoRing_registerFiles. No request referring to them may be in flight. If the
+ * operation fails, abort the program with an error message.
+ *
+ * @param ring The IoRing instance.
+ */
+void IoRing_unregisterFiles(IoRing const ring) {
+    guardNotNull(ring, "ring", "IoRing_unregisterFiles");
+
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_FILES, NULL, 0) == -1) {
+        int const unregisterErrorCode = errno;
+        abortWithErrorFmt(
+            "IoRing_unregisterFiles: Failed to unregister files using io_uring_register"
+            " (error code: %d; error message: \"%s\")",
+            unregisterErrorCode,
+            strerror(unregisterErrorCode)
+        );
+    }
+}
+
+/**
+ * Register buffers with the ring, so that the kernel pins and maps them once instead of on every read.
+ *
+ * @param ring The IoRing instance.
+ * @param buffers The buffers. A request refers to buffers[i] as buffer index i.
+ * @param bufferCount The number of buffers.
+ *
+ * @returns Whether the buffers were registered. If false, for example because pinning them would exceed the locked
+ *          memory limit (ENOMEM), errno is set.
+ */
+bool IoRing_registerBuffers(IoRing const ring, struct iovec const * const buffers, unsigned int const bufferCount) {
+    guardNotNull(ring, "ring", "IoRing_registerBuffers");
+    guardNotNull(buffers, "buffers", "IoRing_registerBuffers");
+
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, buffers, bufferCount) != -1;
+}
+
+/**
+ * Queue a read from a registered file into (part of) a registered buffer. It is not submitted until
+ * IoRing_submitAndWait.
+ *
+ * @param ring The IoRing instance.
+ * @param fileIndex The index of the registered file.
+ * @param bufferIndex The index of the registered buffer.
+ * @param buffer Where to read to. It must lie within the registered buffer.
+ * @param length The number of bytes to read.
+ * @param offset The offset in the file to read from.
+ * @param userData A value returned with the completion.
+ *
+ * @returns Whether the read was queued; false if the submission queue is full.
+ */
+bool IoRing_prepareReadFixed(
+    IoRing const ring,
+    unsigned int const fileIndex,
+    unsigned int const bufferIndex,
+    void * const buffer,
+    unsigned int const length,
+    uint64_t const offset,
+    uint64_t const userData
+) {
+    guardNotNull(ring, "ring", "IoRing_prepareReadFixed");
+
+    unsigned int const tail = *ring->submissionTail;
+    unsigned int const head = __atomic_load_n(ring->submissionHead, __ATOMIC_ACQUIRE);
+    if (tail - head == ring->submissionEntryCount) {
+        return false;
+    }
+
+    unsigned int const index = tail & ring->submissionMask;
+    struct io_uring_sqe * const entry = &ring->submissionEntries[index];
+    memset(entry, 0, sizeof *entry);
+    entry->opcode = IORING_OP_READ_FIXED;
+    entry->flags = IOSQE_FIXED_FILE;
+    entry->fd = (int32_t)fileIndex;
+    entry->addr = (uint64_t)(uintptr_t)buffer;
+    entry->len = length;
+    entry->off = offset;
+    entry->buf_index = (uint16_t)bufferIndex;
+    entry->user_data = userData;
+
+    ring->submissionArray[index] = index;
+    __atomic_store_n(ring->submissionTail, tail + 1, __ATOMIC_RELEASE);
+    ring->pendingSubmissionCount += 1;
+    return true;
+}
+
+/**
+ * Submit the queued requests and wait for completions, in a single system call. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param ring The IoRing instance.
+ * @param waitCount The number of completions to wait for.
+ *
+ * @returns The number of requests submitted.
+ */
+unsigned int IoRing_submitAndWait(IoRing const ring, unsigned int const waitCount) {
+    guardNotNull(ring, "ring", "IoRing_submitAndWait");
+
+    while (true) {
+        ring->enterCount += 1;
+        long const submittedCount = syscall(
+            __NR_io_uring_enter,
+            ring->fd,
+            ring->pendingSubmissionCount,
+            waitCount,
+            waitCount > 0 ? IORING_ENTER_GETEVENTS : 0,
+            NULL,
+            0
+        );
+        if (submittedCount == -1) {
+            int const enterErrorCode = errno;
+            if (enterErrorCode == EINTR) {
+                continue;
+            }
+            abortWithErrorFmt(
+                "IoRing_submitAndWait: Failed to submit requests using io_uring_enter (error code: %d; error message: \"%s\")",
+                enterErrorCode,
+                strerror(enterErrorCode)
+            );
+        }
+
+        ring->pendingSubmissionCount -= (unsigned int)submittedCount;
+        return (unsigned int)submittedCount;
+    }
+}
+
+/**
+ * Take the next completion, if there is one.
+ *
+ * @param ring The IoRing instance.
+ * @param completionOutPtr Where to store the completion.
+ *
+ * @returns Whether a completion was taken.
+ */
+bool IoRing_popCompletion(IoRing const ring, struct IoRingCompletion * const completionOutPtr) {
+    guardNotNull(ring, "ring", "IoRing_popCompletion");
+    guardNotNull(completionOutPtr, "completionOutPtr", "IoRing_popCompletion");
+
+    unsigned int const head = *ring->completionHead;
+    unsigned int const tail = __atomic_load_n(ring->completionTail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+
+    struct io_uring_cqe const * const entry = &ring->completionEntries[head & ring->completionMask];
+    *completionOutPtr = (struct IoRingCompletion){
+        .userData = entry->user_data,
+        .result = entry->res
+    };
+    __atomic_store_n(ring->completionHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Get the number of io_uring_enter system calls made through the ring.
+ *
+ * @param ring The IoRing instance.
+ *
+ * @returns The number of system calls.
+ */
+uint64_t IoRing_enterCount(IoRing const ring) {
+    guardNotNull(ring, "ring", "IoRing_enterCount");
+    return ring->enterCount;
+}
+
+static void *IoRing_mapRing(int const fd, size_t const size, off_t const offset) {
+    void * const mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    if (mapping == MAP_FAILED) {
+        int const mmapErrorCode = errno;
+        abortWithErrorFmt(
+            "IoRing_create: Failed to map an io_uring ring using mmap (error code: %d; error message: \"%s\")",
+            mmapErrorCode,
+            strerror(mmapErrorCode)
+        );
+    }
+    return mapping;
+}
@@ -0,0 +1,164 @@
+#include "../../include/util/ThreadPool.h"
+
+#include "../../include/util/memory.h"
+#include "../../include/util/thread.h"
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * Represents a fixed set of worker threads which run batches of indexed tasks. A batch is handed out one task index at
+ * a time, so uneven tasks are balanced across the workers. Only one batch runs at a time.
+ */
+struct ThreadPool {
+    pthread_mutex_t mutex;
+    pthread_cond_t taskAvailableCondition;
+    pthread_cond_t batchDoneCondition;
+
+    size_t threadCount;
+    pthread_t *threadIds;
+    bool stopping;
+
+    ThreadPoolTask task;
+    void *taskArg;
+    size_t taskCount;
+    size_t nextTaskIndex;
+    size_t doneTaskCount;
+};
+
+static void *ThreadPool_workerThreadStart(void *poolAsVoidPtr);
+
+/**
+ * Create a ThreadPool and start its worker threads.
+ *
+ * @param threadCount The number of worker threads, or 0 for one per online processor.
+ *
+ * @returns The newly created ThreadPool. The caller is responsible for freeing it.
+ */
+ThreadPool ThreadPool_create(size_t threadCount) {
+    if (threadCount == 0) {
+        long const processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = processorCount > 0 ? (size_t)processorCount : 1;
+    }
+
+    ThreadPool const pool = safeMalloc(sizeof *pool, "ThreadPool_create");
+    safeMutexInit(&pool->mutex, NULL, "ThreadPool_create");
+    safeConditionInit(&pool->taskAvailableCondition, NULL, "ThreadPool_create");
+    safeConditionInit(&pool->batchDoneCondition, NULL, "ThreadPool_create");
+
+    pool->threadCount = threadCount;
+    pool->stopping = false;
+    pool->task = NULL;
+    pool->taskArg = NULL;
+    pool->taskCount = 0;
+    pool->nextTaskIndex = 0;
+    pool->doneTaskCount = 0;
+
+    pool->threadIds = safeMalloc(sizeof *pool->threadIds * threadCount, "ThreadPool_create");
+    for (size_t i = 0; i < threadCount; i += 1) {
+        pool->threadIds[i] = safePthreadCreate(NULL, ThreadPool_workerThreadStart, pool, "ThreadPool_create");
+    }
+
+    return pool;
+}
+
+/**
+ * Stop the worker threads and free the memory associated with the ThreadPool.
+ *
+ * @param pool The ThreadPool instance.
+ */
+void ThreadPool_destroy(ThreadPool const pool) {
+    guardNotNull(pool, "pool", "ThreadPool_destroy");
+
+    safeMutexLock(&pool->mutex, "ThreadPool_destroy");
+    pool->stopping = true;
+    safeConditionBroadcast(&pool->taskAvailableCondition, "ThreadPool_destroy");
+    safeMutexUnlock(&pool->mutex, "ThreadPool_destroy");
+
+    for (size_t i = 0; i < pool->threadCount; i += 1) {
+        safePthreadJoin(pool->threadIds[i], "ThreadPool_destroy");
+    }
+    free(pool->threadIds);
+
+    safeConditionDestroy(&pool->batchDoneCondition, "ThreadPool_destroy");
+    safeConditionDestroy(&pool->taskAvailableCondition, "ThreadPool_destroy");
+    safeMutexDestroy(&pool->mutex, "ThreadPool_destroy");
+    free(pool);
+}
+
+/**
+ * Get the number of worker threads in the ThreadPool.
+ *
+ * @param pool The ThreadPool instance.
+ *
+ * @returns The number of worker threads.
+ */
+size_t ThreadPool_threadCount(ThreadPool const pool) {
+    guardNotNull(pool, "pool", "ThreadPool_threadCount");
+    return pool->threadCount;
+}
+
+/**
+ * Run a task once for each index from 0 to taskCount - 1 on the worker threads, and wait for every run to finish.
+ *
+ * @param pool The ThreadPool instance.
+ * @param taskCount The number of times to run the task.
+ * @param task The task. It is passed taskArg and the index of the run.
+ * @param taskArg The argument passed to each run of the task.
+ */
+void ThreadPool_run(
+    ThreadPool const pool,
+    size_t const taskCount,
+    ThreadPoolTask const task,
+    void * const taskArg
+) {
+    guardNotNull(pool, "pool", "ThreadPool_run");
+    guard(task != NULL, "ThreadPool_run: task must not be null");
+
+    safeMutexLock(&pool->mutex, "ThreadPool_run");
+    pool->task = task;
+    pool->taskArg = taskArg;
+    pool->taskCount = taskCount;
+    pool->nextTaskIndex = 0;
+    pool->doneTaskCount = 0;
+    safeConditionBroadcast(&pool->taskAvailableCondition, "ThreadPool_run");
+
+    while (pool->doneTaskCount < taskCount) {
+        safeConditionWait(&pool->batchDoneCondition, &pool->mutex, "ThreadPool_run");
+    }
+    safeMutexUnlock(&pool->mutex, "ThreadPool_run");
+}
+
+static void *ThreadPool_workerThreadStart(void * const poolAsVoidPtr) {
+    ThreadPool const pool = poolAsVoidPtr;
+
+    safeMutexLock(&pool->mutex, "ThreadPool worker");
+    while (true) {
+        while (!pool->stopping && pool->nextTaskIndex == pool->taskCount) {
+            safeConditionWait(&pool->taskAvailableCondition, &pool->mutex, "ThreadPool worker");
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        size_t const taskIndex = pool->nextTaskIndex;
+        pool->nextTaskIndex += 1;
+        ThreadPoolTask const task = pool->task;
+        void * const taskArg = pool->taskArg;
+
+        safeMutexUnlock(&pool->mutex, "ThreadPool worker");
+        task(taskArg, taskIndex);
+        safeMutexLock(&pool->mutex, "ThreadPool worker");
+
+        pool->doneTaskCount += 1;
+        if (pool->doneTaskCount == pool->taskCount) {
+            safeConditionSignal(&pool->batchDoneCondition, "ThreadPool worker");
+        }
+    }
+    safeMutexUnlock(&pool->mutex, "ThreadPool worker");
+
+    return NULL;
+}
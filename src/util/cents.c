@@ -0,0 +1,161 @@
+#include "../../include/util/cents.h"
+
+#include "../../include/util/guard.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Parse a decimal amount of money into an exact number of cents. The amount must match [+-]?[0-9]*(\.[0-9]*)? and
+ * contain at least one digit. Fractions of a cent are rounded half away from zero. Unlike strtod, this never consults
+ * the locale and never goes through floating point.
+ *
+ * @param chars The characters of the amount. They do not need to be null-terminated.
+ * @param length The number of characters.
+ * @param centsOutPtr Where to store the number of cents. It is left unchanged if the amount is invalid.
+ *
+ * @returns Whether the amount was valid and fit in 64 bits.
+ */
+bool parseCents(char const * const chars, size_t const length, int64_t * const centsOutPtr) {
+    guardNotNull(chars, "chars", "parseCents");
+    guardNotNull(centsOutPtr, "centsOutPtr", "parseCents");
+
+    size_t i = 0;
+    bool const negative = i < length && chars[i] == '-';
+    if (i < length && (chars[i] == '+' || chars[i] == '-')) {
+        i += 1;
+    }
+
+    // Whole units are accumulated as cents directly; the bound leaves room for the fraction and rounding
+    uint64_t const maxWholeCents = (UINT64_C(1) << 63) / 10 - 100;
+    uint64_t cents = 0;
+    size_t digitCount = 0;
+    for (; i < length && chars[i] >= '0' && chars[i] <= '9'; i += 1) {
+        if (cents > maxWholeCents) {
+            return false;
+        }
+        cents = cents * 10 + (uint64_t)(chars[i] - '0') * 100;
+        digitCount += 1;
+    }
+
+    if (i < length && chars[i] == '.') {
+        i += 1;
+
+        size_t fractionDigitCount = 0;
+        for (; i < length && chars[i] >= '0' && chars[i] <= '9'; i += 1) {
+            uint64_t const digit = (uint64_t)(chars[i] - '0');
+            if (fractionDigitCount == 0) {
+                cents += digit * 10;
+            } else if (fractionDigitCount == 1) {
+                cents += digit;
+            } else if (fractionDigitCount == 2 && digit >= 5) {
+                cents += 1;
+            }
+            fractionDigitCount += 1;
+        }
+        digitCount += fractionDigitCount;
+    }
+
+    if (i != length || digitCount == 0) {
+        return false;
+    }
+
+    *centsOutPtr = negative ? -(int64_t)cents : (int64_t)cents;
+    return true;
+}
+
+/**
+ * Sum a run of newline-separated amounts which are already known to be valid, such as the transaction lines of a
+ * section which was checked with parseCents. Nothing is validated: each line is read as a sign, whole digits and an
+ * optional fraction, with the same rounding as parseCents.
+ *
+ * @param chars The characters of the lines. The last line may or may not end with a newline.
+ * @param length The number of characters.
+ *
+ * @returns The sum of the amounts in cents.
+ */
+int64_t sumValidCentsLines(char const * const chars, size_t const length) {
+    guardNotNull(chars, "chars", "sumValidCentsLines");
+
+    // Summed with wrapping unsigned arithmetic, which gives the two's complement sum
+    uint64_t sumCents = 0;
+    size_t i = 0;
+    while (i < length) {
+        bool const negative = chars[i] == '-';
+        if (chars[i] == '+' || chars[i] == '-') {
+            i += 1;
+        }
+
+        uint64_t cents = 0;
+        for (; i < length && chars[i] >= '0' && chars[i] <= '9'; i += 1) {
+            cents = cents * 10 + (uint64_t)(chars[i] - '0') * 100;
+        }
+        if (i < length && chars[i] == '.') {
+            i += 1;
+            if (i < length && chars[i] >= '0' && chars[i] <= '9') {
+                cents += (uint64_t)(chars[i] - '0') * 10;
+                i += 1;
+                if (i < length && chars[i] >= '0' && chars[i] <= '9') {
+                    cents += (uint64_t)(chars[i] - '0');
+                    i += 1;
+                    if (i < length && chars[i] >= '5' && chars[i] <= '9') {
+                        cents += 1;
+                    }
+                }
+            }
+        }
+
+        // Skip any further fraction digits and the newline
+        while (i < length && chars[i] != '\n') {
+            i += 1;
+        }
+        i += 1;
+
+        sumCents = negative ? sumCents - cents : sumCents + cents;
+    }
+
+    return (int64_t)sumCents;
+}
+
+/**
+ * Format a number of cents as a decimal amount with exactly two fraction digits, such as "-3213.75" or "0.05".
+ *
+ * @param cents The number of cents.
+ * @param buffer The buffer to write the null-terminated amount into. It must hold at least CENTS_STRING_CAPACITY
+ *               characters.
+ *
+ * @returns The length of the amount, excluding the terminating character.
+ */
+size_t formatCents(int64_t const cents, char * const buffer) {
+    guardNotNull(buffer, "buffer", "formatCents");
+
+    uint64_t magnitude = cents < 0 ? (uint64_t)0 - (uint64_t)cents : (uint64_t)cents;
+
+    // Write the digits backwards into a scratch buffer, then copy them out in order
+    char reversedDigits[CENTS_STRING_CAPACITY];
+    size_t reversedDigitCount = 0;
+    while (reversedDigitCount < 3 || magnitude > 0) {
+        reversedDigits[reversedDigitCount] = (char)('0' + magnitude % 10);
+        reversedDigitCount += 1;
+        magnitude /= 10;
+    }
+
+    size_t length = 0;
+    if (cents < 0) {
+        buffer[length] = '-';
+        length += 1;
+    }
+    while (reversedDigitCount > 0) {
+        reversedDigitCount -= 1;
+        buffer[length] = reversedDigits[reversedDigitCount];
+        length += 1;
+        if (reversedDigitCount == 2) {
+            buffer[length] = '.';
+            length += 1;
+        }
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
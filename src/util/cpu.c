@@ -0,0 +1,37 @@
+#include "../../include/util/cpu.h"
+
+#include "../../include/util/error.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+static pthread_once_t cpuFeaturesOnce = PTHREAD_ONCE_INIT;
+static bool cpuAvx2Supported = false;
+
+static void detectCpuFeatures(void);
+
+/**
+ * Check whether the CPU supports AVX2. The CPU is only checked on the first call; the result is then shared by every
+ * thread, so this is cheap enough to call before each use of an AVX2 kernel.
+ *
+ * @returns Whether AVX2 instructions may be used. Always false other than on x86-64.
+ */
+bool cpuSupportsAvx2(void) {
+    int const onceErrorCode = pthread_once(&cpuFeaturesOnce, detectCpuFeatures);
+    if (onceErrorCode != 0) {
+        abortWithErrorFmt(
+            "cpuSupportsAvx2: Failed to detect CPU features using pthread_once (error code: %d; error message: \"%s\")",
+            onceErrorCode,
+            strerror(onceErrorCode)
+        );
+    }
+    return cpuAvx2Supported;
+}
+
+static void detectCpuFeatures(void) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    cpuAvx2Supported = __builtin_cpu_supports("avx2") != 0;
+#endif
+}
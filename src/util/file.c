@@ -1,15 +1,21 @@
 #include "../../include/util/file.h"
 
+#include "../../include/util/scan.h"
 #include "../../include/util/guard.h"
 #include "../../include/util/error.h"
 
 #include "../../include/util/StringBuilder.h"
 
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /**
  * Open the file using fopen. If the operation fails, abort the program with an error message.
@@ -255,6 +261,156 @@ char *readAllFileText(char const * const filePath) {
     return fileText;
 }
 
+/**
+ * Map the given file into memory for sequential reading with readMappedFileLine. The kernel is advised that the mapping
+ * will be read sequentially, so it reads ahead aggressively and drops pages behind the reader. If the operation fails,
+ * abort the program with an error message.
+ *
+ * @param mappedFileOutPtr Where to store the mapped file. The caller is responsible for unmapping it using
+ *                         safeUnmapFile.
+ * @param filePath The path to the file. The file must be a regular file.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeMapFile(
+    struct MappedFile * const mappedFileOutPtr,
+    char const * const filePath,
+    char const * const callerDescription
+) {
+    guardNotNull(mappedFileOutPtr, "mappedFileOutPtr", "safeMapFile");
+    guardNotNull(filePath, "filePath", "safeMapFile");
+    guardNotNull(callerDescription, "callerDescription", "safeMapFile");
+
+    int const fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        int const openErrorCode = errno;
+        char const * const openErrorMessage = strerror(openErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            openErrorCode,
+            openErrorMessage
+        );
+        return;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1) {
+        int const fstatErrorCode = errno;
+        char const * const fstatErrorMessage = strerror(fstatErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get the size of file \"%s\" using fstat (error code: %d; error message: \"%s\")",
+            callerDescription,
+            filePath,
+            fstatErrorCode,
+            fstatErrorMessage
+        );
+        return;
+    }
+    if (!S_ISREG(fileStat.st_mode)) {
+        abortWithErrorFmt("%s: Cannot map \"%s\" because it is not a regular file", callerDescription, filePath);
+        return;
+    }
+
+    size_t const length = (size_t)fileStat.st_size;
+    void *mapping = NULL;
+    // mmap rejects empty mappings; an empty file simply has no lines
+    if (length > 0) {
+        mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int const mmapErrorCode = errno;
+            char const * const mmapErrorMessage = strerror(mmapErrorCode);
+
+            abortWithErrorFmt(
+                "%s: Failed to map file \"%s\" using mmap (error code: %d; error message: \"%s\")",
+                callerDescription,
+                filePath,
+                mmapErrorCode,
+                mmapErrorMessage
+            );
+            return;
+        }
+
+        // Only a hint, so a failure is not an error
+        madvise(mapping, length, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    *mappedFileOutPtr = (struct MappedFile){
+        .mapping = mapping,
+        .chars = mapping,
+        .length = length,
+        .position = 0
+    };
+}
+
+/**
+ * Unmap a file mapped using safeMapFile. Lines read from it must no longer be used. If the operation fails, abort the
+ * program with an error message.
+ *
+ * @param mappedFilePtr The mapped file.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeUnmapFile(struct MappedFile * const mappedFilePtr, char const * const callerDescription) {
+    guardNotNull(mappedFilePtr, "mappedFilePtr", "safeUnmapFile");
+    guardNotNull(callerDescription, "callerDescription", "safeUnmapFile");
+
+    if (mappedFilePtr->mapping != NULL && munmap(mappedFilePtr->mapping, mappedFilePtr->length) == -1) {
+        int const munmapErrorCode = errno;
+        char const * const munmapErrorMessage = strerror(munmapErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to unmap file using munmap (error code: %d; error message: \"%s\")",
+            callerDescription,
+            munmapErrorCode,
+            munmapErrorMessage
+        );
+    }
+
+    *mappedFilePtr = (struct MappedFile){
+        .mapping = NULL,
+        .chars = NULL,
+        .length = 0,
+        .position = 0
+    };
+}
+
+/**
+ * Read the next line from a mapped file, without copying or allocating. The end of the line is found using SIMD
+ * comparisons where available. If the current position is the end of the file, return false.
+ *
+ * @param mappedFilePtr The mapped file.
+ * @param lineOutPtr Where to store the line. The line points into the mapping and is valid until the file is unmapped.
+ *
+ * @returns Whether a line was read; false if the current position is the end of the file.
+ */
+bool readMappedFileLine(struct MappedFile * const mappedFilePtr, struct FileLine * const lineOutPtr) {
+    guardNotNull(mappedFilePtr, "mappedFilePtr", "readMappedFileLine");
+    guardNotNull(lineOutPtr, "lineOutPtr", "readMappedFileLine");
+
+    size_t const position = mappedFilePtr->position;
+    if (position >= mappedFilePtr->length) {
+        return false;
+    }
+
+    char const * const lineChars = mappedFilePtr->chars + position;
+    size_t const remainingLength = mappedFilePtr->length - position;
+    char const * const newline = findNewline(lineChars, remainingLength);
+
+    size_t const lineLength = newline == NULL ? remainingLength : (size_t)(newline - lineChars);
+    mappedFilePtr->position = newline == NULL ? mappedFilePtr->length : position + lineLength + 1;
+
+    *lineOutPtr = (struct FileLine){
+        .chars = lineChars,
+        .length = lineLength
+    };
+    return true;
+}
+
 /**
  * Read values from the given file using the given format. Values are stored in the locations pointed to by formatArgs.
  * If the operation fails, abort the program with an error message.
@@ -0,0 +1,366 @@
+#include "../../include/util/fileBatch.h"
+
+#include "../../include/util/IoRing.h"
+#include "../../include/util/memory.h"
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+// Registered buffers count against RLIMIT_MEMLOCK on kernels before 5.12, which is often only 64 KiB; where pinning
+// these 4 MiB fails, the files are read with pread instead
+#define FILE_BATCH_BUFFER_COUNT 32U
+#define FILE_BATCH_BUFFER_LENGTH ((size_t)128 << 10)
+
+// Files are opened and registered a window at a time, well below the usual limit of 1024 open files
+#define FILE_BATCH_WINDOW_FILE_COUNT 256U
+
+/**
+ * An io_uring instance and the pool of buffers registered with it, shared by every window of files.
+ */
+struct FileBatchRing {
+    IoRing ring;
+    char *bufferPool;
+    struct iovec *buffers;
+};
+
+/**
+ * A read in flight in a registered buffer: where in which file its bytes belong.
+ */
+struct FileBatchRead {
+    size_t fileIndex;
+    size_t offset;
+    size_t length;
+};
+
+static bool startFileBatchRing(struct FileBatchRing *ringPtr);
+static void stopFileBatchRing(struct FileBatchRing *ringPtr);
+static void openFileBatchWindow(
+    char const * const *filePaths,
+    size_t fileCount,
+    int *fdsOut,
+    struct FileContents *contentsOut,
+    struct FileBatchStats *statsPtr
+);
+static bool readFilesWithIoRing(
+    struct FileBatchRing const *ringPtr,
+    char const * const *filePaths,
+    int const *fds,
+    size_t fileCount,
+    struct FileContents *contentsOut,
+    struct FileBatchStats *statsPtr
+);
+static bool nextFileBatchRead(
+    struct FileContents const *contents,
+    size_t fileCount,
+    size_t *fileIndexPtr,
+    size_t *offsetPtr,
+    struct FileBatchRead *readOutPtr
+);
+static void queueFileBatchRead(
+    IoRing ring,
+    struct FileBatchRead const *readPtr,
+    unsigned int bufferIndex,
+    void *buffer
+);
+static void readFileWithPread(char const *filePath, int fd, struct FileContents *contentsPtr, struct FileBatchStats *statsPtr);
+
+/**
+ * Read the whole contents of many regular files. All of the reads go through a single io_uring instance with a pool of
+ * registered buffers, so the whole batch takes a few system calls per pool of buffers rather than several per file.
+ * The files are opened and registered a window of FILE_BATCH_WINDOW_FILE_COUNT at a time, so any number of files can be
+ * read without running out of file descriptors. If io_uring is not available, or the buffers or a window's files cannot
+ * be registered, the remaining files are read with pread instead. If the operation fails, abort the program with an
+ * error message.
+ *
+ * @param filePaths The paths of the files. Each must be a regular file.
+ * @param fileCount The number of files.
+ * @param contentsOut The array to store the contents of each file in. The caller is responsible for freeing the
+ *                    characters of each.
+ * @param statsOutPtr Where to store how the files were read. usedIoRing is set if any window was read through io_uring.
+ */
+void readFilesBatched(
+    char const * const * const filePaths,
+    size_t const fileCount,
+    struct FileContents * const contentsOut,
+    struct FileBatchStats * const statsOutPtr
+) {
+    guardNotNull(filePaths, "filePaths", "readFilesBatched");
+    guardNotNull(contentsOut, "contentsOut", "readFilesBatched");
+    guardNotNull(statsOutPtr, "statsOutPtr", "readFilesBatched");
+
+    *statsOutPtr = (struct FileBatchStats){.usedIoRing = false, .byteCount = 0, .systemCallCount = 0};
+
+    struct FileBatchRing ring = {.ring = NULL, .bufferPool = NULL, .buffers = NULL};
+    bool useIoRing = fileCount > 0 && startFileBatchRing(&ring);
+
+    int * const fds = safeMalloc(sizeof *fds * FILE_BATCH_WINDOW_FILE_COUNT, "readFilesBatched");
+    for (size_t windowStart = 0; windowStart < fileCount; windowStart += FILE_BATCH_WINDOW_FILE_COUNT) {
+        size_t const remainingFileCount = fileCount - windowStart;
+        size_t const windowFileCount = (
+            remainingFileCount < FILE_BATCH_WINDOW_FILE_COUNT ? remainingFileCount : FILE_BATCH_WINDOW_FILE_COUNT
+        );
+        char const * const * const windowFilePaths = filePaths + windowStart;
+        struct FileContents * const windowContents = contentsOut + windowStart;
+        openFileBatchWindow(windowFilePaths, windowFileCount, fds, windowContents, statsOutPtr);
+
+        // Once a window cannot be registered, the later windows would most likely fail the same way
+        if (useIoRing) {
+            useIoRing = readFilesWithIoRing(&ring, windowFilePaths, fds, windowFileCount, windowContents, statsOutPtr);
+        }
+        if (!useIoRing) {
+            for (size_t i = 0; i < windowFileCount; i += 1) {
+                readFileWithPread(windowFilePaths[i], fds[i], &windowContents[i], statsOutPtr);
+            }
+        }
+
+        for (size_t i = 0; i < windowFileCount; i += 1) {
+            close(fds[i]);
+        }
+        statsOutPtr->systemCallCount += windowFileCount;
+    }
+    free(fds);
+
+    if (ring.ring != NULL) {
+        // Setting up the ring takes one system call, and registering the buffers one more
+        statsOutPtr->systemCallCount += IoRing_enterCount(ring.ring) + 2;
+        stopFileBatchRing(&ring);
+    }
+}
+
+static bool startFileBatchRing(struct FileBatchRing * const ringPtr) {
+    ringPtr->ring = IoRing_create(FILE_BATCH_BUFFER_COUNT);
+    if (ringPtr->ring == NULL) {
+        return false;
+    }
+
+    ringPtr->bufferPool = safeMalloc(FILE_BATCH_BUFFER_COUNT * FILE_BATCH_BUFFER_LENGTH, "readFilesBatched");
+    ringPtr->buffers = safeMalloc(sizeof *ringPtr->buffers * FILE_BATCH_BUFFER_COUNT, "readFilesBatched");
+    for (unsigned int i = 0; i < FILE_BATCH_BUFFER_COUNT; i += 1) {
+        ringPtr->buffers[i] = (struct iovec){
+            .iov_base = ringPtr->bufferPool + i * FILE_BATCH_BUFFER_LENGTH,
+            .iov_len = FILE_BATCH_BUFFER_LENGTH
+        };
+    }
+    if (!IoRing_registerBuffers(ringPtr->ring, ringPtr->buffers, FILE_BATCH_BUFFER_COUNT)) {
+        stopFileBatchRing(ringPtr);
+        ringPtr->ring = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void stopFileBatchRing(struct FileBatchRing * const ringPtr) {
+    IoRing_destroy(ringPtr->ring);
+    free(ringPtr->buffers);
+    free(ringPtr->bufferPool);
+}
+
+static void openFileBatchWindow(
+    char const * const * const filePaths,
+    size_t const fileCount,
+    int * const fdsOut,
+    struct FileContents * const contentsOut,
+    struct FileBatchStats * const statsPtr
+) {
+    for (size_t i = 0; i < fileCount; i += 1) {
+        fdsOut[i] = open(filePaths[i], O_RDONLY | O_CLOEXEC);
+        if (fdsOut[i] == -1) {
+            int const openErrorCode = errno;
+            abortWithErrorFmt(
+                "readFilesBatched: Failed to open file \"%s\" using open (error code: %d; error message: \"%s\")",
+                filePaths[i],
+                openErrorCode,
+                strerror(openErrorCode)
+            );
+        }
+
+        struct stat fileStat;
+        if (fstat(fdsOut[i], &fileStat) == -1) {
+            int const fstatErrorCode = errno;
+            abortWithErrorFmt(
+                "readFilesBatched: Failed to get the size of file \"%s\" using fstat (error code: %d; error message: \"%s\")",
+                filePaths[i],
+                fstatErrorCode,
+                strerror(fstatErrorCode)
+            );
+        }
+        if (!S_ISREG(fileStat.st_mode)) {
+            abortWithErrorFmt("readFilesBatched: Cannot read \"%s\" in a batch because it is not a regular file", filePaths[i]);
+        }
+
+        size_t const length = (size_t)fileStat.st_size;
+        contentsOut[i] = (struct FileContents){
+            .chars = length > 0 ? safeMalloc(length, "readFilesBatched") : NULL,
+            .length = length
+        };
+        statsPtr->byteCount += length;
+        statsPtr->systemCallCount += 2;
+    }
+}
+
+static bool readFilesWithIoRing(
+    struct FileBatchRing const * const ringPtr,
+    char const * const * const filePaths,
+    int const * const fds,
+    size_t const fileCount,
+    struct FileContents * const contentsOut,
+    struct FileBatchStats * const statsPtr
+) {
+    IoRing const ring = ringPtr->ring;
+    struct iovec const * const buffers = ringPtr->buffers;
+    statsPtr->systemCallCount += 1;
+    if (!IoRing_registerFiles(ring, fds, (unsigned int)fileCount)) {
+        return false;
+    }
+
+    struct FileBatchRead * const reads = safeMalloc(sizeof *reads * FILE_BATCH_BUFFER_COUNT, "readFilesBatched");
+    unsigned int freeBufferIndexes[FILE_BATCH_BUFFER_COUNT];
+    unsigned int freeBufferCount = FILE_BATCH_BUFFER_COUNT;
+    for (unsigned int i = 0; i < FILE_BATCH_BUFFER_COUNT; i += 1) {
+        freeBufferIndexes[i] = FILE_BATCH_BUFFER_COUNT - 1 - i;
+    }
+
+    size_t nextFileIndex = 0;
+    size_t nextOffset = 0;
+    unsigned int inFlightCount = 0;
+    while (true) {
+        // Give every free buffer the next chunk of the next file
+        while (freeBufferCount > 0) {
+            struct FileBatchRead read;
+            if (!nextFileBatchRead(contentsOut, fileCount, &nextFileIndex, &nextOffset, &read)) {
+                break;
+            }
+            freeBufferCount -= 1;
+            unsigned int const bufferIndex = freeBufferIndexes[freeBufferCount];
+            reads[bufferIndex] = read;
+            queueFileBatchRead(ring, &read, bufferIndex, buffers[bufferIndex].iov_base);
+            inFlightCount += 1;
+        }
+        if (inFlightCount == 0) {
+            break;
+        }
+
+        IoRing_submitAndWait(ring, 1);
+
+        struct IoRingCompletion completion;
+        while (IoRing_popCompletion(ring, &completion)) {
+            unsigned int const bufferIndex = (unsigned int)completion.userData;
+            struct FileBatchRead * const readPtr = &reads[bufferIndex];
+            char const * const filePath = filePaths[readPtr->fileIndex];
+            if (completion.result < 0) {
+                abortWithErrorFmt(
+                    "readFilesBatched: Failed to read file \"%s\" using io_uring (error code: %d; error message: \"%s\")",
+                    filePath,
+                    -completion.result,
+                    strerror(-completion.result)
+                );
+            }
+            if (completion.result == 0) {
+                abortWithErrorFmt("readFilesBatched: File \"%s\" shrank while it was being read", filePath);
+            }
+
+            size_t const readLength = (size_t)completion.result;
+            memcpy(contentsOut[readPtr->fileIndex].chars + readPtr->offset, buffers[bufferIndex].iov_base, readLength);
+
+            // A short read is finished by reading the rest into the same buffer
+            if (readLength < readPtr->length) {
+                readPtr->offset += readLength;
+                readPtr->length -= readLength;
+                queueFileBatchRead(ring, readPtr, bufferIndex, buffers[bufferIndex].iov_base);
+            } else {
+                freeBufferIndexes[freeBufferCount] = bufferIndex;
+                freeBufferCount += 1;
+                inFlightCount -= 1;
+            }
+        }
+    }
+
+    IoRing_unregisterFiles(ring);
+    statsPtr->systemCallCount += 1;
+    statsPtr->usedIoRing = true;
+
+    free(reads);
+    return true;
+}
+
+static bool nextFileBatchRead(
+    struct FileContents const * const contents,
+    size_t const fileCount,
+    size_t * const fileIndexPtr,
+    size_t * const offsetPtr,
+    struct FileBatchRead * const readOutPtr
+) {
+    while (*fileIndexPtr < fileCount && *offsetPtr >= contents[*fileIndexPtr].length) {
+        *fileIndexPtr += 1;
+        *offsetPtr = 0;
+    }
+    if (*fileIndexPtr == fileCount) {
+        return false;
+    }
+
+    size_t const remainingLength = contents[*fileIndexPtr].length - *offsetPtr;
+    *readOutPtr = (struct FileBatchRead){
+        .fileIndex = *fileIndexPtr,
+        .offset = *offsetPtr,
+        .length = remainingLength < FILE_BATCH_BUFFER_LENGTH ? remainingLength : FILE_BATCH_BUFFER_LENGTH
+    };
+    *offsetPtr += readOutPtr->length;
+    return true;
+}
+
+static void queueFileBatchRead(
+    IoRing const ring,
+    struct FileBatchRead const * const readPtr,
+    unsigned int const bufferIndex,
+    void * const buffer
+) {
+    // At most one read is in flight per buffer, and there are as many submission queue entries as buffers
+    bool const queued = IoRing_prepareReadFixed(
+        ring,
+        (unsigned int)readPtr->fileIndex,
+        bufferIndex,
+        buffer,
+        (unsigned int)readPtr->length,
+        readPtr->offset,
+        bufferIndex
+    );
+    guard(queued, "readFilesBatched: The io_uring submission queue is unexpectedly full");
+}
+
+static void readFileWithPread(
+    char const * const filePath,
+    int const fd,
+    struct FileContents * const contentsPtr,
+    struct FileBatchStats * const statsPtr
+) {
+    size_t offset = 0;
+    while (offset < contentsPtr->length) {
+        statsPtr->systemCallCount += 1;
+        ssize_t const readLength = pread(fd, contentsPtr->chars + offset, contentsPtr->length - offset, (off_t)offset);
+        if (readLength == -1) {
+            int const preadErrorCode = errno;
+            if (preadErrorCode == EINTR) {
+                continue;
+            }
+            abortWithErrorFmt(
+                "readFilesBatched: Failed to read file \"%s\" using pread (error code: %d; error message: \"%s\")",
+                filePath,
+                preadErrorCode,
+                strerror(preadErrorCode)
+            );
+        }
+        if (readLength == 0) {
+            abortWithErrorFmt("readFilesBatched: File \"%s\" shrank while it was being read", filePath);
+        }
+        offset += (size_t)readLength;
+    }
+}
@@ -0,0 +1,102 @@
+#include "../../include/util/hash.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HASH_PRIME_1 UINT64_C(0x9E3779B185EBCA87)
+#define HASH_PRIME_2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define HASH_PRIME_3 UINT64_C(0x165667B19E3779F9)
+#define HASH_PRIME_4 UINT64_C(0x85EBCA77C2B2AE63)
+#define HASH_PRIME_5 UINT64_C(0x27D4EB2F165667C5)
+
+static uint64_t hashRotateLeft(uint64_t value, unsigned int shift);
+static uint64_t hashRound(uint64_t accumulator, uint64_t word);
+static uint64_t hashMergeRound(uint64_t hash, uint64_t accumulator);
+static uint64_t hashReadWord(unsigned char const *bytes);
+static uint32_t hashReadHalfWord(unsigned char const *bytes);
+
+/**
+ * Hash the given bytes using XXH64 with a seed of 0. This is not a cryptographic hash: it detects changes to file
+ * contents, reading 32 bytes at a time in four independent lanes so that large files hash at close to memory speed.
+ *
+ * @param bytes The bytes to hash.
+ * @param length The number of bytes.
+ *
+ * @returns The hash.
+ */
+uint64_t hashBytes(void const * const bytes, size_t const length) {
+    unsigned char const * const chars = bytes;
+    size_t i = 0;
+
+    uint64_t hash;
+    if (length >= 32) {
+        uint64_t lanes[4] = {HASH_PRIME_1 + HASH_PRIME_2, HASH_PRIME_2, 0, 0 - HASH_PRIME_1};
+        for (; i + 32 <= length; i += 32) {
+            for (size_t j = 0; j < 4; j += 1) {
+                lanes[j] = hashRound(lanes[j], hashReadWord(chars + i + j * 8));
+            }
+        }
+
+        hash = (
+            hashRotateLeft(lanes[0], 1)
+            + hashRotateLeft(lanes[1], 7)
+            + hashRotateLeft(lanes[2], 12)
+            + hashRotateLeft(lanes[3], 18)
+        );
+        for (size_t j = 0; j < 4; j += 1) {
+            hash = hashMergeRound(hash, lanes[j]);
+        }
+    } else {
+        hash = HASH_PRIME_5;
+    }
+    hash += (uint64_t)length;
+
+    for (; i + 8 <= length; i += 8) {
+        hash ^= hashRound(0, hashReadWord(chars + i));
+        hash = hashRotateLeft(hash, 27) * HASH_PRIME_1 + HASH_PRIME_4;
+    }
+    if (i + 4 <= length) {
+        hash ^= (uint64_t)hashReadHalfWord(chars + i) * HASH_PRIME_1;
+        hash = hashRotateLeft(hash, 23) * HASH_PRIME_2 + HASH_PRIME_3;
+        i += 4;
+    }
+    for (; i < length; i += 1) {
+        hash ^= chars[i] * HASH_PRIME_5;
+        hash = hashRotateLeft(hash, 11) * HASH_PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static uint64_t hashRotateLeft(uint64_t const value, unsigned int const shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static uint64_t hashRound(uint64_t accumulator, uint64_t const word) {
+    accumulator += word * HASH_PRIME_2;
+    accumulator = hashRotateLeft(accumulator, 31);
+    return accumulator * HASH_PRIME_1;
+}
+
+static uint64_t hashMergeRound(uint64_t hash, uint64_t const accumulator) {
+    hash ^= hashRound(0, accumulator);
+    return hash * HASH_PRIME_1 + HASH_PRIME_4;
+}
+
+static uint64_t hashReadWord(unsigned char const * const bytes) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof word);
+    return word;
+}
+
+static uint32_t hashReadHalfWord(unsigned char const * const bytes) {
+    uint32_t halfWord;
+    memcpy(&halfWord, bytes, sizeof halfWord);
+    return halfWord;
+}
@@ -4,3 +4,6 @@
 
 DEFINE_LIST(CharList, char)
 DEFINE_LIST(StringList, char *)
+DEFINE_LIST(Int64List, int64_t)
+DEFINE_LIST(Uint64List, uint64_t)
+DEFINE_LIST(SizeList, size_t)
@@ -6,7 +6,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 /**
  * Allocate memory of the given size using malloc. If the allocation fails, abort the program with an error message.
@@ -68,3 +72,104 @@ void *safeRealloc(void * const memory, size_t const newSize, char const * const
 
     return newMemory;
 }
+
+/**
+ * Allocate zero-initialized memory of the given size which remains shared with child processes created by fork. The
+ * memory is backed by a POSIX shared memory object (shm_open) that is unlinked immediately, so it disappears once every
+ * process has unmapped it. If the allocation fails, abort the program with an error message.
+ *
+ * @param size The size of the memory, in bytes.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The allocated memory. The caller is responsible for freeing this memory using safeSharedFree.
+ */
+void *safeSharedMalloc(size_t const size, char const * const callerDescription) {
+    guardNotNull(callerDescription, "callerDescription", "safeSharedMalloc");
+
+    static unsigned int sharedMemoryObjectCounter = 0;
+    char sharedMemoryObjectName[64];
+    snprintf(
+        sharedMemoryObjectName,
+        sizeof sharedMemoryObjectName,
+        "/hw8-%ld-%u",
+        (long)getpid(),
+        __atomic_fetch_add(&sharedMemoryObjectCounter, 1, __ATOMIC_RELAXED)
+    );
+
+    int const fd = shm_open(sharedMemoryObjectName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        int const shmOpenErrorCode = errno;
+        char const * const shmOpenErrorMessage = strerror(shmOpenErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to create shared memory object \"%s\" using shm_open (error code: %d; error message: \"%s\")",
+            callerDescription,
+            sharedMemoryObjectName,
+            shmOpenErrorCode,
+            shmOpenErrorMessage
+        );
+        return NULL;
+    }
+    shm_unlink(sharedMemoryObjectName);
+
+    if (ftruncate(fd, (off_t)size) == -1) {
+        int const ftruncateErrorCode = errno;
+        char const * const ftruncateErrorMessage = strerror(ftruncateErrorCode);
+        close(fd);
+
+        abortWithErrorFmt(
+            "%s: Failed to size shared memory to %zu bytes using ftruncate (error code: %d; error message: \"%s\")",
+            callerDescription,
+            size,
+            ftruncateErrorCode,
+            ftruncateErrorMessage
+        );
+        return NULL;
+    }
+
+    void * const memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int const mmapErrorCode = errno;
+    close(fd);
+    if (memory == MAP_FAILED) {
+        char const * const mmapErrorMessage = strerror(mmapErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to map %zu bytes of shared memory using mmap (error code: %d; error message: \"%s\")",
+            callerDescription,
+            size,
+            mmapErrorCode,
+            mmapErrorMessage
+        );
+        return NULL;
+    }
+
+    return memory;
+}
+
+/**
+ * Unmap memory allocated by safeSharedMalloc from the calling process. If the operation fails, abort the program with
+ * an error message.
+ *
+ * @param memory The shared memory.
+ * @param size The size of the memory, in bytes, as passed to safeSharedMalloc.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeSharedFree(void * const memory, size_t const size, char const * const callerDescription) {
+    guardNotNull(memory, "memory", "safeSharedFree");
+    guardNotNull(callerDescription, "callerDescription", "safeSharedFree");
+
+    if (munmap(memory, size) == -1) {
+        int const munmapErrorCode = errno;
+        char const * const munmapErrorMessage = strerror(munmapErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to unmap %zu bytes of shared memory using munmap (error code: %d; error message: \"%s\")",
+            callerDescription,
+            size,
+            munmapErrorCode,
+            munmapErrorMessage
+        );
+    }
+}
@@ -0,0 +1,77 @@
+#include "../../include/util/process.h"
+
+#include "../../include/util/guard.h"
+#include "../../include/util/error.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/**
+ * Create a child process using fork. Buffered standard output is flushed first so that it is not written twice. If the
+ * operation fails, abort the program with an error message.
+ *
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns 0 in the child process, or the child's process ID in the parent process.
+ */
+pid_t safeFork(char const * const callerDescription) {
+    guardNotNull(callerDescription, "callerDescription", "safeFork");
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t const processId = fork();
+    if (processId == -1) {
+        int const forkErrorCode = errno;
+        char const * const forkErrorMessage = strerror(forkErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to create child process using fork (error code: %d; error message: \"%s\")",
+            callerDescription,
+            forkErrorCode,
+            forkErrorMessage
+        );
+        return -1;
+    }
+
+    return processId;
+}
+
+/**
+ * Wait for the given child process to terminate. If the operation fails, abort the program with an error message.
+ *
+ * @param processId The child process ID.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The child's wait status (see waitpid).
+ */
+int safeWaitpid(pid_t const processId, char const * const callerDescription) {
+    guardNotNull(callerDescription, "callerDescription", "safeWaitpid");
+
+    int status;
+    while (waitpid(processId, &status, 0) == -1) {
+        if (errno == EINTR) {
+            continue;
+        }
+
+        int const waitpidErrorCode = errno;
+        char const * const waitpidErrorMessage = strerror(waitpidErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to wait for child process %ld using waitpid (error code: %d; error message: \"%s\")",
+            callerDescription,
+            (long)processId,
+            waitpidErrorCode,
+            waitpidErrorMessage
+        );
+        return -1;
+    }
+
+    return status;
+}
@@ -5,6 +5,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 static bool randomInitialized = false;
 
@@ -42,6 +43,73 @@ int randomInt(int const minInclusive, int const maxExclusive) {
     return rand() % (maxExclusive - minInclusive) + minInclusive;
 }
 
+/**
+ * Initialize a random stream. Streams created with the same seed but different stream indexes produce unrelated
+ * sequences.
+ *
+ * @param streamPtr The stream to initialize.
+ * @param seed The seed shared by a family of streams.
+ * @param streamIndex The index of this stream within the family.
+ */
+void initializeRandomStream(struct RandomStream * const streamPtr, uint64_t const seed, uint64_t const streamIndex) {
+    guardNotNull(streamPtr, "streamPtr", "initializeRandomStream");
+
+    // Scramble the stream index so that adjacent indexes do not start at adjacent points of the same sequence
+    streamPtr->state = seed;
+    streamPtr->state ^= randomStreamNext(&(struct RandomStream){.state = streamIndex * UINT64_C(0xD1B54A32D192ED03)});
+}
+
+/**
+ * Generate the next 64 random bits from the given stream (splitmix64).
+ *
+ * @param streamPtr The stream.
+ *
+ * @returns The random bits.
+ */
+uint64_t randomStreamNext(struct RandomStream * const streamPtr) {
+    guardNotNull(streamPtr, "streamPtr", "randomStreamNext");
+
+    streamPtr->state += UINT64_C(0x9E3779B97F4A7C15);
+    uint64_t z = streamPtr->state;
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/**
+ * Generate the next random integer from within the given range using the given stream.
+ *
+ * @param streamPtr The stream.
+ * @param minInclusive The inclusive lower bound of the random number returned.
+ * @param maxExclusive The exclusive upper bound of the random number returned. maxExclusive must be greater than
+ *                     minInclusive.
+ *
+ * @returns The random integer.
+ */
+int randomStreamInt(struct RandomStream * const streamPtr, int const minInclusive, int const maxExclusive) {
+    guardFmt(
+        maxExclusive > minInclusive,
+        "randomStreamInt: maxExclusive (%d) must be greater than minInclusive (%d)",
+        maxExclusive,
+        minInclusive
+    );
+
+    uint64_t const range = (uint64_t)((int64_t)maxExclusive - (int64_t)minInclusive);
+    return (int)((int64_t)minInclusive + (int64_t)(randomStreamNext(streamPtr) % range));
+}
+
+/**
+ * Generate the next random number from within [0, 1) using the given stream.
+ *
+ * @param streamPtr The stream.
+ *
+ * @returns The random number, a multiple of 2^-53.
+ */
+double randomStreamDouble(struct RandomStream * const streamPtr) {
+    // A double holds 53 significant bits, so only the top 53 random bits are kept
+    return (double)(randomStreamNext(streamPtr) >> 11) / (double)(UINT64_C(1) << 53);
+}
+
 static void ensureRandomInitialized(void) {
     if (randomInitialized) {
         return;
@@ -0,0 +1,82 @@
+#include "../../include/util/scan.h"
+
+#include "../../include/util/cpu.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_X86_64 1
+#else
+#define SCAN_X86_64 0
+#endif
+
+#if SCAN_X86_64
+static char const *findNewlineSse2(char const *chars, size_t length);
+static char const *findNewlineAvx2(char const *chars, size_t length);
+#endif
+static char const *findNewlineScalar(char const *chars, size_t length);
+
+/**
+ * Find the first newline in the given characters. On x86-64, 32 characters are compared at a time using AVX2 if the CPU
+ * supports it (see cpuSupportsAvx2), or 16 at a time using SSE2 otherwise; elsewhere, the characters are compared
+ * one at a time.
+ *
+ * @param chars The characters to search. They do not need to be null-terminated.
+ * @param length The number of characters to search.
+ *
+ * @returns A pointer to the first newline, or null if there is none.
+ */
+char const *findNewline(char const * const chars, size_t const length) {
+#if SCAN_X86_64
+    return cpuSupportsAvx2() ? findNewlineAvx2(chars, length) : findNewlineSse2(chars, length);
+#else
+    return findNewlineScalar(chars, length);
+#endif
+}
+
+#if SCAN_X86_64
+static char const *findNewlineSse2(char const * const chars, size_t const length) {
+    __m128i const newlines = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i const block = _mm_loadu_si128((__m128i const *)(void const *)(chars + i));
+        unsigned int const mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines));
+        if (mask != 0) {
+            return chars + i + (unsigned int)__builtin_ctz(mask);
+        }
+    }
+
+    return findNewlineScalar(chars + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static char const *findNewlineAvx2(char const * const chars, size_t const length) {
+    __m256i const newlines = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i const block = _mm256_loadu_si256((__m256i const *)(void const *)(chars + i));
+        unsigned int const mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines));
+        if (mask != 0) {
+            return chars + i + (unsigned int)__builtin_ctz(mask);
+        }
+    }
+
+    // The tail is shorter than one AVX2 block
+    return findNewlineSse2(chars + i, length - i);
+}
+#endif
+
+static char const *findNewlineScalar(char const * const chars, size_t const length) {
+    for (size_t i = 0; i < length; i += 1) {
+        if (chars[i] == '\n') {
+            return chars + i;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,121 @@
+#include "../../include/util/sum.h"
+
+#include "../../include/util/cpu.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SUM_X86_64 1
+#else
+#define SUM_X86_64 0
+#endif
+
+#if SUM_X86_64
+static uint64_t sumInt64sSse2(int64_t const *values, size_t count);
+static uint64_t sumInt64sAvx2(int64_t const *values, size_t count);
+#endif
+static uint64_t sumInt64sWrapping(int64_t const *values, size_t count);
+
+/**
+ * Sum the given integers, wrapping on overflow like sumValidCentsLines. On x86-64, 16 integers are added at a time in
+ * four AVX2 accumulators if the CPU supports it (see cpuSupportsAvx2), or 8 at a time in four SSE2 accumulators
+ * otherwise; elsewhere, they are added in four scalar accumulators.
+ *
+ * @param values The integers to sum.
+ * @param count The number of integers.
+ *
+ * @returns The sum.
+ */
+int64_t sumInt64s(int64_t const * const values, size_t const count) {
+#if SUM_X86_64
+    return (int64_t)(cpuSupportsAvx2() ? sumInt64sAvx2(values, count) : sumInt64sSse2(values, count));
+#else
+    return (int64_t)sumInt64sWrapping(values, count);
+#endif
+}
+
+/**
+ * Sum the given integers like sumInt64s, but without any SIMD instructions. This is the baseline sumInt64s is measured
+ * against.
+ *
+ * @param values The integers to sum.
+ * @param count The number of integers.
+ *
+ * @returns The sum.
+ */
+int64_t sumInt64sScalar(int64_t const * const values, size_t const count) {
+    return (int64_t)sumInt64sWrapping(values, count);
+}
+
+/**
+ * Get the name of the instruction set sumInt64s uses on this CPU.
+ *
+ * @returns "avx2", "sse2" or "scalar".
+ */
+char const *sumInt64sKernelName(void) {
+#if SUM_X86_64
+    return cpuSupportsAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+#if SUM_X86_64
+static uint64_t sumInt64sSse2(int64_t const * const values, size_t const count) {
+    __m128i sums[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 4; j += 1) {
+            __m128i const block = _mm_loadu_si128((__m128i const *)(void const *)(values + i + j * 2));
+            sums[j] = _mm_add_epi64(sums[j], block);
+        }
+    }
+
+    __m128i const sum = _mm_add_epi64(_mm_add_epi64(sums[0], sums[1]), _mm_add_epi64(sums[2], sums[3]));
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)(void *)lanes, sum);
+    return lanes[0] + lanes[1] + sumInt64sWrapping(values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sumInt64sAvx2(int64_t const * const values, size_t const count) {
+    __m256i sums[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        for (size_t j = 0; j < 4; j += 1) {
+            __m256i const block = _mm256_loadu_si256((__m256i const *)(void const *)(values + i + j * 4));
+            sums[j] = _mm256_add_epi64(sums[j], block);
+        }
+    }
+
+    __m256i const sum = _mm256_add_epi64(_mm256_add_epi64(sums[0], sums[1]), _mm256_add_epi64(sums[2], sums[3]));
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)(void *)lanes, sum);
+
+    // The tail is shorter than one AVX2 block
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumInt64sSse2(values + i, count - i);
+}
+#endif
+
+static uint64_t sumInt64sWrapping(int64_t const * const values, size_t const count) {
+    // Unsigned, so that overflow wraps instead of being undefined
+    uint64_t sums[4] = {0, 0, 0, 0};
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sums[0] += (uint64_t)values[i];
+        sums[1] += (uint64_t)values[i + 1];
+        sums[2] += (uint64_t)values[i + 2];
+        sums[3] += (uint64_t)values[i + 3];
+    }
+    for (; i < count; i += 1) {
+        sums[0] += (uint64_t)values[i];
+    }
+
+    return sums[0] + sums[1] + sums[2] + sums[3];
+}
@@ -3,7 +3,10 @@
 #include "../include/util/guard.h"
 #include "../include/util/error.h"
 
+#include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
 
 /**
@@ -102,6 +105,42 @@ void safeMutexInit(
     }
 }
 
+/**
+ * Initialize the given mutex memory as a robust mutex which can be shared between processes. The memory must itself be
+ * shared between the processes (e.g. allocated by safeSharedMalloc). If the operation fails, abort the program with an
+ * error message.
+ *
+ * @param mutexOutPtr A pointer to the shared memory where the mutex should be initialized.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeProcessSharedMutexInit(pthread_mutex_t * const mutexOutPtr, char const * const callerDescription) {
+    guardNotNull(mutexOutPtr, "mutexOutPtr", "safeProcessSharedMutexInit");
+    guardNotNull(callerDescription, "callerDescription", "safeProcessSharedMutexInit");
+
+    pthread_mutexattr_t attributes;
+    int mutexAttrErrorCode = pthread_mutexattr_init(&attributes);
+    if (mutexAttrErrorCode == 0) {
+        mutexAttrErrorCode = pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    }
+    if (mutexAttrErrorCode == 0) {
+        mutexAttrErrorCode = pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    }
+    if (mutexAttrErrorCode != 0) {
+        char const * const mutexAttrErrorMessage = strerror(mutexAttrErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to create process-shared robust mutex attributes (error code: %d; error message: \"%s\")",
+            callerDescription,
+            mutexAttrErrorCode,
+            mutexAttrErrorMessage
+        );
+    }
+
+    safeMutexInit(mutexOutPtr, &attributes, callerDescription);
+    pthread_mutexattr_destroy(&attributes);
+}
+
 /**
  * Lock the given mutex. If the operation fails, abort the program with an error message.
  *
@@ -126,6 +165,71 @@ void safeMutexLock(pthread_mutex_t * const mutexPtr, char const * const callerDe
     }
 }
 
+/**
+ * Try to lock the given mutex without waiting. If the operation fails for any reason other than the mutex already being
+ * locked, abort the program with an error message.
+ *
+ * @param mutexPtr A pointer to the mutex.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns Whether the mutex was locked. If false, it was already locked.
+ */
+bool safeMutexTryLock(pthread_mutex_t * const mutexPtr, char const * const callerDescription) {
+    guardNotNull(mutexPtr, "mutexPtr", "safeMutexTryLock");
+    guardNotNull(callerDescription, "callerDescription", "safeMutexTryLock");
+
+    int const mutexTryLockErrorCode = pthread_mutex_trylock(mutexPtr);
+    if (mutexTryLockErrorCode == EBUSY) {
+        return false;
+    }
+    if (mutexTryLockErrorCode != 0) {
+        char const * const mutexTryLockErrorMessage = strerror(mutexTryLockErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to lock mutex using pthread_mutex_trylock (error code: %d; error message: \"%s\")",
+            callerDescription,
+            mutexTryLockErrorCode,
+            mutexTryLockErrorMessage
+        );
+    }
+    return true;
+}
+
+/**
+ * Lock the given robust mutex. If the previous owner died while holding the mutex, the mutex is marked consistent
+ * again and the caller is told so that it can decide whether the protected state is usable. If the operation fails,
+ * abort the program with an error message.
+ *
+ * @param mutexPtr A pointer to the mutex.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns Whether the previous owner died while holding the mutex.
+ */
+bool safeRobustMutexLock(pthread_mutex_t * const mutexPtr, char const * const callerDescription) {
+    guardNotNull(mutexPtr, "mutexPtr", "safeRobustMutexLock");
+    guardNotNull(callerDescription, "callerDescription", "safeRobustMutexLock");
+
+    int const mutexLockErrorCode = pthread_mutex_lock(mutexPtr);
+    if (mutexLockErrorCode == EOWNERDEAD) {
+        pthread_mutex_consistent(mutexPtr);
+        return true;
+    }
+    if (mutexLockErrorCode != 0) {
+        char const * const mutexLockErrorMessage = strerror(mutexLockErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to lock robust mutex using pthread_mutex_lock (error code: %d; error message: \"%s\")",
+            callerDescription,
+            mutexLockErrorCode,
+            mutexLockErrorMessage
+        );
+    }
+
+    return false;
+}
+
 /**
  * Unlock the given mutex. If the operation fails, abort the program with an error message.
  *
@@ -227,6 +331,31 @@ void safeConditionSignal(pthread_cond_t * const conditionPtr, char const * const
     }
 }
 
+/**
+ * Broadcast the given condition, waking every waiting thread. If the operation fails, abort the program with an error
+ * message.
+ *
+ * @param conditionPtr A pointer to the condition.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ */
+void safeConditionBroadcast(pthread_cond_t * const conditionPtr, char const * const callerDescription) {
+    guardNotNull(conditionPtr, "conditionPtr", "safeConditionBroadcast");
+    guardNotNull(callerDescription, "callerDescription", "safeConditionBroadcast");
+
+    int const condBroadcastErrorCode = pthread_cond_broadcast(conditionPtr);
+    if (condBroadcastErrorCode != 0) {
+        char const * const condBroadcastErrorMessage = strerror(condBroadcastErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to broadcast condition using pthread_cond_broadcast (error code: %d; error message: \"%s\")",
+            callerDescription,
+            condBroadcastErrorCode,
+            condBroadcastErrorMessage
+        );
+    }
+}
+
 /**
  * Wait for the given condition. If the operation fails, abort the program with an error message.
  *
@@ -257,6 +386,48 @@ void safeConditionWait(
     }
 }
 
+/**
+ * Wait for the given condition until the given absolute time. If the operation fails, abort the program with an error
+ * message.
+ *
+ * @param conditionPtr A pointer to the condition.
+ * @param mutexPtr A pointer to the mutex. The mutex must be locked.
+ * @param absoluteTimeoutPtr A pointer to the absolute time (CLOCK_REALTIME) at which to stop waiting.
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns Whether the condition was signaled before the timeout.
+ */
+bool safeConditionTimedWait(
+    pthread_cond_t * const conditionPtr,
+    pthread_mutex_t * const mutexPtr,
+    struct timespec const * const absoluteTimeoutPtr,
+    char const * const callerDescription
+) {
+    guardNotNull(conditionPtr, "conditionPtr", "safeConditionTimedWait");
+    guardNotNull(mutexPtr, "mutexPtr", "safeConditionTimedWait");
+    guardNotNull(absoluteTimeoutPtr, "absoluteTimeoutPtr", "safeConditionTimedWait");
+    guardNotNull(callerDescription, "callerDescription", "safeConditionTimedWait");
+
+    int const condTimedWaitErrorCode = pthread_cond_timedwait(conditionPtr, mutexPtr, absoluteTimeoutPtr);
+    if (condTimedWaitErrorCode == ETIMEDOUT) {
+        return false;
+    }
+    if (condTimedWaitErrorCode != 0) {
+        char const * const condTimedWaitErrorMessage = strerror(condTimedWaitErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to wait for condition using pthread_cond_timedwait (error code: %d; error message: \"%s\")",
+            callerDescription,
+            condTimedWaitErrorCode,
+            condTimedWaitErrorMessage
+        );
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * Destroy the given condition. If the operation fails, abort the program with an error message.
  *
@@ -2,6 +2,7 @@
 
 #include "../include/util/error.h"
 
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
@@ -31,3 +32,30 @@ time_t safeTime(char const * const callerDescription) {
 
     return timeResult;
 }
+
+/**
+ * Get the current time of the monotonic clock, in nanoseconds. This is suitable for measuring elapsed time. If the
+ * operation fails, abort the program with an error message.
+ *
+ * @param callerDescription A description of the caller to be included in the error message. This could be the name of
+ *                          the calling function, plus extra information if useful.
+ *
+ * @returns The current monotonic time, in nanoseconds since an unspecified starting point.
+ */
+uint64_t safeMonotonicTimeNs(char const * const callerDescription) {
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+        int const clockGettimeErrorCode = errno;
+        char const * const clockGettimeErrorMessage = strerror(clockGettimeErrorCode);
+
+        abortWithErrorFmt(
+            "%s: Failed to get monotonic time using clock_gettime (error code: %d; error message: \"%s\")",
+            callerDescription,
+            clockGettimeErrorCode,
+            clockGettimeErrorMessage
+        );
+        return 0;
+    }
+
+    return (uint64_t)now.tv_sec * 1000 * 1000 * 1000 + (uint64_t)now.tv_nsec;
+}